@@ -131,18 +131,18 @@ interpolate_sample(Sample *sample, f32 dt)
 }
 
 internal void
-eval_node(Animation *anim, f32 dt, Node *node)
+eval_node(Animation *anim, f32 dt, Node *node, m4x4 *pose)
 {
     Node_Hash_Result hash_result = get_sample_index(anim, node->id);
     if (hash_result.found)
     {
         Sample *sample = (anim->samples + hash_result.idx);
         TRS trs = interpolate_sample(sample, dt);
-        node->current_transform = trs_to_transform(trs.translation, trs.rotation, trs.scaling);
+        pose[node->id] = trs_to_transform(trs.translation, trs.rotation, trs.scaling);
     }
     else
     {
-        node->current_transform = node->base_transform;
+        pose[node->id] = node->base_transform;
     }
 }
 
@@ -159,8 +159,10 @@ struct Eval_Stack
     Eval_Stack_Frame frames[256];
     u32 top;
 };
+// pose holds each node's transform in its parent's bone-space. With
+// do_eval_node it is sampled from anim first, otherwise it's used as it is.
 internal void
-eval(Model *model, Animation *anim, f32 dt, m4x4 *final_transforms, b32 do_eval_node)
+eval(Model *model, Animation *anim, f32 dt, m4x4 *pose, m4x4 *final_transforms, b32 do_eval_node)
 {
     Eval_Stack stack = {};
 
@@ -182,9 +184,9 @@ eval(Model *model, Animation *anim, f32 dt, m4x4 *final_transforms, b32 do_eval_
         {
             if (!frame->global_transform_done)
             {
-                if (do_eval_node) eval_node(anim, dt, node);
+                if (do_eval_node) eval_node(anim, dt, node, pose);
                 m4x4 parent_transform = (stack.top != 0) ? stack.frames[stack.top - 1].global_transform : identity();
-                m4x4 global_transform = parent_transform * node->current_transform;
+                m4x4 global_transform = parent_transform * pose[node->id];
                 m4x4 final_transform = global_transform * node->offset;
 
                 frame->global_transform = global_transform;
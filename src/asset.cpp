@@ -10,21 +10,141 @@
 #define READ(to, type)\
     to = *(type *)at; \
     at += sizeof(to);
+// NOTE: arrays are pointed at right where they are in the file, so the file
+// contents have to live as long as the asset does. Only a misaligned one gets
+// copied out.
 #define READ_COUNT(to, type, count) \
-    to = push_array(arena, type, count); \
-    copy(to, at, sizeof(type)*count); \
+    if (((size_t)at & (alignof(type) - 1)) == 0) \
+    { \
+        to = (type *)at; \
+    } \
+    else \
+    { \
+        to = push_array(arena, type, count); \
+        copy(to, at, sizeof(type)*count); \
+    } \
     at += (sizeof(type)*count);
 
+//
+// Async reads
+//
+struct Asset_File
+{
+    const char      *file_name;
+    Entire_File     contents;
+};
+
+// NOTE: every file is opened and its read issued before any is waited on,
+// so they are all in flight at once. The contents go into the arena and
+// stay there; fonts and bitmaps point into them. A file that can't be read
+// comes back with no contents.
+// NOTE: writes a byte to every page the read will land in, before the read.
+// While loop snapshots write-protect game memory, the fault handler only sees
+// writes from our own code; the kernel writing into a page that's still
+// protected fails the read with EFAULT instead.
+#define ASSET_READ_TOUCH_STRIDE     KB(4)
+
+inline void
+touch_pages_for_read(void *dest, u64 size)
+{
+    volatile u8 *at = (volatile u8 *)dest;
+    for (u64 offset = 0;
+         offset < size;
+         offset += ASSET_READ_TOUCH_STRIDE)
+    {
+        at[offset] = 0;
+    }
+    if (size)
+    {
+        at[size - 1] = 0;
+    }
+}
+
+internal void
+read_asset_files(Platform_API *platform, Memory_Arena *arena, Asset_File *files, u32 file_count)
+{
+    TIMED_FUNCTION();
+
+    if (!platform->platform_open_file)
+    {
+        // NOTE: a platform without async reads, e.g. bench.
+        for (u32 file_idx = 0;
+             file_idx < file_count;
+             ++file_idx)
+        {
+            files[file_idx].contents = platform->debug_platform_read_file((char *)files[file_idx].file_name);
+        }
+        return;
+    }
+
+    Platform_File_Handle handles[64];
+    Assert(file_count <= array_count(handles));
+
+    Platform_Job_Counter counter = {};
+    for (u32 file_idx = 0;
+         file_idx < file_count;
+         ++file_idx)
+    {
+        Asset_File *file = files + file_idx;
+        Platform_File_Handle *handle = handles + file_idx;
+        *handle = platform->platform_open_file(file->file_name);
+        file->contents = {};
+        if (handle->no_errors)
+        {
+            Assert(handle->size <= 0xffffffff);
+            file->contents.content_size = (u32)handle->size;
+            file->contents.contents     = push_size(arena, handle->size, ARENA_CACHE_LINE);
+            touch_pages_for_read(file->contents.contents, handle->size);
+            platform->platform_read_file(handle, 0, handle->size, file->contents.contents, &counter);
+        }
+    }
+
+    platform->platform_wait_for_counter(&counter);
+
+    for (u32 file_idx = 0;
+         file_idx < file_count;
+         ++file_idx)
+    {
+        Platform_File_Handle *handle = handles + file_idx;
+        if (!handle->no_errors)
+        {
+            files[file_idx].contents = {};
+        }
+        platform->platform_close_file(handle);
+    }
+}
+
+// NOTE: no copies at all. The loaders parse the mapped files in place and
+// point into them, so they stay mapped for good. Platforms without mapping
+// get read_asset_files.
+internal void
+map_asset_files(Platform_API *platform, Memory_Arena *arena, Asset_File *files, u32 file_count)
+{
+    TIMED_FUNCTION();
+
+    if (!platform->platform_map_file)
+    {
+        read_asset_files(platform, arena, files, file_count);
+        return;
+    }
+
+    for (u32 file_idx = 0;
+         file_idx < file_count;
+         ++file_idx)
+    {
+        files[file_idx].contents = platform->platform_map_file(files[file_idx].file_name);
+    }
+}
+
 //
 // In order to achieve animation hot-reloading, we need to pass the pointer of
 // the asset, not returning it.
 //
 internal void
-load_model(Model *model, char *file_name, Memory_Arena *arena, Read_Entire_File *read_entire_file)
+load_model(Model *model, Entire_File entire_file, Memory_Arena *arena)
 {
     Assert(model);
 
-    Entire_File entire_file = read_entire_file(file_name);
     Assert(entire_file.content_size);
     u8 *at  = (u8 *)entire_file.contents;
     u8 *end = at + entire_file.content_size;
@@ -38,21 +158,13 @@ load_model(Model *model, char *file_name, Memory_Arena *arena, Read_Entire_File
     {
         Mesh *mesh = model->meshes + mesh_idx;
 
+        // NOTE: a vertex is written field by field with no padding, which is
+        // exactly how Vertex is laid out.
+        static_assert(sizeof(Vertex) == (sizeof(v3) * 2 + sizeof(v2) + sizeof(v4) +
+                                         MAX_BONE_PER_VERTEX * (sizeof(s32) + sizeof(f32))),
+                      "Vertex doesn't match the .smsh vertex layout");
         READ(mesh->vertex_count, u32);
-        mesh->vertices = push_array(arena, Vertex, mesh->vertex_count);
-        for (u32 vertex_idx = 0;
-             vertex_idx < mesh->vertex_count;
-             ++vertex_idx)
-        {
-            Vertex *vertex = mesh->vertices + vertex_idx;
-            READ(vertex->pos, v3);
-            READ(vertex->normal, v3);
-            READ(vertex->uv, v2);
-            READ(vertex->color, v4);
-
-            for (u32 i = 0; i < MAX_BONE_PER_VERTEX; ++i) { READ(vertex->node_ids[i], s32); }
-            for (u32 i = 0; i < MAX_BONE_PER_VERTEX; ++i) { READ(vertex->node_weights[i], f32); }
-        }
+        READ_COUNT(mesh->vertices, Vertex, mesh->vertex_count);
 
         READ(mesh->index_count, u32);
         READ_COUNT(mesh->indices, u32, mesh->index_count);
@@ -92,6 +204,12 @@ load_model(Model *model, char *file_name, Memory_Arena *arena, Read_Entire_File
     Assert(at == end);
 }
 
+internal void
+load_model(Model *model, char *file_name, Memory_Arena *arena, Read_Entire_File *read_entire_file)
+{
+    load_model(model, read_entire_file(file_name), arena);
+}
+
 internal u32
 animation_hash(u32 id, u32 length)
 {
@@ -100,12 +218,10 @@ animation_hash(u32 id, u32 length)
     return slot;
 }
 internal void
-load_animation(Animation *anim, char *file_name, Memory_Arena *arena,
-               Read_Entire_File *read_entire_file)
+load_animation(Animation *anim, Entire_File entire_file, Memory_Arena *arena)
 {
     Assert(anim);
 
-    Entire_File entire_file = read_entire_file(file_name);
     Assert(entire_file.content_size);
     u8 *at  = (u8 *)entire_file.contents;
     u8 *end = at + entire_file.content_size;
@@ -141,6 +257,8 @@ load_animation(Animation *anim, char *file_name, Memory_Arena *arena,
     Animation_Hash_Table *ht = &anim->hash_table;
     ht->entry_count = anim->sample_count;
     ht->entries = push_array(arena, Animation_Hash_Entry, ht->entry_count);
+    // NOTE: the arena may be a cached asset's, on blocks some other asset had.
+    zero_array(ht->entry_count, ht->entries);
     for (u32 sample_idx = 0;
          sample_idx < anim->sample_count;
          ++sample_idx)
@@ -172,6 +290,13 @@ load_animation(Animation *anim, char *file_name, Memory_Arena *arena,
         }
     }
 }
+
+internal void
+load_animation(Animation *anim, char *file_name, Memory_Arena *arena,
+               Read_Entire_File *read_entire_file)
+{
+    load_animation(anim, read_entire_file(file_name), arena);
+}
 #undef READ
 #undef READ_COUNT
 
@@ -179,9 +304,8 @@ load_animation(Animation *anim, char *file_name, Memory_Arena *arena,
 // Font
 //
 internal void
-load_font(Memory_Arena *arena, Read_Entire_File *read_file, char *file_name, Font *font)
+load_font(Memory_Arena *arena, Entire_File read, Font *font)
 {
-    Entire_File read = read_file(file_name);
     u8 *at = (u8 *)read.contents;
     u8 *end = at + read.content_size;
 
@@ -225,15 +349,84 @@ load_font(Memory_Arena *arena, Read_Entire_File *read_file, char *file_name, Fon
     }
 }
 
+internal void
+load_font(Memory_Arena *arena, Read_Entire_File *read_file, char *file_name, Font *font)
+{
+    load_font(arena, read_file(file_name), font);
+}
+
+#if 1
+struct Convert_BMP_Data
+{
+    u32 *pixels;
+    s32 width;
+
+    u32 r_mask;
+    u32 g_mask;
+    u32 b_mask;
+    u32 a_mask;
+
+    s32 r_shift;
+    s32 g_shift;
+    s32 b_shift;
+    s32 a_shift;
+};
+
+// rows [first, one_past_last), in place.
+PARALLEL_FOR_CALLBACK(convert_bmp_rows)
+{
+    Convert_BMP_Data *convert = (Convert_BMP_Data *)data;
+
+    u32 r_mask = convert->r_mask;
+    u32 g_mask = convert->g_mask;
+    u32 b_mask = convert->b_mask;
+    u32 a_mask = convert->a_mask;
+
+    s32 r_shift = convert->r_shift;
+    s32 g_shift = convert->g_shift;
+    s32 b_shift = convert->b_shift;
+    s32 a_shift = convert->a_shift;
+
+    f32 inv_255f = 1.0f / 255.0f;
+    
+    u32 *at = convert->pixels + (size_t)first * convert->width;
+    for(u32 y = first;
+        y < one_past_last;
+        ++y)
+    {
+        for(s32 x = 0;
+            x < convert->width;
+            ++x)
+        {
+            u32 c = *at;
+
+            f32 r = (f32)((c & r_mask) >> r_shift);
+            f32 g = (f32)((c & g_mask) >> g_shift);
+            f32 b = (f32)((c & b_mask) >> b_shift);
+            f32 a = (f32)((c & a_mask) >> a_shift);
+
+            f32 ra = a * inv_255f;
 #if 1
+            r *= ra;
+            g *= ra;
+            b *= ra;
+#endif
+
+            *at++ = (((u32)(a + 0.5f) << 24) |
+                     ((u32)(r + 0.5f) << 16) |
+                     ((u32)(g + 0.5f) <<  8) |
+                     ((u32)(b + 0.5f) <<  0));
+        }
+    }
+}
+
 // IMPORTANT: bitmap->memory starts with lowest scanline of the image.
 internal Bitmap *
-load_bmp(Memory_Arena *arena, Read_Entire_File *read_file, const char *filename)
+load_bmp(Memory_Arena *arena, Entire_File read, Parallel_Context *parallel = 0)
 {
     Bitmap *result = push_struct(arena, Bitmap);
     *result = {};
     
-    Entire_File read = read_file(filename);
     if (read.content_size != 0) 
     {
         BMP_Info_Header *header = (BMP_Info_Header *)read.contents;
@@ -248,132 +441,276 @@ load_bmp(Memory_Arena *arena, Read_Entire_File *read_file, const char *filename)
 
         Assert(header->compression == 3);
 
-        u32 r_mask = header->r_mask;
-        u32 g_mask = header->g_mask;
-        u32 b_mask = header->b_mask;
-        u32 a_mask = ~(r_mask | g_mask | b_mask);        
+        Convert_BMP_Data convert = {};
+        convert.pixels  = pixels;
+        convert.width   = header->width;
+        convert.r_mask  = header->r_mask;
+        convert.g_mask  = header->g_mask;
+        convert.b_mask  = header->b_mask;
+        convert.a_mask  = ~(convert.r_mask | convert.g_mask | convert.b_mask);        
         
-        Bit_Scan_Result r_scan = find_least_significant_set_bit(r_mask);
-        Bit_Scan_Result g_scan = find_least_significant_set_bit(g_mask);
-        Bit_Scan_Result b_scan = find_least_significant_set_bit(b_mask);
-        Bit_Scan_Result a_scan = find_least_significant_set_bit(a_mask);
+        Bit_Scan_Result r_scan = find_least_significant_set_bit(convert.r_mask);
+        Bit_Scan_Result g_scan = find_least_significant_set_bit(convert.g_mask);
+        Bit_Scan_Result b_scan = find_least_significant_set_bit(convert.b_mask);
+        Bit_Scan_Result a_scan = find_least_significant_set_bit(convert.a_mask);
         
         Assert(r_scan.found);
         Assert(g_scan.found);   
         Assert(b_scan.found);
         Assert(a_scan.found);
 
-        s32 r_shift = (s32)r_scan.index;
-        s32 g_shift = (s32)g_scan.index;
-        s32 b_shift = (s32)b_scan.index;
-        s32 a_shift = (s32)a_scan.index;
+        convert.r_shift = (s32)r_scan.index;
+        convert.g_shift = (s32)g_scan.index;
+        convert.b_shift = (s32)b_scan.index;
+        convert.a_shift = (s32)a_scan.index;
 
-        f32 inv_255f = 1.0f / 255.0f;
-        
-        u32 *at = pixels;
-        for(s32 y = 0;
-            y < header->height;
-            ++y)
-        {
-            for(s32 x = 0;
-                x < header->width;
-                ++x)
-            {
-                u32 c = *at;
+        parallel_for(parallel, 0, (u32)maximum(header->height, 0), 0, convert_bmp_rows, &convert);
 
-                f32 r = (f32)((c & r_mask) >> r_shift);
-                f32 g = (f32)((c & g_mask) >> g_shift);
-                f32 b = (f32)((c & b_mask) >> b_shift);
-                f32 a = (f32)((c & a_mask) >> a_shift);
+        result->memory = pixels;
+    }
 
-                f32 ra = a * inv_255f;
-#if 1
-                r *= ra;
-                g *= ra;
-                b *= ra;
+
+    return result;
+}
+
+internal Bitmap *
+load_bmp(Memory_Arena *arena, Read_Entire_File *read_file, const char *filename,
+         Parallel_Context *parallel = 0)
+{
+    Bitmap *result = load_bmp(arena, read_file(filename), parallel);
+    return result;
+}
 #endif
 
-                *at++ = (((u32)(a + 0.5f) << 24) |
-                         ((u32)(r + 0.5f) << 16) |
-                         ((u32)(g + 0.5f) <<  8) |
-                         ((u32)(b + 0.5f) <<  0));
+//
+// Asset cache
+//
+// Models and animations are loaded when they're first used, and evicted
+// least recently used first when the cache is over its budget. Each slot
+// reads its file into its own arena rather than mapping it, so that an
+// eviction gives the memory back to the cache, and loop snapshots of
+// transient memory have all of it.
+//
+#define ASSET_CACHE_MIN_BLOCK_SIZE  KB(64)
+
+global_var const char *g_cached_asset_file_names[eCached_Asset_Count] =
+{
+    "mesh/xbot.smsh",
+    "mesh/cube.smsh",
+    "mesh/octahedral.smsh",
+    "mesh/sphere.smsh",
+    "mesh/grass.smsh",
+    "mesh/red_wall.smsh",
+    "mesh/green_wall.smsh",
+
+    "animation/xbot_idle.sanm",
+    "animation/xbot_run.sanm",
+};
+
+inline b32
+is_animation(Cached_Asset id)
+{
+    b32 result = (id >= eCached_Asset_Xbot_Idle);
+    return result;
+}
+
+internal void
+init_asset_cache(Asset_Cache *cache, Platform_API *platform, Memory_Block_Source *source,
+                 size_t budget)
+{
+    *cache = {};
+    cache->platform = platform;
+    cache->budget   = budget;
+    for (u32 slot_idx = 0;
+         slot_idx < eCached_Asset_Count;
+         ++slot_idx)
+    {
+        Asset_Slot *slot = cache->slots + slot_idx;
+        init_growable_arena(&slot->arena, source, ASSET_CACHE_MIN_BLOCK_SIZE);
+        slot->arena.tag = eArena_Tag_Asset;
+    }
+}
+
+// NOTE: every block of the slot goes on the cache's free list.
+internal void
+release_asset_slot(Asset_Cache *cache, Asset_Slot *slot)
+{
+    Memory_Arena *arena = &slot->arena;
+    arena->first_free_block = cache->first_free_block;
+    while (arena->block)
+    {
+        arena_pop_block(arena);
+    }
+    cache->first_free_block = arena->first_free_block;
+    arena->first_free_block = 0;
+
+    cache->used -= slot->size;
+    slot->size = 0;
+    slot->model = {};
+    slot->animation = {};
+}
+
+// NOTE: what game_update did to these right after loading them, done again
+// on every reload.
+internal void
+fix_up_cached_asset(Game_Assets *assets, Cached_Asset id, Asset_Slot *slot)
+{
+    switch (id)
+    {
+        case eCached_Asset_Xbot_Model:
+        {
+            f32 xbot_scale = 0.01f;
+            Node *root = slot->model.nodes;
+            root->base_transform = scale(root->base_transform, xbot_scale * v3{1, 1, 1});
+        } break;
+
+        case eCached_Asset_Grass_Model:
+        {
+            Mesh *mesh = slot->model.meshes;
+            assets->grass_max_vertex_y = 0.0f;
+            for (u32 vertex_idx = 0;
+                 vertex_idx < mesh->vertex_count;
+                 ++vertex_idx)
+            {
+                assets->grass_max_vertex_y = maximum(assets->grass_max_vertex_y, mesh->vertices[vertex_idx].pos.y);
             }
+        } break;
+
+        case eCached_Asset_Red_Wall_Model:
+        {
+            slot->model.materials->color_diffuse = v3{1, 0, 0};
+        } break;
+
+        case eCached_Asset_Green_Wall_Model:
+        {
+            slot->model.materials->color_diffuse = v3{0, 1, 0};
+        } break;
+
+        default:
+        {
+        } break;
+    }
+}
+
+internal void
+load_cached_asset(Game_Assets *assets, Cached_Asset id)
+{
+    TIMED_FUNCTION();
+
+    Asset_Cache *cache = &assets->cache;
+    Asset_Slot *slot = cache->slots + id;
+    Assert(slot->state == Asset_State_Unloaded);
+
+    // NOTE: the cache's free blocks are lent to the slot while it loads.
+    Memory_Arena *arena = &slot->arena;
+    arena->first_free_block = cache->first_free_block;
+
+    Asset_File file = {};
+    file.file_name = g_cached_asset_file_names[id];
+    read_asset_files(cache->platform, arena, &file, 1);
+    if (file.contents.content_size)
+    {
+        if (is_animation(id))
+        {
+            load_animation(&slot->animation, file.contents, arena);
         }
-        result->memory = pixels;
+        else
+        {
+            load_model(&slot->model, file.contents, arena);
+        }
+        fix_up_cached_asset(assets, id, slot);
+
+        slot->state = Asset_State_Loaded;
+        slot->size  = arena->chained_used + arena->used;
+        cache->used += slot->size;
+    }
+
+    cache->first_free_block = arena->first_free_block;
+    arena->first_free_block = 0;
+
+    // NOTE: tried again on the next miss, the read may only have failed
+    // this once.
+    if (slot->state != Asset_State_Loaded)
+    {
+        release_asset_slot(cache, slot);
+        slot->state = Asset_State_Unloaded;
+        ++cache->failed_load_count;
     }
+}
 
+// NOTE: main thread only, a miss loads the asset there and then. Stamps the
+// slot as used this frame. 0 if it can't be read.
+internal Asset_Slot *
+acquire_cached_asset(Game_Assets *assets, Cached_Asset id)
+{
+    Asset_Cache *cache = &assets->cache;
+    Asset_Slot *slot = cache->slots + id;
+    slot->last_used_frame = cache->frame_idx;
+    if (slot->state == Asset_State_Loaded)
+    {
+        ++cache->hit_count;
+    }
+    else if (slot->state == Asset_State_Unloaded)
+    {
+        ++cache->miss_count;
+        load_cached_asset(assets, id);
+    }
 
+    Asset_Slot *result = (slot->state == Asset_State_Loaded) ? slot : 0;
     return result;
 }
-#endif
 
+inline Model *
+get_model(Game_Assets *assets, Cached_Asset id)
+{
+    Assert(!is_animation(id));
+    Asset_Slot *slot = acquire_cached_asset(assets, id);
+    Model *result = slot ? &slot->model : 0;
+    return result;
+}
 
-#if 0
-PLATFORM_WORK_QUEUE_CALLBACK(load_asset_work)
+inline Animation *
+get_animation(Game_Assets *assets, Cached_Asset id)
 {
-    Load_Asset_Work_Data *workData = (Load_Asset_Work_Data *)data;
-    workData->game_assets->bitmaps[workData->assetID] = load_bmp(workData->assetArena, workData->game_assets->read_entire_file, workData->fileName);
-    workData->game_assets->bitmapStates[workData->assetID] = Asset_State_Loaded;
-    end_work_memory(workData->workSlot);
+    Assert(is_animation(id));
+    Asset_Slot *slot = acquire_cached_asset(assets, id);
+    Animation *result = slot ? &slot->animation : 0;
+    return result;
 }
-#endif
 
-#if 0
-internal Bitmap *
-GetBitmap(Transient_State *trans_state, Asset_ID assetID,
-          PlatformWorkQueue *queue, Platform_API *platform)
+// NOTE: evicts the least recently used until the cache is under budget.
+// What was used in the last RENDER_MAX_FRAMES_IN_FLIGHT frames may still be
+// read by the render thread, so it stays, over budget or not.
+internal void
+end_asset_cache_frame(Asset_Cache *cache, size_t budget)
 {
-    Bitmap *result = trans_state->game_assets.bitmaps[assetID];
+    TIMED_FUNCTION();
 
-    if (!result) 
+    cache->budget = budget;
+    while (cache->used > cache->budget)
     {
-        if (atomic_compare_exchange_u32((u32 *)&trans_state->game_assets.bitmapStates[assetID],
-                                        Asset_State_Queued, Asset_State_Unloaded)) 
+        Asset_Slot *lru = 0;
+        for (u32 slot_idx = 0;
+             slot_idx < eCached_Asset_Count;
+             ++slot_idx)
         {
-            Work_Memory_Arena *workSlot = begin_work_memory(trans_state);
-            if (workSlot) 
-            {
-                Load_Asset_Work_Data *workData = push_struct(&workSlot->memoryArena, Load_Asset_Work_Data);
-                workData->game_assets = &trans_state->game_assets;
-                workData->assetArena = &trans_state->assetArena;
-                workData->assetID = assetID;
-                workData->workSlot = workSlot;
-
-                switch(assetID) 
-                {
-                    case GAI_Tree: 
-                    {
-                        workData->fileName = "tree2_teal.bmp";
-                    } break;
-
-                    case GAI_Particle: 
-                    {
-                        workData->fileName = "white_particle.bmp";
-                    } break;
-
-                    INVALID_DEFAULT_CASE
-                }
-#if 1 // multi-thread
-                platform->platform_add_entry(queue, load_asset_work, workData);
-                return 0; // todo: no bmp...?
-#else // single-thread
-                load_asset_work(queue, workData);
-                return 0; // todo: no bmp...?
-#endif
-            } 
-            else 
+            Asset_Slot *slot = cache->slots + slot_idx;
+            if (slot->state == Asset_State_Loaded &&
+                slot->last_used_frame + RENDER_MAX_FRAMES_IN_FLIGHT < cache->frame_idx &&
+                (!lru || slot->last_used_frame < lru->last_used_frame))
             {
-                return result;
+                lru = slot;
             }
-        } 
-        else 
+        }
+
+        if (!lru)
         {
-            return result;
+            break;
         }
-    } 
-    else 
-    {
-        return result;
+        release_asset_slot(cache, lru);
+        lru->state = Asset_State_Unloaded;
+        ++cache->eviction_count;
     }
+
+    ++cache->frame_idx;
 }
-#endif
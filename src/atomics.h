@@ -0,0 +1,197 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+
+/*
+ * Atomics with an explicit memory order, for MSVC and GCC/Clang.
+ *
+ * Orders mean what they mean in C11. The order defaults to seq_cst, so the
+ * old two/three argument calls behave as before; pass a weaker one where the
+ * code doesn't need the barrier.
+ *
+ * On x86 every locked read-modify-write is a full barrier whatever order it
+ * is given, so there a weaker order on one only lets the compiler move
+ * other accesses around it. Loads and stores do get cheaper: acquire loads
+ * and release stores are plain movs, only a seq_cst store needs an xchg.
+ */
+
+// NOTE: same values as the GCC __ATOMIC_* constants.
+enum Memory_Order
+{
+    eMemory_Order_Relaxed   = 0,
+    eMemory_Order_Acquire   = 2,
+    eMemory_Order_Release   = 3,
+    eMemory_Order_Acq_Rel   = 4,
+    eMemory_Order_Seq_Cst   = 5,
+};
+
+#if __MSVC
+  #define ATOMIC_COMPILER_BARRIER(order) if ((order) != eMemory_Order_Relaxed) { _ReadWriteBarrier(); }
+#else
+// a CAS that fails only loads, so it can't release.
+inline int
+atomic_failure_order(Memory_Order order)
+{
+    int result = ((order == eMemory_Order_Release) ? eMemory_Order_Relaxed :
+                  (order == eMemory_Order_Acq_Rel) ? eMemory_Order_Acquire : order);
+    return result;
+}
+#endif
+
+//
+// Load / Store
+//
+inline u32
+atomic_load_u32(u32 volatile *value, Memory_Order order = eMemory_Order_Seq_Cst)
+{
+#if __MSVC
+    u32 result = *value;
+    ATOMIC_COMPILER_BARRIER(order);
+#else
+    u32 result = __atomic_load_n(value, order);
+#endif
+    return result;
+}
+
+inline u64
+atomic_load_u64(u64 volatile *value, Memory_Order order = eMemory_Order_Seq_Cst)
+{
+#if __MSVC
+    u64 result = *value;
+    ATOMIC_COMPILER_BARRIER(order);
+#else
+    u64 result = __atomic_load_n(value, order);
+#endif
+    return result;
+}
+
+inline void
+atomic_store_u32(u32 volatile *value, u32 _new, Memory_Order order = eMemory_Order_Seq_Cst)
+{
+#if __MSVC
+    if (order == eMemory_Order_Seq_Cst)
+    {
+        _InterlockedExchange((long *)value, _new);
+    }
+    else
+    {
+        ATOMIC_COMPILER_BARRIER(order);
+        *value = _new;
+    }
+#else
+    __atomic_store_n(value, _new, order);
+#endif
+}
+
+inline void
+atomic_store_u64(u64 volatile *value, u64 _new, Memory_Order order = eMemory_Order_Seq_Cst)
+{
+#if __MSVC
+    if (order == eMemory_Order_Seq_Cst)
+    {
+        _InterlockedExchange64((long long *)value, _new);
+    }
+    else
+    {
+        ATOMIC_COMPILER_BARRIER(order);
+        *value = _new;
+    }
+#else
+    __atomic_store_n(value, _new, order);
+#endif
+}
+
+//
+// Read-Modify-Write. All of them return the value from before.
+//
+inline u32
+atomic_compare_exchange_u32(u32 volatile *value, u32 _new, u32 expected,
+                            Memory_Order order = eMemory_Order_Seq_Cst) 
+{
+#if __MSVC
+    u32 result = _InterlockedCompareExchange((long *)value, _new, expected);
+#else
+    u32 result = expected;
+    __atomic_compare_exchange_n(value, &result, _new, false, order, atomic_failure_order(order));
+#endif
+    return result;
+}
+
+inline u64
+atomic_compare_exchange_u64(u64 volatile *value, u64 _new, u64 expected,
+                            Memory_Order order = eMemory_Order_Seq_Cst) 
+{
+#if __MSVC
+    u64 result = _InterlockedCompareExchange64((long long *)value, _new, expected);
+#else
+    u64 result = expected;
+    __atomic_compare_exchange_n(value, &result, _new, false, order, atomic_failure_order(order));
+#endif
+    return result;
+}
+
+inline u32
+atomic_exchange_u32(u32 volatile *value, u32 _new, Memory_Order order = eMemory_Order_Seq_Cst) 
+{
+#if __MSVC
+    u32 result = _InterlockedExchange((long *)value, _new);
+#else
+    u32 result = __atomic_exchange_n(value, _new, order);
+#endif
+    return result;
+}
+
+inline u64
+atomic_exchange_u64(u64 volatile *value, u64 _new, Memory_Order order = eMemory_Order_Seq_Cst) 
+{
+#if __MSVC
+    u64 result = _InterlockedExchange64((long long *)value, _new);
+#else
+    u64 result = __atomic_exchange_n(value, _new, order);
+#endif
+    return result;
+}
+
+inline u32
+atomic_add_u32(u32 volatile *value, u32 addend, Memory_Order order = eMemory_Order_Seq_Cst) 
+{
+#if __MSVC
+    u32 result = _InterlockedExchangeAdd((long *)value, addend);
+#else
+    u32 result = __atomic_fetch_add(value, addend, order);
+#endif
+    return result;
+}
+
+inline u64
+atomic_add_u64(u64 volatile *value, u64 addend, Memory_Order order = eMemory_Order_Seq_Cst) 
+{
+#if __MSVC
+    u64 result = _InterlockedExchangeAdd64((long long *)value, addend);
+#else
+    u64 result = __atomic_fetch_add(value, addend, order);
+#endif
+    return result;
+}
+
+//
+// Fence
+//
+inline void
+atomic_fence(Memory_Order order = eMemory_Order_Seq_Cst)
+{
+#if __MSVC
+    ATOMIC_COMPILER_BARRIER(order);
+    if (order == eMemory_Order_Seq_Cst)
+    {
+        _mm_mfence();
+        _ReadWriteBarrier();
+    }
+#else
+    __atomic_thread_fence(order);
+#endif
+}
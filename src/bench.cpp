@@ -0,0 +1,2476 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+/*
+ * Micro-benchmarks for engine primitives, built by build.sh.
+ *
+ * usage: bench [name|all] [max_threads]
+ * With no name every benchmark runs. Thread counts go from 1 up to
+ * max_threads, which defaults to the number of online cores.
+ */
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+// NOTE: the whole game module, so that the kernels measured are the real ones.
+#include "game.cpp"
+
+#include "work_queue.cpp"
+#include "job_system.cpp"
+
+inline u64
+bench_get_wall_clock()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    u64 result = (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+    return result;
+}
+
+inline f64
+bench_get_seconds_elapsed(u64 begin, u64 end)
+{
+    f64 result = (f64)(end - begin) / 1000000000.0;
+    return result;
+}
+
+global_var u32 g_bench_max_threads;
+
+inline u32
+bench_get_core_count()
+{
+    u32 result = g_bench_max_threads;
+    if (!result)
+    {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        result = (count > 0) ? (u32)count : 1;
+    }
+    return result;
+}
+
+typedef void *Bench_Thread_Proc(void *);
+
+internal void
+bench_run_threads(u32 thread_count, Bench_Thread_Proc *proc, void *params, size_t param_size)
+{
+    pthread_t threads[256];
+    Assert(thread_count <= array_count(threads));
+    for (u32 idx = 0; idx < thread_count; ++idx)
+    {
+        pthread_create(threads + idx, 0, proc, (u8 *)params + idx * param_size);
+    }
+    for (u32 idx = 0; idx < thread_count; ++idx)
+    {
+        pthread_join(threads[idx], 0);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Work Queue
+//
+
+global_var u32 volatile g_bench_job_count;
+
+PLATFORM_WORK_QUEUE_CALLBACK(bench_nop_job)
+{
+}
+
+PLATFORM_WORK_QUEUE_CALLBACK(bench_leaf_job)
+{
+    atomic_add_u32(&g_bench_job_count, 1);
+}
+
+#define BENCH_SUB_JOB_COUNT 8
+
+// NOTE: runs on a worker, so the sub-jobs come from many producers at once.
+PLATFORM_WORK_QUEUE_CALLBACK(bench_spawn_job)
+{
+    atomic_add_u32(&g_bench_job_count, 1);
+    for (u32 idx = 0; idx < BENCH_SUB_JOB_COUNT; ++idx)
+    {
+        work_queue_add_entry(queue, bench_leaf_job, 0);
+    }
+}
+
+struct Bench_Queue_Params
+{
+    Platform_Work_Queue *queue;
+    u32                 iteration_count;
+};
+
+internal void *
+bench_queue_pair_proc(void *param)
+{
+    Bench_Queue_Params *params = (Bench_Queue_Params *)param;
+    Platform_Work_Queue_Entry entry;
+    for (u32 idx = 0; idx < params->iteration_count; ++idx)
+    {
+        while (!work_queue_try_add(params->queue, bench_nop_job, 0)) { _mm_pause(); }
+        while (!work_queue_try_take(params->queue, &entry)) { _mm_pause(); }
+    }
+    return 0;
+}
+
+internal void *
+bench_queue_worker_proc(void *param)
+{
+    work_queue_thread_loop((Platform_Work_Queue *)param);
+    return 0;
+}
+
+internal void
+bench_work_queue()
+{
+    u32 core_count = bench_get_core_count();
+
+    printf("work_queue: raw enqueue+dequeue pairs, every thread both produces and consumes\n");
+    printf("%8s %12s %14s\n", "threads", "seconds", "Mops/s");
+    for (u32 thread_count = 1;
+         thread_count <= core_count;
+         ++thread_count)
+    {
+        Platform_Work_Queue *queue = (Platform_Work_Queue *)aligned_alloc(64, sizeof(Platform_Work_Queue));
+        work_queue_init(queue, 0);
+
+        Bench_Queue_Params params[256];
+        u32 iteration_count = 1000000;
+        for (u32 idx = 0; idx < thread_count; ++idx)
+        {
+            params[idx].queue = queue;
+            params[idx].iteration_count = iteration_count;
+        }
+
+        u64 begin = bench_get_wall_clock();
+        bench_run_threads(thread_count, bench_queue_pair_proc, params, sizeof(params[0]));
+        f64 seconds = bench_get_seconds_elapsed(begin, bench_get_wall_clock());
+
+        f64 op_count = 2.0 * (f64)iteration_count * (f64)thread_count;
+        printf("%8u %12.4f %14.2f\n", thread_count, seconds, op_count / seconds / 1000000.0);
+        free(queue);
+    }
+
+    printf("\nwork_queue: jobs spawning %u sub-jobs each from workers, main thread helps in complete_all_work\n", BENCH_SUB_JOB_COUNT);
+    printf("%8s %12s %14s\n", "threads", "seconds", "Mjobs/s");
+    for (u32 thread_count = 1;
+         thread_count <= core_count;
+         ++thread_count)
+    {
+        // NOTE: the workers never exit; they just sleep once we move on.
+        Platform_Work_Queue *queue = (Platform_Work_Queue *)aligned_alloc(64, sizeof(Platform_Work_Queue));
+        work_queue_init(queue, thread_count - 1);
+        for (u32 idx = 0; idx < thread_count - 1; ++idx)
+        {
+            pthread_t thread;
+            pthread_create(&thread, 0, bench_queue_worker_proc, queue);
+            pthread_detach(thread);
+        }
+
+        u32 root_count = 100000;
+        g_bench_job_count = 0;
+
+        u64 begin = bench_get_wall_clock();
+        for (u32 idx = 0; idx < root_count; ++idx)
+        {
+            work_queue_add_entry(queue, bench_spawn_job, 0);
+        }
+        work_queue_complete_all_work(queue);
+        f64 seconds = bench_get_seconds_elapsed(begin, bench_get_wall_clock());
+
+        u32 expected = root_count * (BENCH_SUB_JOB_COUNT + 1);
+        Assert(g_bench_job_count == expected);
+        printf("%8u %12.4f %14.2f\n", thread_count, seconds, (f64)expected / seconds / 1000000.0);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Job System
+//
+
+#define BENCH_TREE_FAN_OUT  4
+#define BENCH_TREE_DEPTH    8
+
+struct Bench_Tree_Params
+{
+    u32     depth;
+};
+
+global_var Bench_Tree_Params g_bench_tree_params[BENCH_TREE_DEPTH + 1];
+
+// NOTE: children hang off the parent job, so the root counter only drops
+// once the whole subtree is done.
+PLATFORM_JOB_CALLBACK(bench_tree_job)
+{
+    Bench_Tree_Params *params = (Bench_Tree_Params *)data;
+    if (params->depth == BENCH_TREE_DEPTH)
+    {
+        atomic_add_u32(&g_bench_job_count, 1);
+    }
+    else
+    {
+        for (u32 idx = 0; idx < BENCH_TREE_FAN_OUT; ++idx)
+        {
+            job_system_add_job(0, job, bench_tree_job, g_bench_tree_params + params->depth + 1);
+        }
+    }
+}
+
+// waits on its own counter from inside a job, which has to help instead of block.
+PLATFORM_JOB_CALLBACK(bench_wait_job)
+{
+    Platform_Job_Counter counter = {};
+    for (u32 idx = 0; idx < BENCH_SUB_JOB_COUNT; ++idx)
+    {
+        job_system_add_job(&counter, 0, bench_tree_job, g_bench_tree_params + BENCH_TREE_DEPTH);
+    }
+    job_system_wait_for_counter(&counter);
+}
+
+// an asset load: a couple of rounds of fetching dependencies and waiting on them.
+#define BENCH_LOADER_ROUND_COUNT    4
+#define BENCH_LOADER_SPIN_COUNT     200
+
+PLATFORM_JOB_CALLBACK(bench_dependency_job)
+{
+    for (u32 spin = 0; spin < BENCH_LOADER_SPIN_COUNT; ++spin)
+    {
+        _mm_pause();
+    }
+    atomic_add_u32(&g_bench_job_count, 1);
+}
+
+PLATFORM_JOB_CALLBACK(bench_loader_job)
+{
+    for (u32 round = 0; round < BENCH_LOADER_ROUND_COUNT; ++round)
+    {
+        Platform_Job_Counter counter = {};
+        for (u32 idx = 0; idx < BENCH_SUB_JOB_COUNT; ++idx)
+        {
+            job_system_add_job(&counter, 0, bench_dependency_job, 0);
+        }
+        job_system_wait_for_counter(&counter);
+    }
+}
+
+// every level waits on the one below; deeper than the fiber pool is wide.
+PLATFORM_JOB_CALLBACK(bench_fiber_tree_job)
+{
+    Bench_Tree_Params *params = (Bench_Tree_Params *)data;
+    if (params->depth == BENCH_TREE_DEPTH)
+    {
+        atomic_add_u32(&g_bench_job_count, 1);
+    }
+    else
+    {
+        Platform_Job_Counter counter = {};
+        for (u32 idx = 0; idx < BENCH_TREE_FAN_OUT; ++idx)
+        {
+            job_system_add_fiber_job(&counter, 0, bench_fiber_tree_job, g_bench_tree_params + params->depth + 1);
+        }
+        job_system_wait_for_counter(&counter);
+    }
+}
+
+internal void *
+bench_job_worker_proc(void *param)
+{
+    job_system_thread_loop((Job_Worker *)param);
+    return 0;
+}
+
+#define BENCH_FIBER_COUNT       64
+#define BENCH_FIBER_STACK_SIZE  KB(64)
+
+// NOTE: the workers never exit; they just sleep once we move on.
+// The calling thread becomes worker 0 of the new system.
+internal Platform_Job_System *
+bench_make_job_system(u32 thread_count)
+{
+    Platform_Job_System *system = (Platform_Job_System *)aligned_alloc(64, sizeof(Platform_Job_System));
+    memset(system, 0, sizeof(*system));
+    job_system_init(system, thread_count);
+
+    void *fiber_stacks = mmap(0, BENCH_FIBER_COUNT * BENCH_FIBER_STACK_SIZE, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    job_system_init_fibers(system, fiber_stacks, BENCH_FIBER_STACK_SIZE, BENCH_FIBER_COUNT);
+    for (u32 idx = 1; idx < system->worker_count; ++idx)
+    {
+        pthread_t thread;
+        pthread_create(&thread, 0, bench_job_worker_proc, system->workers + idx);
+        pthread_detach(thread);
+    }
+    return system;
+}
+
+internal void
+bench_job_system()
+{
+    u32 core_count = bench_get_core_count();
+
+    for (u32 idx = 0; idx <= BENCH_TREE_DEPTH; ++idx)
+    {
+        g_bench_tree_params[idx].depth = idx;
+    }
+
+    u32 leaf_count = 1;
+    for (u32 idx = 0; idx < BENCH_TREE_DEPTH; ++idx)
+    {
+        leaf_count *= BENCH_TREE_FAN_OUT;
+    }
+
+    printf("job_system: parent/child tree, fan-out %u, depth %u (%u leaves), x16 roots\n",
+           BENCH_TREE_FAN_OUT, BENCH_TREE_DEPTH, leaf_count);
+    printf("%8s %12s %14s %14s\n", "threads", "seconds", "Mjobs/s", "nested ms");
+    for (u32 thread_count = 1;
+         thread_count <= core_count;
+         ++thread_count)
+    {
+        Platform_Job_System *system = bench_make_job_system(thread_count);
+
+        u32 root_count = 16;
+        g_bench_job_count = 0;
+        Platform_Job_Counter counter = {};
+
+        u64 begin = bench_get_wall_clock();
+        for (u32 idx = 0; idx < root_count; ++idx)
+        {
+            job_system_add_job(&counter, 0, bench_tree_job, g_bench_tree_params);
+        }
+        job_system_wait_for_counter(&counter);
+        f64 seconds = bench_get_seconds_elapsed(begin, bench_get_wall_clock());
+
+        Assert(g_bench_job_count == root_count * leaf_count);
+        f64 job_count = 0.0;
+        for (u32 level = 0, width = root_count; level <= BENCH_TREE_DEPTH; ++level, width *= BENCH_TREE_FAN_OUT)
+        {
+            job_count += (f64)width;
+        }
+
+        u32 wait_count = 1000;
+        g_bench_job_count = 0;
+        u64 nested_begin = bench_get_wall_clock();
+        for (u32 idx = 0; idx < wait_count; ++idx)
+        {
+            job_system_add_job(&counter, 0, bench_wait_job, 0);
+        }
+        job_system_wait_for_counter(&counter);
+        f64 nested_seconds = bench_get_seconds_elapsed(nested_begin, bench_get_wall_clock());
+        Assert(g_bench_job_count == wait_count * BENCH_SUB_JOB_COUNT);
+
+        job_system_complete_all_jobs(system);
+        Assert(system->outstanding_count == 0);
+
+        printf("%8u %12.4f %14.2f %14.3f\n", thread_count, seconds,
+               job_count / seconds / 1000000.0, nested_seconds * 1000.0);
+    }
+
+    u32 loader_count = 256;
+    printf("\njob_system: %u loaders, %u rounds of %u dependencies each, waiting by helping vs parked on a fiber\n",
+           loader_count, BENCH_LOADER_ROUND_COUNT, BENCH_SUB_JOB_COUNT);
+    printf("%8s %12s %12s %14s\n", "threads", "helping ms", "fibers ms", "fiber tree ms");
+    for (u32 thread_count = 1;
+         thread_count <= core_count;
+         ++thread_count)
+    {
+        Platform_Job_System *system = bench_make_job_system(thread_count);
+        f64 ms[2];
+        for (u32 use_fiber = 0; use_fiber < 2; ++use_fiber)
+        {
+            Platform_Job_Counter counter = {};
+            g_bench_job_count = 0;
+
+            u64 begin = bench_get_wall_clock();
+            for (u32 idx = 0; idx < loader_count; ++idx)
+            {
+                job_system_push_job(&counter, 0, bench_loader_job, 0, use_fiber);
+            }
+            job_system_wait_for_counter(&counter);
+            ms[use_fiber] = 1000.0 * bench_get_seconds_elapsed(begin, bench_get_wall_clock());
+
+            Assert(g_bench_job_count == loader_count * BENCH_LOADER_ROUND_COUNT * BENCH_SUB_JOB_COUNT);
+        }
+
+        // runs out of fibers on purpose.
+        Platform_Job_Counter counter = {};
+        g_bench_job_count = 0;
+        u64 begin = bench_get_wall_clock();
+        job_system_add_fiber_job(&counter, 0, bench_fiber_tree_job, g_bench_tree_params + BENCH_TREE_DEPTH - 5);
+        job_system_wait_for_counter(&counter);
+        f64 tree_ms = 1000.0 * bench_get_seconds_elapsed(begin, bench_get_wall_clock());
+        Assert(g_bench_job_count == 1024);
+
+        job_system_complete_all_jobs(system);
+        Assert(system->waiting_fiber_count == 0);
+
+        printf("%8u %12.3f %12.3f %14.3f\n", thread_count, ms[0], ms[1], tree_ms);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Parallel For
+//
+
+internal void
+bench_init_arena(Memory_Arena *arena, size_t size)
+{
+    init_arena(arena, size, aligned_alloc(64, size));
+    memset(arena->base, 0, size);
+}
+
+// NOTE: bench memory comes from malloc, committed already.
+PLATFORM_COMMIT_MEMORY(bench_commit_memory)
+{
+}
+
+// NOTE: for benches where commits cost what they do in the game. Reserved
+// PROT_NONE and committed with an mprotect, the same as linux.cpp does it.
+global_var u64 volatile g_bench_commit_count;
+
+internal void *
+bench_reserve_memory(size_t size)
+{
+    void *result = mmap(0, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    Assert(result != MAP_FAILED);
+    return result;
+}
+
+PLATFORM_COMMIT_MEMORY(bench_mprotect_commit_memory)
+{
+    u64 page_mask = (u64)sysconf(_SC_PAGESIZE) - 1;
+    u8 *first = (u8 *)((u64)base & ~page_mask);
+    u8 *end = (u8 *)(((u64)base + size + page_mask) & ~page_mask);
+    mprotect(first, (size_t)(end - first), PROT_READ | PROT_WRITE);
+    atomic_add_u64(&g_bench_commit_count, 1, eMemory_Order_Relaxed);
+}
+
+// back to reserved, only the whole pages in the range. They keep what's in
+// them, so committing them again doesn't fault them in again.
+internal void
+bench_decommit_memory(void *base, size_t size)
+{
+    u64 page_mask = (u64)sysconf(_SC_PAGESIZE) - 1;
+    u8 *first = (u8 *)(((u64)base + page_mask) & ~page_mask);
+    u8 *end = (u8 *)(((u64)base + size) & ~page_mask);
+    if (end > first)
+    {
+        mprotect(first, (size_t)(end - first), PROT_NONE);
+    }
+}
+
+PLATFORM_READ_ENTIRE_FILE(bench_read_entire_file)
+{
+    Entire_File result = {};
+    FILE *file = fopen(filename, "rb");
+    if (file)
+    {
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        result.contents = malloc(size);
+        if (fread(result.contents, 1, size, file) == (size_t)size)
+        {
+            result.content_size = (u32)size;
+        }
+        fclose(file);
+    }
+    return result;
+}
+
+#define BENCH_STAR_COUNT        STAR_COUNT_MAX
+#define BENCH_ENTITY_COUNT      100'000
+#define BENCH_ANIMATED_COUNT    256
+#define BENCH_BMP_SIDE          2048
+#define BENCH_REPEAT_COUNT      8
+
+struct Bench_Parallel_World
+{
+    Generate_Stars_Data     stars;
+
+    Game_State              game_state;
+    Integrate_Params        integrate;
+
+    b32                     has_animation;
+    Animate_Entities_Data   animate;
+
+    u32                     *bmp_source;
+    Convert_BMP_Data        convert;
+};
+
+// NOTE: what game_update steps with, at 60Hz and the config's defaults.
+internal Integrate_Params
+bench_get_integrate_params(v3 chunk_dim, Chunk_Position min_pos, Chunk_Position max_pos)
+{
+    Integrate_Params result = {};
+    result.dt           = 1.0f / 60.0f;
+    result.gravity      = GlobalConstants_Sim_Gravity;
+    result.drag         = GlobalConstants_Sim_Drag;
+    result.max_speed    = GlobalConstants_Sim_Max_Speed;
+    result.chunk_dim    = chunk_dim;
+    result.min_pos      = min_pos;
+    result.max_pos      = max_pos;
+    result.kernel       = eIntegrate_Kernel_Widest;
+    return result;
+}
+
+internal void
+bench_init_parallel_world(Bench_Parallel_World *world, Memory_Arena *arena)
+{
+    Random_Series series = seed(1219);
+
+    // stars
+    world->stars.seeds = push_array(arena, Star_Seed, BENCH_STAR_COUNT);
+    world->stars.world_transforms = push_array(arena, m4x4, BENCH_STAR_COUNT);
+    for (u32 idx = 0; idx < BENCH_STAR_COUNT; ++idx)
+    {
+        Star_Seed *star_seed = world->stars.seeds + idx;
+        star_seed->v.x      = rand_bilateral(&series);
+        star_seed->v.y      = rand_bilateral(&series);
+        star_seed->v.z      = rand_bilateral(&series);
+        star_seed->theta    = rand_range(&series, 0.0f, pi32 * 0.5f);
+    }
+
+    // entities, spread over the sim region game_update uses.
+    Game_State *game_state = &world->game_state;
+    bench_init_arena(&game_state->world_arena, MB(64));
+    game_state->world = push_struct(&game_state->world_arena, World);
+    init_world(game_state->world, &game_state->world_arena, v3{10.0f, 3.0f, 10.0f});
+    v3 chunk_dim = game_state->world->chunk_dim;
+
+    v3 sim_dim = v3{100.0f, 5.0f, 50.0f};
+    Chunk_Position min_pos = {};
+    Chunk_Position max_pos = {};
+    min_pos.offset -= 0.5f * sim_dim;
+    max_pos.offset += 0.5f * sim_dim;
+    recalc_pos(&min_pos, chunk_dim);
+    recalc_pos(&max_pos, chunk_dim);
+
+    for (u32 idx = 0; idx < BENCH_ENTITY_COUNT; ++idx)
+    {
+        Chunk_Position pos = {};
+        pos.offset = v3{rand_bilateral(&series) * 0.5f * sim_dim.x,
+                        rand_bilateral(&series) * 0.5f * sim_dim.y,
+                        rand_bilateral(&series) * 0.5f * sim_dim.z};
+        recalc_pos(&pos, chunk_dim);
+        Entity_Store *entities = &game_state->world->entities;
+        u32 entity = get_entity(entities, push_entity(game_state->world, Entity_Type::XBOT, pos));
+        set_split(entities->velocity, entity, v3{rand_bilateral(&series), 0.0f, rand_bilateral(&series)});
+    }
+    world->integrate = bench_get_integrate_params(chunk_dim, min_pos, max_pos);
+
+    // animation, if run from data/.
+    if (access("mesh/xbot.smsh", R_OK) == 0)
+    {
+        Animate_Entities_Data *animate = &world->animate;
+        animate->model  = push_struct(arena, Model);
+        animate->idle   = push_struct(arena, Animation);
+        animate->run    = push_struct(arena, Animation);
+        load_model(animate->model, "mesh/xbot.smsh", arena, bench_read_entire_file);
+        load_animation(animate->idle, "animation/xbot_idle.sanm", arena, bench_read_entire_file);
+        load_animation(animate->run, "animation/xbot_run.sanm", arena, bench_read_entire_file);
+
+        animate->dt         = 1.0f / 60.0f;
+        animate->store      = push_struct(arena, Entity_Store);
+        animate->entities   = push_array(arena, u32, BENCH_ANIMATED_COUNT);
+        Entity_Store *store = animate->store;
+        init_entity_store(store, arena, BENCH_ANIMATED_COUNT);
+        for (u32 idx = 0; idx < BENCH_ANIMATED_COUNT; ++idx)
+        {
+            // idle, blended and running, in turn.
+            u32 entity = add_entity(store, Entity_Type::XBOT);
+            set_split(store->velocity, entity, v3{0.4f * (f32)(idx % 3), 0.0f, 0.0f});
+            store->animation_transform[entity] = push_array(arena, m4x4, animate->model->node_count);
+            store->animation_channel[entity].animation = animate->idle;
+            store->animation_channel[entity].dt = rand_range(&series, 0.0f, animate->idle->duration);
+            animate->entities[idx] = entity;
+        }
+        world->has_animation = true;
+    }
+
+    // bmp rows, converted from a pristine copy every run.
+    u32 pixel_count = BENCH_BMP_SIDE * BENCH_BMP_SIDE;
+    world->bmp_source = push_array(arena, u32, pixel_count);
+    for (u32 idx = 0; idx < pixel_count; ++idx)
+    {
+        world->bmp_source[idx] = (u32)(rand_range(&series, 0.0f, 1.0f) * 4294967040.0f);
+    }
+    world->convert.pixels   = push_array(arena, u32, pixel_count);
+    world->convert.width    = BENCH_BMP_SIDE;
+    world->convert.r_mask   = 0x00ff0000;
+    world->convert.g_mask   = 0x0000ff00;
+    world->convert.b_mask   = 0x000000ff;
+    world->convert.a_mask   = 0xff000000;
+    world->convert.r_shift  = 16;
+    world->convert.g_shift  = 8;
+    world->convert.b_shift  = 0;
+    world->convert.a_shift  = 24;
+}
+
+// best of BENCH_REPEAT_COUNT, in ms.
+internal f64
+bench_parallel_kernel(Bench_Parallel_World *world, Parallel_Context *parallel, u32 kernel)
+{
+    f64 best = 1e30;
+    for (u32 repeat = 0; repeat < BENCH_REPEAT_COUNT; ++repeat)
+    {
+        if (kernel == 3)
+        {
+            memcpy(world->convert.pixels, world->bmp_source, sizeof(u32) * BENCH_BMP_SIDE * BENCH_BMP_SIDE);
+        }
+
+        u64 begin = bench_get_wall_clock();
+        switch (kernel)
+        {
+            case 0:
+            {
+                parallel_for(parallel, 0, BENCH_STAR_COUNT, 0, generate_stars, &world->stars);
+            } break;
+
+            case 1:
+            {
+                update_entities(&world->game_state, parallel, &world->integrate);
+            } break;
+
+            case 2:
+            {
+                parallel_for(parallel, 0, BENCH_ANIMATED_COUNT, 1, animate_entities, &world->animate);
+            } break;
+
+            case 3:
+            {
+                parallel_for(parallel, 0, BENCH_BMP_SIDE, 0, convert_bmp_rows, &world->convert);
+            } break;
+        }
+        f64 ms = 1000.0 * bench_get_seconds_elapsed(begin, bench_get_wall_clock());
+        best = minimum(best, ms);
+
+        // NOTE: the kernels are instrumented; nobody collates here.
+        g_debug_table->event_array_idx_event_idx = 0;
+    }
+    return best;
+}
+
+internal void
+bench_parallel_for()
+{
+    u32 core_count = bench_get_core_count();
+
+    Memory_Arena world_arena;
+    bench_init_arena(&world_arena, MB(256));
+    Bench_Parallel_World *world = push_struct(&world_arena, Bench_Parallel_World);
+    bench_init_parallel_world(world, &world_arena);
+
+    const char *kernel_names[] = {"stars", "entities", "anim", "bmp"};
+    u32 kernel_count = world->has_animation ? 4 : 3;
+    if (!world->has_animation)
+    {
+        // skip anim, run from data/ to include it.
+        kernel_names[2] = kernel_names[3];
+    }
+
+    printf("parallel_for: %u star transforms, update of %u entities in %u chunks, "
+           "%u xbot poses, %ux%u bmp conversion\n",
+           BENCH_STAR_COUNT, BENCH_ENTITY_COUNT, world->game_state.world->chunk_table.count,
+           world->has_animation ? BENCH_ANIMATED_COUNT : 0, BENCH_BMP_SIDE, BENCH_BMP_SIDE);
+    printf("best of %u, ms (speed-up over 1 thread)\n", BENCH_REPEAT_COUNT);
+    printf("%8s", "threads");
+    for (u32 idx = 0; idx < kernel_count; ++idx)
+    {
+        printf(" %18s", kernel_names[idx]);
+    }
+    printf("\n");
+
+    f64 single[4] = {};
+    for (u32 thread_count = 1;
+         thread_count <= core_count;
+         ++thread_count)
+    {
+        bench_make_job_system(thread_count);
+
+        Platform_API platform = {};
+        platform.platform_add_job               = job_system_add_job;
+        platform.platform_wait_for_counter      = job_system_wait_for_counter;
+        platform.platform_get_job_thread_index  = job_system_get_thread_index;
+
+        // NOTE: a block of MB(1) takes up MB(1) + ARENA_COMMIT_GRANULARITY
+        // with its header. Slack for the second arenas, if a kernel nests.
+        Memory_Arena scratch_arena;
+        bench_init_arena(&scratch_arena, thread_count * sizeof(Thread_Scratch) + ARENA_CACHE_LINE);
+        size_t block_source_size = thread_count * (MB(1) + ARENA_COMMIT_GRANULARITY) + MB(8);
+        void *block_source_memory = aligned_alloc(ARENA_COMMIT_GRANULARITY, block_source_size);
+        Memory_Block_Source block_source;
+        init_block_source(&block_source, block_source_memory, block_source_size, bench_commit_memory);
+        Parallel_Context parallel = {};
+        init_parallel_context(&parallel, &platform, thread_count, &scratch_arena, &block_source, MB(1));
+
+        printf("%8u", thread_count);
+        for (u32 idx = 0; idx < kernel_count; ++idx)
+        {
+            u32 kernel = (!world->has_animation && idx == 2) ? 3 : idx;
+            f64 ms = bench_parallel_kernel(world, &parallel, kernel);
+            if (thread_count == 1)
+            {
+                single[idx] = ms;
+            }
+            printf(" %10.3f (%4.2fx)", ms, single[idx] / ms);
+        }
+        printf("\n");
+        free(scratch_arena.base);
+        free(block_source_memory);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Alignment
+//
+// y = a*x + y over arrays pushed on an arena, 4 floats at a time. Aligned
+// arrays start on a cache line; misaligned ones 4 bytes past one, which is
+// what a 4-byte aligned push gets. Then every 4th load or store of 16 bytes
+// straddles two cache lines, and one in 256 two pages.
+//
+
+#define BENCH_ALIGNMENT_TOUCHED     MB(256)
+
+enum Bench_Alignment_Kernel
+{
+    eBench_Alignment_Aligned,           // _mm_load_ps, aligned arrays.
+    eBench_Alignment_Unaligned_Ops,     // _mm_loadu_ps, aligned arrays.
+    eBench_Alignment_Misaligned,        // _mm_loadu_ps, arrays 4 bytes off.
+
+    eBench_Alignment_Count
+};
+
+internal void
+bench_saxpy_aligned(f32 *x, f32 *y, u32 count, f32 a)
+{
+    __m128 a_4x = _mm_set1_ps(a);
+    for (u32 idx = 0;
+         idx < count;
+         idx += 4)
+    {
+        __m128 y_4x = _mm_add_ps(_mm_mul_ps(a_4x, _mm_load_ps(x + idx)), _mm_load_ps(y + idx));
+        _mm_store_ps(y + idx, y_4x);
+    }
+}
+
+internal void
+bench_saxpy_unaligned(f32 *x, f32 *y, u32 count, f32 a)
+{
+    __m128 a_4x = _mm_set1_ps(a);
+    for (u32 idx = 0;
+         idx < count;
+         idx += 4)
+    {
+        __m128 y_4x = _mm_add_ps(_mm_mul_ps(a_4x, _mm_loadu_ps(x + idx)), _mm_loadu_ps(y + idx));
+        _mm_storeu_ps(y + idx, y_4x);
+    }
+}
+
+// returns GB/s, reads and writes both counted.
+internal f64
+bench_alignment_kernel(Memory_Arena *arena, u32 count, Bench_Alignment_Kernel kernel)
+{
+    Temporary_Memory temp = begin_temporary_memory(arena);
+
+    size_t alignment = ARENA_CACHE_LINE;
+    if (kernel == eBench_Alignment_Misaligned)
+    {
+        push_size(arena, 4, 4);
+        alignment = 4;
+    }
+    f32 *x = push_array(arena, f32, count, alignment);
+    // NOTE: so that x and y aren't a multiple of 4KB apart. Loads would wait
+    // on stores to the other array that only look like the same address.
+    push_size(arena, 4 * ARENA_CACHE_LINE, alignment);
+    f32 *y = push_array(arena, f32, count, alignment);
+    for (u32 idx = 0; idx < count; ++idx)
+    {
+        x[idx] = (f32)idx;
+        y[idx] = 1.0f;
+    }
+
+    u32 round_count = maximum(BENCH_ALIGNMENT_TOUCHED / (count * sizeof(f32)), 1);
+    f64 best = F32_MAX;
+    for (u32 repeat = 0; repeat < BENCH_REPEAT_COUNT; ++repeat)
+    {
+        u64 begin = bench_get_wall_clock();
+        for (u32 round = 0; round < round_count; ++round)
+        {
+            if (kernel == eBench_Alignment_Aligned)
+            {
+                bench_saxpy_aligned(x, y, count, 0.5f);
+            }
+            else
+            {
+                bench_saxpy_unaligned(x, y, count, 0.5f);
+            }
+        }
+        best = minimum(best, bench_get_seconds_elapsed(begin, bench_get_wall_clock()));
+    }
+
+    end_temporary_memory(&temp);
+
+    f64 bytes = (f64)round_count * count * sizeof(f32) * 3;
+    f64 result = bytes / best / 1e9;
+    return result;
+}
+
+internal void
+bench_alignment()
+{
+    Memory_Arena arena;
+    bench_init_arena(&arena, MB(128) + KB(4));
+
+    printf("alignment: y = a*x + y with SSE over arena arrays, GB/s, best of %u\n", BENCH_REPEAT_COUNT);
+    printf("%10s %12s %12s %12s\n", "x+y", "aligned", "loadu", "misaligned");
+    u32 counts[] = {KB(1), KB(16), KB(256), MB(16)};
+    for (u32 count_idx = 0;
+         count_idx < array_count(counts);
+         ++count_idx)
+    {
+        u32 count = counts[count_idx];
+        f64 gbs[eBench_Alignment_Count];
+        for (u32 kernel = 0;
+             kernel < eBench_Alignment_Count;
+             ++kernel)
+        {
+            gbs[kernel] = bench_alignment_kernel(&arena, count, (Bench_Alignment_Kernel)kernel);
+        }
+        printf("%8uKB %12.2f %12.2f %12.2f\n", (u32)(2 * count * sizeof(f32) / 1024),
+               gbs[eBench_Alignment_Aligned], gbs[eBench_Alignment_Unaligned_Ops],
+               gbs[eBench_Alignment_Misaligned]);
+    }
+
+    free(arena.base);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Memory
+//
+// copy_memory and zero_memory against the byte loops they replaced and
+// libc, from 64B to 64MB. Every size moves about the same number of bytes.
+//
+
+#define BENCH_MEMORY_MOVED  MB(128)
+
+// NOTE: the loops as they were. GCC would turn them into memcpy and memset
+// calls; MSVC at -Od, which build.bat uses, keeps them.
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+internal void
+bench_copy_bytes(void *dst, void *src, size_t size)
+{
+    u8 *dst_at = (u8 *)dst;
+    u8 *src_at = (u8 *)src;
+    for (size_t i = 0; i < size; ++i)
+    {
+        *dst_at++ = *src_at++;
+    }
+}
+
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+internal void
+bench_zero_bytes(void *dst, size_t size)
+{
+    u8 *at = (u8 *)dst;
+    while (size--)
+    {
+        *at++ = 0;
+    }
+}
+
+enum Bench_Memory_Kernel
+{
+    eBench_Memory_Copy_Bytes,
+    eBench_Memory_Copy_SSE,
+    eBench_Memory_Copy_Stream,
+    eBench_Memory_Copy_Libc,
+    eBench_Memory_Zero_Bytes,
+    eBench_Memory_Zero_SSE,
+    eBench_Memory_Zero_Stream,
+    eBench_Memory_Zero_Libc,
+
+    eBench_Memory_Count
+};
+
+// returns GB/s of destination written.
+internal f64
+bench_memory_kernel(u8 *dst, u8 *src, size_t size, Bench_Memory_Kernel kernel)
+{
+    u32 round_count = (u32)maximum(BENCH_MEMORY_MOVED / size, 1);
+    f64 best = F32_MAX;
+    for (u32 repeat = 0; repeat < 4; ++repeat)
+    {
+        u64 begin = bench_get_wall_clock();
+        for (u32 round = 0; round < round_count; ++round)
+        {
+            switch (kernel)
+            {
+                case eBench_Memory_Copy_Bytes:  bench_copy_bytes(dst, src, size); break;
+                case eBench_Memory_Copy_SSE:    copy_memory_(dst, src, size, false); break;
+                case eBench_Memory_Copy_Stream: copy_memory_(dst, src, size, true); break;
+                case eBench_Memory_Copy_Libc:   memcpy(dst, src, size); break;
+                case eBench_Memory_Zero_Bytes:  bench_zero_bytes(dst, size); break;
+                case eBench_Memory_Zero_SSE:    fill_memory_(dst, 0, size, false); break;
+                case eBench_Memory_Zero_Stream: fill_memory_(dst, 0, size, true); break;
+                case eBench_Memory_Zero_Libc:   memset(dst, 0, size); break;
+                default: break;
+            }
+            // NOTE: so the compiler can't drop rounds.
+            __asm__ __volatile__("" : : "r"(dst) : "memory");
+        }
+        best = minimum(best, bench_get_seconds_elapsed(begin, bench_get_wall_clock()));
+    }
+
+    f64 result = (f64)round_count * size / best / 1e9;
+    return result;
+}
+
+internal void
+bench_memory()
+{
+    size_t max_size = MB(64);
+    Memory_Arena arena;
+    bench_init_arena(&arena, 2 * max_size + 2 * ARENA_CACHE_LINE);
+    // NOTE: 4 bytes off, where a READ_COUNT copy out of a file lands.
+    u8 *src = (u8 *)push_size(&arena, max_size + 4, ARENA_CACHE_LINE) + 4;
+    u8 *dst = (u8 *)push_size(&arena, max_size, ARENA_CACHE_LINE);
+    fill_memory(src, 0x5a, max_size);
+
+    // the new ones have to match.
+    for (size_t size = 0; size < 300; ++size)
+    {
+        fill_memory(dst, 0xff, size + 32);
+        copy_memory(dst + 1, src + 3, size);
+        b32 ok = (dst[0] == 0xff && dst[size + 1] == 0xff);
+        for (size_t idx = 0; idx < size; ++idx)
+        {
+            ok &= (dst[idx + 1] == src[idx + 3]);
+        }
+        zero_memory(dst + 1, size);
+        ok &= (dst[0] == 0xff && dst[size + 1] == 0xff);
+        for (size_t idx = 0; idx < size; ++idx)
+        {
+            ok &= (dst[idx + 1] == 0);
+        }
+        Assert(ok);
+        if (!ok)
+        {
+            printf("memory: mismatch at %zu bytes\n", size);
+            return;
+        }
+    }
+
+    printf("memory: GB/s written, best of 4, source 4 bytes off a cache line, stream from %lluKB\n",
+           MEMORY_STREAM_THRESHOLD / 1024);
+    printf("%8s %8s %8s %8s %8s   %8s %8s %8s %8s\n", "size",
+           "copy b", "sse", "stream", "memcpy", "zero b", "sse", "stream", "memset");
+    for (size_t size = 64;
+         size <= max_size;
+         size *= 4)
+    {
+        if (size < KB(1))       printf("%7zuB ", size);
+        else if (size < MB(1))  printf("%6zuKB ", (size_t)(size / KB(1)));
+        else                    printf("%6zuMB ", (size_t)(size / MB(1)));
+
+        for (u32 kernel = 0;
+             kernel < eBench_Memory_Count;
+             ++kernel)
+        {
+            f64 gbs = bench_memory_kernel(dst, src, size, (Bench_Memory_Kernel)kernel);
+            printf("%8.2f %s", gbs, (kernel == eBench_Memory_Copy_Libc) ? "  " : "");
+        }
+        printf("\n");
+    }
+
+    free(arena.base);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Pool
+//
+// A soak of entity spawn/despawn churn over a sim region that slides along
+// x, the way the world would stream. Despawned handles have to go stale, and
+// the world arena has to stop growing once the chunk pool has its slabs and
+// the entity columns their capacity.
+//
+
+#define BENCH_POOL_FRAMES       2000
+#define BENCH_POOL_LIVE         20000
+#define BENCH_POOL_CHURN        2000
+#define BENCH_POOL_REPORT_EVERY 500
+
+internal void
+bench_pool_print_stats(const char *name, Pool *pool)
+{
+    Pool_Stats stats = get_pool_stats(pool);
+    printf("  %-8s %6u live %6u high water %6u slots %5u slabs, %5u in use, %5u packed, %6u on the free list\n",
+           name, stats.live_count, stats.high_water, stats.capacity, stats.slab_count,
+           stats.used_slab_count, stats.packed_slab_count, stats.free_slot_count);
+}
+
+// what an entity takes over all of the store's columns.
+internal size_t
+bench_get_entity_size()
+{
+    Entity_Store *store = 0;
+    size_t result = (sizeof(store->type[0]) + sizeof(store->flags[0]) + sizeof(store->slot[0]) +
+                     sizeof(store->chunk[0]) + sizeof(v3i) + sizeof(v3) +
+                     sizeof(v3) + sizeof(store->world_rotation[0]) +
+                     sizeof(store->world_scaling[0]) + sizeof(v3) +
+                     sizeof(store->prev_world_rotation[0]) + sizeof(v3) +
+                     sizeof(v3) + sizeof(store->u[0]) +
+                     sizeof(store->animation_channel[0]) + sizeof(store->animation_transform[0]) +
+                     sizeof(store->slot_dense_idx[0]) + sizeof(store->slot_generation[0]));
+    return result;
+}
+
+internal void
+bench_pool()
+{
+    Memory_Arena world_arena;
+    bench_init_arena(&world_arena, MB(64));
+    World *world = push_struct(&world_arena, World);
+    init_world(world, &world_arena, v3{10.0f, 3.0f, 10.0f});
+    v3 chunk_dim = world->chunk_dim;
+    v3 region_dim = v3{100.0f, 5.0f, 50.0f};
+
+    Memory_Arena arena;
+    bench_init_arena(&arena, 2 * BENCH_POOL_LIVE * sizeof(Entity_Handle));
+    Entity_Handle *live = push_array(&arena, Entity_Handle, BENCH_POOL_LIVE);
+    Entity_Handle *stale = push_array(&arena, Entity_Handle, BENCH_POOL_LIVE);
+    u32 stale_count = 0;
+
+    Random_Series series = seed(1219);
+    u32 live_count = 0;
+    u32 stale_alive = 0;
+    size_t settled_used = 0;
+    f64 spawn_seconds = 0.0;
+    f64 despawn_seconds = 0.0;
+    f64 release_seconds = 0.0;
+
+    printf("pool: %u frames, %u entities live, %u despawned and spawned a frame, the region moves a chunk every 16 frames\n",
+           BENCH_POOL_FRAMES, BENCH_POOL_LIVE, BENCH_POOL_CHURN);
+    for (u32 frame = 0;
+         frame <= BENCH_POOL_FRAMES;
+         ++frame)
+    {
+        Chunk_Position center = {};
+        center.x = (s32)(frame / 16);
+        Chunk_Position min_pos = center;
+        Chunk_Position max_pos = center;
+        min_pos.offset -= 0.5f * region_dim;
+        max_pos.offset += 0.5f * region_dim;
+        recalc_pos(&min_pos, chunk_dim);
+        recalc_pos(&max_pos, chunk_dim);
+
+        u64 begin = bench_get_wall_clock();
+        u32 despawn_count = minimum(live_count, BENCH_POOL_CHURN);
+        stale_count = 0;
+        for (u32 idx = 0;
+             idx < despawn_count;
+             ++idx)
+        {
+            u32 victim = (u32)rand_range(&series, 0.0f, (f32)live_count - 0.5f);
+            u32 entity = get_entity(&world->entities, live[victim]);
+            stale[stale_count++] = live[victim];
+            despawn_entity(world, entity);
+            live[victim] = live[--live_count];
+        }
+        u64 end = bench_get_wall_clock();
+        despawn_seconds += bench_get_seconds_elapsed(begin, end);
+
+        begin = end;
+        while (live_count < BENCH_POOL_LIVE)
+        {
+            Chunk_Position pos = center;
+            pos.offset = v3{rand_bilateral(&series) * 0.5f * region_dim.x,
+                            rand_bilateral(&series) * 0.5f * region_dim.y,
+                            rand_bilateral(&series) * 0.5f * region_dim.z};
+            recalc_pos(&pos, chunk_dim);
+            live[live_count++] = push_entity(world, Entity_Type::XBOT, pos);
+        }
+        end = bench_get_wall_clock();
+        spawn_seconds += bench_get_seconds_elapsed(begin, end);
+
+        // NOTE: the slots are taken again by now, the handles mustn't see it.
+        for (u32 idx = 0;
+             idx < stale_count;
+             ++idx)
+        {
+            stale_alive += (get_entity(&world->entities, stale[idx]) != ENTITY_NONE);
+        }
+
+        begin = bench_get_wall_clock();
+        release_empty_chunks(world, min_pos, max_pos);
+        release_seconds += bench_get_seconds_elapsed(begin, bench_get_wall_clock());
+
+        // NOTE: instrumented, and nobody collates here.
+        g_debug_table->event_array_idx_event_idx = 0;
+
+        if (frame == BENCH_POOL_REPORT_EVERY)
+        {
+            settled_used = world_arena.used;
+        }
+        if (frame % BENCH_POOL_REPORT_EVERY == 0)
+        {
+            printf("frame %5u: world arena %.2fMB\n", frame, (f64)world_arena.used / (f64)MB(1));
+            Entity_Store *store = &world->entities;
+            printf("  %-8s %6u live %6u slots %6u capacity\n", "entities",
+                   store->count, store->slot_count, store->capacity);
+            bench_pool_print_stats("chunks", &world->chunk_pool.pool);
+        }
+    }
+
+    u64 spawned = world->entities.push_count;
+    u64 churned = (u64)BENCH_POOL_FRAMES * BENCH_POOL_CHURN;
+    printf("spawn %.1fns, despawn %.1fns, release_empty_chunks %.1fus a frame\n",
+           1e9 * spawn_seconds / (f64)spawned, 1e9 * despawn_seconds / (f64)churned,
+           1e6 * release_seconds / (f64)(BENCH_POOL_FRAMES + 1));
+    printf("world arena grew %.2fMB after frame %u, bump allocation would have taken %.2fMB\n",
+           (f64)(world_arena.used - settled_used) / (f64)MB(1), BENCH_POOL_REPORT_EVERY,
+           (f64)(spawned * bench_get_entity_size() + world->chunk_pool.pool.alloc_count * sizeof(Chunk)) / (f64)MB(1));
+    printf("stale handles that resolved: %u\n", stale_alive);
+    Assert(stale_alive == 0);
+
+    free(arena.base);
+    free(world_arena.base);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Asset Cache
+//
+// Every model and animation loads once with room for all of them, and gets
+// hashed. Then the budget drops below what they take together, and a frame
+// uses a few of them at a time, moving through them all, so they keep getting
+// evicted and loaded again. Every load has to hash the same as the first, and
+// the blocks evicted slots give back have to cover the loads after the first
+// round.
+//
+
+#define BENCH_ASSET_FRAMES      2000
+#define BENCH_ASSET_PER_FRAME   2
+
+// NOTE: synchronous, the reads are done by the time read returns.
+PLATFORM_OPEN_FILE(bench_open_file)
+{
+    Platform_File_Handle result = {};
+    FILE *file = fopen(file_name, "rb");
+    if (file)
+    {
+        fseek(file, 0, SEEK_END);
+        result.size         = (u64)ftell(file);
+        result.platform     = (u64)file;
+        result.no_errors    = true;
+    }
+    return result;
+}
+
+PLATFORM_READ_FILE(bench_read_file)
+{
+    FILE *stream = (FILE *)file->platform;
+    fseek(stream, (long)offset, SEEK_SET);
+    if (fread(dest, 1, size, stream) != size)
+    {
+        file->no_errors = false;
+    }
+}
+
+PLATFORM_CLOSE_FILE(bench_close_file)
+{
+    if (file->platform)
+    {
+        fclose((FILE *)file->platform);
+    }
+    *file = {};
+}
+
+internal void
+bench_wait_for_counter(Platform_Job_Counter *counter)
+{
+}
+
+internal u64
+bench_hash(u64 hash, void *data, size_t size)
+{
+    u8 *at = (u8 *)data;
+    for (size_t idx = 0;
+         idx < size;
+         ++idx)
+    {
+        hash = (hash ^ at[idx]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+internal u64
+bench_hash_cached_asset(Asset_Slot *slot, Cached_Asset id)
+{
+    u64 hash = 14695981039346656037ull;
+    if (is_animation(id))
+    {
+        Animation *anim = &slot->animation;
+        hash = bench_hash(hash, &anim->duration, sizeof(anim->duration));
+        for (u32 sample_idx = 0;
+             sample_idx < anim->sample_count;
+             ++sample_idx)
+        {
+            Sample *sample = anim->samples + sample_idx;
+            hash = bench_hash(hash, &sample->id, sizeof(sample->id));
+            hash = bench_hash(hash, sample->translations, sample->translation_count * sizeof(dt_v3_Pair));
+            hash = bench_hash(hash, sample->rotations, sample->rotation_count * sizeof(dt_qt_Pair));
+            hash = bench_hash(hash, sample->scalings, sample->scaling_count * sizeof(dt_v3_Pair));
+        }
+    }
+    else
+    {
+        Model *model = &slot->model;
+        for (u32 mesh_idx = 0;
+             mesh_idx < model->mesh_count;
+             ++mesh_idx)
+        {
+            Mesh *mesh = model->meshes + mesh_idx;
+            hash = bench_hash(hash, mesh->vertices, mesh->vertex_count * sizeof(Vertex));
+            hash = bench_hash(hash, mesh->indices, mesh->index_count * sizeof(u32));
+        }
+        hash = bench_hash(hash, model->materials, model->material_count * sizeof(Material));
+        for (u32 node_idx = 0;
+             node_idx < model->node_count;
+             ++node_idx)
+        {
+            // NOTE: the root's base transform is where the xbot fix-up goes.
+            Node *node = model->nodes + node_idx;
+            hash = bench_hash(hash, &node->base_transform, sizeof(node->base_transform));
+        }
+    }
+    return hash;
+}
+
+internal void
+bench_asset_cache()
+{
+    if (access(g_cached_asset_file_names[0], R_OK) != 0)
+    {
+        printf("asset_cache: run it from data/\n");
+        return;
+    }
+
+    Platform_API platform = {};
+    platform.platform_open_file         = bench_open_file;
+    platform.platform_read_file         = bench_read_file;
+    platform.platform_close_file        = bench_close_file;
+    platform.platform_wait_for_counter  = bench_wait_for_counter;
+
+    size_t block_source_size = MB(256);
+    void *block_source_memory = aligned_alloc(ARENA_COMMIT_GRANULARITY, block_source_size);
+    Memory_Block_Source block_source;
+    init_block_source(&block_source, block_source_memory, block_source_size, bench_commit_memory);
+
+    Game_Assets *assets = (Game_Assets *)calloc(1, sizeof(Game_Assets));
+    Asset_Cache *cache = &assets->cache;
+    init_asset_cache(cache, &platform, &block_source, block_source_size);
+
+    u64 hashes[eCached_Asset_Count];
+    size_t sizes[eCached_Asset_Count];
+    size_t total_size = 0;
+    size_t biggest_size = 0;
+    for (u32 id = 0;
+         id < eCached_Asset_Count;
+         ++id)
+    {
+        Asset_Slot *slot = acquire_cached_asset(assets, (Cached_Asset)id);
+        Assert(slot);
+        hashes[id]  = bench_hash_cached_asset(slot, (Cached_Asset)id);
+        sizes[id]   = slot->size;
+        total_size += slot->size;
+        biggest_size = maximum(biggest_size, slot->size);
+    }
+
+    // NOTE: the biggest one fits, with a quarter of the rest.
+    size_t budget = biggest_size + (total_size - biggest_size) / 4;
+    printf("asset_cache: %u assets, %.2fMB together, budget %.2fMB, %u frames using %u each\n",
+           eCached_Asset_Count, (f64)total_size / (f64)MB(1), (f64)budget / (f64)MB(1),
+           BENCH_ASSET_FRAMES, BENCH_ASSET_PER_FRAME);
+    end_asset_cache_frame(cache, budget);
+
+    u32 mismatch_count = 0;
+    u32 over_budget_frame_count = 0;
+    size_t max_used = 0;
+    size_t source_used_after_first_round = 0;
+    u64 first_miss_count = cache->miss_count;
+    f64 load_seconds = 0.0;
+    Random_Series series = seed(1219);
+    for (u32 frame = 0;
+         frame < BENCH_ASSET_FRAMES;
+         ++frame)
+    {
+        for (u32 use_idx = 0;
+             use_idx < BENCH_ASSET_PER_FRAME;
+             ++use_idx)
+        {
+            // one moving through them in turn, the others anywhere.
+            u32 id = (use_idx == 0) ? ((frame / 4) % eCached_Asset_Count) :
+                (u32)rand_range(&series, 0.0f, (f32)eCached_Asset_Count - 0.5f);
+
+            u64 miss_count = cache->miss_count;
+            u64 begin = bench_get_wall_clock();
+            Asset_Slot *slot = acquire_cached_asset(assets, (Cached_Asset)id);
+            u64 end = bench_get_wall_clock();
+            if (cache->miss_count != miss_count)
+            {
+                load_seconds += bench_get_seconds_elapsed(begin, end);
+            }
+
+            if (!slot ||
+                slot->size != sizes[id] ||
+                bench_hash_cached_asset(slot, (Cached_Asset)id) != hashes[id])
+            {
+                ++mismatch_count;
+            }
+        }
+
+        end_asset_cache_frame(cache, budget);
+        max_used = maximum(max_used, cache->used);
+        over_budget_frame_count += (cache->used > budget);
+        if (frame == 4 * eCached_Asset_Count)
+        {
+            source_used_after_first_round = block_source.used;
+        }
+
+        // NOTE: instrumented, and nobody collates here.
+        g_debug_table->event_array_idx_event_idx = 0;
+    }
+
+    u64 reload_count = cache->miss_count - first_miss_count;
+    printf("%llu hits, %llu misses, %llu evictions, %.1fus a load\n",
+           (unsigned long long)cache->hit_count, (unsigned long long)cache->miss_count,
+           (unsigned long long)cache->eviction_count,
+           reload_count ? 1e6 * load_seconds / (f64)reload_count : 0.0);
+    printf("most in use %.2fMB, over budget after %u frames, still in use by the renderer\n",
+           (f64)max_used / (f64)MB(1), over_budget_frame_count);
+    printf("blocks handed out %.2fMB, %.2fMB of it after the first round\n",
+           (f64)block_source.used / (f64)MB(1),
+           (f64)(block_source.used - source_used_after_first_round) / (f64)MB(1));
+    printf("loads that didn't match the first: %u\n", mismatch_count);
+    Assert(mismatch_count == 0);
+    Assert(cache->eviction_count > 0);
+
+    free(assets);
+    free(block_source_memory);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Atomic Arena
+//
+// Threads push BENCH_ATOMIC_ARENA_PUSH_SIZE bytes at a time, about a render
+// command, and write all of it. Three ways: a Memory_Arena behind a mutex,
+// an Atomic_Arena with every push an atomic add on used, and one with a
+// cursor per thread. Every push is checked afterwards to still hold what its
+// thread wrote, which it wouldn't if two pushes had overlapped. Each run is
+// in temporary memory, so the arena is rolled back in between. Both arenas
+// commit with an mprotect, and are decommitted before every run, so every
+// run pays for its commits.
+//
+
+#define BENCH_ATOMIC_ARENA_PUSH_COUNT   (1 << 21)
+#define BENCH_ATOMIC_ARENA_PUSH_SIZE    48
+#define BENCH_ATOMIC_ARENA_CHUNK_SIZE   KB(64)
+
+enum Bench_Atomic_Arena_Kind
+{
+    eBench_Atomic_Arena_Mutex,
+    eBench_Atomic_Arena_Add,
+    eBench_Atomic_Arena_Cursor,
+
+    eBench_Atomic_Arena_Count
+};
+
+struct Bench_Atomic_Arena_Params
+{
+    Bench_Atomic_Arena_Kind kind;
+    u32                     thread_idx;
+    u32                     push_count;
+    u64                     **pushes;
+
+    Atomic_Arena            *atomic_arena;
+    Memory_Arena            *arena;
+    pthread_mutex_t         *mutex;
+};
+
+internal void *
+bench_atomic_arena_proc(void *param)
+{
+    Bench_Atomic_Arena_Params *params = (Bench_Atomic_Arena_Params *)param;
+    u64 tag = (u64)params->thread_idx << 32;
+    for (u32 idx = 0;
+         idx < params->push_count;
+         ++idx)
+    {
+        u64 *push = 0;
+        switch (params->kind)
+        {
+            case eBench_Atomic_Arena_Mutex:
+            {
+                pthread_mutex_lock(params->mutex);
+                push = (u64 *)push_size(params->arena, BENCH_ATOMIC_ARENA_PUSH_SIZE);
+                pthread_mutex_unlock(params->mutex);
+            } break;
+
+            case eBench_Atomic_Arena_Add:
+            {
+                push = (u64 *)push_size_atomic(params->atomic_arena, ATOMIC_ARENA_NO_CURSOR, BENCH_ATOMIC_ARENA_PUSH_SIZE);
+            } break;
+
+            case eBench_Atomic_Arena_Cursor:
+            {
+                push = (u64 *)push_size_atomic(params->atomic_arena, params->thread_idx, BENCH_ATOMIC_ARENA_PUSH_SIZE);
+            } break;
+
+            INVALID_DEFAULT_CASE;
+        }
+
+        for (u32 word = 0;
+             word < BENCH_ATOMIC_ARENA_PUSH_SIZE / sizeof(u64);
+             ++word)
+        {
+            push[word] = tag | idx;
+        }
+        params->pushes[idx] = push;
+    }
+    return 0;
+}
+
+// NOTE: ns per push, 0 if any push got stepped on.
+internal f64
+bench_atomic_arena_run(Bench_Atomic_Arena_Kind kind, u32 thread_count,
+                       Atomic_Arena *atomic_arena, Memory_Arena *arena, u64 **pushes)
+{
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    Bench_Atomic_Arena_Params params[256];
+    u32 push_count = BENCH_ATOMIC_ARENA_PUSH_COUNT / thread_count;
+    for (u32 idx = 0; idx < thread_count; ++idx)
+    {
+        Bench_Atomic_Arena_Params *param = params + idx;
+        param->kind         = kind;
+        param->thread_idx   = idx;
+        param->push_count   = push_count;
+        param->pushes       = pushes + (size_t)idx * push_count;
+        param->atomic_arena = atomic_arena;
+        param->arena        = arena;
+        param->mutex        = &mutex;
+    }
+
+    bench_decommit_memory(atomic_arena->base, atomic_arena->size);
+    zero_size(atomic_arena->granule_count * sizeof(u32), (void *)atomic_arena->committed_granules);
+    bench_decommit_memory(arena->base, arena->size);
+    arena->committed = 0;
+    g_bench_commit_count = 0;
+
+    Atomic_Temporary_Memory atomic_memory = begin_atomic_temporary_memory(atomic_arena);
+    Temporary_Memory memory = begin_temporary_memory(arena);
+
+    u64 begin = bench_get_wall_clock();
+    bench_run_threads(thread_count, bench_atomic_arena_proc, params, sizeof(params[0]));
+    f64 seconds = bench_get_seconds_elapsed(begin, bench_get_wall_clock());
+
+    b32 ok = true;
+    for (u32 thread_idx = 0; thread_idx < thread_count; ++thread_idx)
+    {
+        u64 tag = (u64)thread_idx << 32;
+        for (u32 idx = 0; idx < push_count; ++idx)
+        {
+            u64 *push = params[thread_idx].pushes[idx];
+            ok &= (((u64)push & (ARENA_DEFAULT_ALIGNMENT - 1)) == 0);
+            for (u32 word = 0;
+                 word < BENCH_ATOMIC_ARENA_PUSH_SIZE / sizeof(u64);
+                 ++word)
+            {
+                ok &= (push[word] == (tag | idx));
+            }
+        }
+    }
+
+    end_temporary_memory(&memory);
+    end_atomic_temporary_memory(&atomic_memory);
+
+    f64 result = ok ? 1e9 * seconds / (f64)((u64)push_count * thread_count) : 0.0;
+    return result;
+}
+
+internal void
+bench_atomic_arena()
+{
+    u32 core_count = minimum(bench_get_core_count(), 256u);
+
+    // NOTE: room for every push, and a chunk per thread it retires early.
+    size_t arena_size = 2 * (size_t)BENCH_ATOMIC_ARENA_PUSH_COUNT * BENCH_ATOMIC_ARENA_PUSH_SIZE;
+    size_t block_source_size = arena_size + core_count * sizeof(Atomic_Arena_Cursor) + MB(1);
+    void *block_source_memory = bench_reserve_memory(block_source_size);
+    Memory_Block_Source block_source;
+    init_block_source(&block_source, block_source_memory, block_source_size, bench_mprotect_commit_memory);
+    Atomic_Arena atomic_arena;
+    init_atomic_arena(&atomic_arena, &block_source, arena_size, BENCH_ATOMIC_ARENA_CHUNK_SIZE, core_count);
+
+    void *arena_memory = bench_reserve_memory(arena_size);
+    Memory_Arena arena;
+    init_arena(&arena, arena_size, arena_memory, bench_mprotect_commit_memory, eArena_Commit_Lazy);
+    u64 **pushes = (u64 **)malloc(BENCH_ATOMIC_ARENA_PUSH_COUNT * sizeof(u64 *));
+
+    // NOTE: faulted in once, so the runs time the commits and not the faults.
+    bench_mprotect_commit_memory(atomic_arena.base, atomic_arena.size, false);
+    memset(atomic_arena.base, 0, atomic_arena.size);
+    bench_mprotect_commit_memory(arena.base, arena.size, false);
+    memset(arena.base, 0, arena.size);
+
+    printf("atomic_arena: %u pushes of %u bytes over all threads, ns per push, chunks of %lluKB\n",
+           BENCH_ATOMIC_ARENA_PUSH_COUNT, BENCH_ATOMIC_ARENA_PUSH_SIZE,
+           (unsigned long long)(BENCH_ATOMIC_ARENA_CHUNK_SIZE / 1024));
+    printf("%8s %10s %10s %10s\n", "threads", "mutex", "add", "cursor");
+    b32 ok = true;
+    u64 commit_counts[eBench_Atomic_Arena_Count] = {};
+    for (u32 thread_count = 1;
+         thread_count <= core_count;
+         ++thread_count)
+    {
+        printf("%8u", thread_count);
+        for (u32 kind = 0;
+             kind < eBench_Atomic_Arena_Count;
+             ++kind)
+        {
+            f64 best = 0.0;
+            for (u32 repeat = 0; repeat < 4; ++repeat)
+            {
+                f64 ns = bench_atomic_arena_run((Bench_Atomic_Arena_Kind)kind, thread_count,
+                                                &atomic_arena, &arena, pushes);
+                ok &= (ns != 0.0);
+                best = (repeat == 0) ? ns : minimum(best, ns);
+                commit_counts[kind] = maximum(commit_counts[kind], g_bench_commit_count);
+            }
+            printf(" %10.2f", best);
+        }
+        printf("\n");
+
+        // NOTE: rolled back after every run.
+        ok &= (atomic_arena.used == 0 && arena.used == 0);
+    }
+
+    printf("commits in a run, at most: %llu %llu %llu\n",
+           (unsigned long long)commit_counts[eBench_Atomic_Arena_Mutex],
+           (unsigned long long)commit_counts[eBench_Atomic_Arena_Add],
+           (unsigned long long)commit_counts[eBench_Atomic_Arena_Cursor]);
+    printf("pushes stepped on, or not rolled back: %s\n", ok ? "none" : "some");
+    Assert(ok);
+
+    free(pushes);
+    munmap(arena_memory, arena_size);
+    munmap(block_source_memory, block_source_size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Chunk Table
+//
+// Chunk lookups, World's open addressing table against the chained hashmap
+// it replaced (4096 buckets, x*16 + y*9 + z*4), kept here as it was. Three
+// worlds: the sim region game_update gathers every frame, a dense block of
+// neighbours, and chunks strewn over a big cube. Then a release_empty_chunks
+// that keeps half of the sparse world, to check deletion.
+//
+
+#define BENCH_CHUNK_LOOKUP_COUNT    (1 << 22)
+#define BENCH_CHUNK_SPARSE_COUNT    20000
+#define BENCH_CHUNK_SPARSE_EXTENT   2000
+
+struct Bench_Chained_Chunk
+{
+    s32                 x;
+    s32                 y;
+    s32                 z;
+    Bench_Chained_Chunk *next;
+};
+
+struct Bench_Chained_Hashmap
+{
+    Bench_Chained_Chunk *heads[4096];
+};
+
+inline u32
+bench_chained_hash(Chunk_Position pos)
+{
+    u32 result = ((pos.x * 16 + pos.y * 9 + pos.z * 4) & 4095);
+    return result;
+}
+
+internal Bench_Chained_Chunk *
+bench_chained_find(Bench_Chained_Hashmap *hashmap, Chunk_Position pos)
+{
+    Bench_Chained_Chunk *result = 0;
+    for (Bench_Chained_Chunk *chunk = hashmap->heads[bench_chained_hash(pos)];
+         chunk;
+         chunk = chunk->next)
+    {
+        if (chunk->x == pos.x && chunk->y == pos.y && chunk->z == pos.z)
+        {
+            result = chunk;
+            break;
+        }
+    }
+    return result;
+}
+
+internal void
+bench_chained_insert(Bench_Chained_Hashmap *hashmap, Memory_Arena *arena, Chunk_Position pos)
+{
+    Bench_Chained_Chunk *chunk = push_struct(arena, Bench_Chained_Chunk);
+    u32 bucket = bench_chained_hash(pos);
+    chunk->x    = pos.x;
+    chunk->y    = pos.y;
+    chunk->z    = pos.z;
+    chunk->next = hashmap->heads[bucket];
+    hashmap->heads[bucket] = chunk;
+}
+
+struct Bench_Chunk_World
+{
+    World                   *world;
+    Bench_Chained_Hashmap   *chained;
+    Chunk_Position          *positions;     // of every chunk in it.
+    u32                     count;
+};
+
+// NOTE: hits, looked up in the order positions has them, or misses, off by
+// one more than the extent in x.
+internal void
+bench_chunk_lookups(Bench_Chunk_World *bench_world, Chunk_Position *lookups, u32 lookup_count,
+                    b32 hits, f64 *table_ns, f64 *chained_ns, b32 *ok)
+{
+    u64 begin = bench_get_wall_clock();
+    u32 found = 0;
+    for (u32 idx = 0; idx < lookup_count; ++idx)
+    {
+        Chunk *chunk = find_chunk(bench_world->world, lookups[idx]);
+        found += (chunk && chunk->x == lookups[idx].x && chunk->y == lookups[idx].y && chunk->z == lookups[idx].z);
+    }
+    u64 end = bench_get_wall_clock();
+    *table_ns = 1e9 * bench_get_seconds_elapsed(begin, end) / (f64)lookup_count;
+    *ok &= (found == (hits ? lookup_count : 0));
+
+    begin = bench_get_wall_clock();
+    found = 0;
+    for (u32 idx = 0; idx < lookup_count; ++idx)
+    {
+        found += (bench_chained_find(bench_world->chained, lookups[idx]) != 0);
+    }
+    end = bench_get_wall_clock();
+    *chained_ns = 1e9 * bench_get_seconds_elapsed(begin, end) / (f64)lookup_count;
+    *ok &= (found == (hits ? lookup_count : 0));
+}
+
+internal void
+bench_chunk_print_table(const char *name, Bench_Chunk_World *bench_world,
+                        f64 table_hit, f64 chained_hit, f64 table_miss, f64 chained_miss)
+{
+    Chunk_Table *table = &bench_world->world->chunk_table;
+    u64 distance_sum = 0;
+    u32 longest = 0;
+    for (u32 idx = 0; idx < table->capacity; ++idx)
+    {
+        Chunk_Table_Slot *slot = table->slots + idx;
+        if (slot->chunk)
+        {
+            u32 distance = get_probe_distance(table, slot, idx);
+            distance_sum += distance;
+            longest = maximum(longest, distance);
+        }
+    }
+
+    u32 longest_chain = 0;
+    for (u32 bucket = 0; bucket < array_count(bench_world->chained->heads); ++bucket)
+    {
+        u32 length = 0;
+        for (Bench_Chained_Chunk *chunk = bench_world->chained->heads[bucket]; chunk; chunk = chunk->next)
+        {
+            ++length;
+        }
+        longest_chain = maximum(longest_chain, length);
+    }
+
+    printf("%-8s %6u %8u %6.2f %5u %8u %8.2f %8.2f %8.2f %8.2f\n", name,
+           bench_world->count, table->capacity, (f64)distance_sum / (f64)maximum(table->count, 1u),
+           longest, longest_chain, table_hit, chained_hit, table_miss, chained_miss);
+}
+
+internal void
+bench_chunk_add(Bench_Chunk_World *bench_world, Memory_Arena *arena, Chunk_Position pos)
+{
+    if (!find_chunk(bench_world->world, pos))
+    {
+        get_chunk(bench_world->world, pos);
+        bench_chained_insert(bench_world->chained, arena, pos);
+        bench_world->positions[bench_world->count++] = pos;
+    }
+}
+
+internal void
+bench_chunk_table()
+{
+    Memory_Arena arena;
+    bench_init_arena(&arena, MB(256));
+    Chunk_Position *lookups = push_array(&arena, Chunk_Position, BENCH_CHUNK_LOOKUP_COUNT);
+    Random_Series series = seed(1219);
+    b32 ok = true;
+
+    printf("chunk_table: %u lookups each, ns per lookup, distances are probe lengths\n", BENCH_CHUNK_LOOKUP_COUNT);
+    printf("%-8s %6s %8s %6s %5s %8s %8s %8s %8s %8s\n", "world", "chunks", "capacity",
+           "mean", "max", "chain", "hit", "chained", "miss", "chained");
+
+    Bench_Chunk_World sparse = {};
+    for (u32 world_idx = 0;
+         world_idx < 3;
+         ++world_idx)
+    {
+        Memory_Arena world_arena;
+        bench_init_arena(&world_arena, MB(16));
+        Bench_Chunk_World bench_world = {};
+        bench_world.world = push_struct(&world_arena, World);
+        init_world(bench_world.world, &world_arena, v3{10.0f, 3.0f, 10.0f});
+        bench_world.chained = push_struct(&arena, Bench_Chained_Hashmap);
+        bench_world.positions = push_array(&arena, Chunk_Position, BENCH_CHUNK_SPARSE_COUNT);
+
+        const char *name = 0;
+        if (world_idx == 0)
+        {
+            // what game_update gathers.
+            name = "region";
+            v3 chunk_dim = bench_world.world->chunk_dim;
+            v3 sim_dim = v3{100.0f, 5.0f, 50.0f};
+            Chunk_Position min_pos = {};
+            Chunk_Position max_pos = {};
+            min_pos.offset -= 0.5f * sim_dim;
+            max_pos.offset += 0.5f * sim_dim;
+            recalc_pos(&min_pos, chunk_dim);
+            recalc_pos(&max_pos, chunk_dim);
+            for (s32 z = min_pos.z; z <= max_pos.z; ++z)
+                for (s32 y = min_pos.y; y <= max_pos.y; ++y)
+                    for (s32 x = min_pos.x; x <= max_pos.x; ++x)
+                        bench_chunk_add(&bench_world, &arena, Chunk_Position{x, y, z});
+        }
+        else if (world_idx == 1)
+        {
+            name = "dense";
+            for (s32 z = -32; z < 32; ++z)
+                for (s32 y = -2; y < 2; ++y)
+                    for (s32 x = -32; x < 32; ++x)
+                        bench_chunk_add(&bench_world, &arena, Chunk_Position{x, y, z});
+        }
+        else
+        {
+            name = "sparse";
+            while (bench_world.count < BENCH_CHUNK_SPARSE_COUNT)
+            {
+                Chunk_Position pos = {};
+                pos.x = (s32)rand_range(&series, -BENCH_CHUNK_SPARSE_EXTENT, BENCH_CHUNK_SPARSE_EXTENT);
+                pos.y = (s32)rand_range(&series, -BENCH_CHUNK_SPARSE_EXTENT, BENCH_CHUNK_SPARSE_EXTENT);
+                pos.z = (s32)rand_range(&series, -BENCH_CHUNK_SPARSE_EXTENT, BENCH_CHUNK_SPARSE_EXTENT);
+                bench_chunk_add(&bench_world, &arena, pos);
+            }
+        }
+
+        // NOTE: the region is looked up in order.
+        for (u32 idx = 0; idx < BENCH_CHUNK_LOOKUP_COUNT; ++idx)
+        {
+            lookups[idx] = bench_world.positions[(world_idx == 0) ? (idx % bench_world.count) :
+                                                 (u32)rand_range(&series, 0.0f, (f32)bench_world.count - 0.5f)];
+        }
+        f64 table_hit, chained_hit, table_miss, chained_miss;
+        bench_chunk_lookups(&bench_world, lookups, BENCH_CHUNK_LOOKUP_COUNT, true, &table_hit, &chained_hit, &ok);
+        for (u32 idx = 0; idx < BENCH_CHUNK_LOOKUP_COUNT; ++idx)
+        {
+            lookups[idx].x += 2 * BENCH_CHUNK_SPARSE_EXTENT + 1;
+        }
+        bench_chunk_lookups(&bench_world, lookups, BENCH_CHUNK_LOOKUP_COUNT, false, &table_miss, &chained_miss, &ok);
+        bench_chunk_print_table(name, &bench_world, table_hit, chained_hit, table_miss, chained_miss);
+
+        if (world_idx == 2)
+        {
+            // NOTE: keeps the ones with x >= 0, every chunk is empty.
+            World *world = bench_world.world;
+            Chunk_Position min_pos = {0, -BENCH_CHUNK_SPARSE_EXTENT, -BENCH_CHUNK_SPARSE_EXTENT};
+            Chunk_Position max_pos = {BENCH_CHUNK_SPARSE_EXTENT, BENCH_CHUNK_SPARSE_EXTENT, BENCH_CHUNK_SPARSE_EXTENT};
+            u32 kept_count = 0;
+            for (u32 idx = 0; idx < bench_world.count; ++idx)
+            {
+                kept_count += (bench_world.positions[idx].x >= 0);
+            }
+            world->emptied_chunk_count = 1;
+            release_empty_chunks(world, min_pos, max_pos);
+
+            u32 wrong_count = (world->chunk_table.count != kept_count);
+            for (u32 idx = 0; idx < bench_world.count; ++idx)
+            {
+                Chunk_Position pos = bench_world.positions[idx];
+                Chunk *chunk = find_chunk(world, pos);
+                wrong_count += ((pos.x >= 0) != (chunk != 0));
+            }
+            printf("released %u of %u sparse chunks, %u looked up wrong after\n",
+                   bench_world.count - world->chunk_table.count, bench_world.count, wrong_count);
+            ok &= (wrong_count == 0);
+        }
+
+        free(world_arena.base);
+    }
+
+    printf("lookups that got the wrong chunk: %s\n", ok ? "none" : "some");
+    Assert(ok);
+
+    free(arena.base);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Entity Layout
+//
+// Sim steps over 100k xbots in the sim region, the entity store's columns
+// against entities as they were before it: one fat struct each, out of a
+// pool of cache-line slots, linked into lists per chunk and walked chunk by
+// chunk. Both integrate the same way on one thread, with the scalar kernel's
+// math and renormalize_axis, neither instrumented, so the layout is all
+// that's different, and they have to end up bit for bit the same. The fat
+// step is timed in its two passes too, relinking walks the old chunk's list
+// for every entity that left it.
+//
+
+#define BENCH_LAYOUT_ENTITY_COUNT   100'000
+#define BENCH_LAYOUT_STEP_COUNT     60
+#define BENCH_LAYOUT_ROUND_COUNT    8
+
+struct alignas(ARENA_CACHE_LINE) Bench_Fat_Entity
+{
+    Entity_Type         type;
+    Chunk_Position      chunk_pos;
+
+    v3                  world_translation;
+    qt                  world_rotation;
+    v3                  world_scaling;
+
+    v3                  prev_world_translation;
+    qt                  prev_world_rotation;
+
+    v3                  velocity;
+    v3                  accel;
+    f32                 u;
+    u32                 flags;
+
+    Animation_Channel   animation_channels[1];
+    m4x4                *animation_transform;
+
+    Bench_Fat_Entity    *next;
+
+    u32                 generation;
+    Bench_Fat_Entity    *next_free;
+};
+
+struct Bench_Fat_Chunk
+{
+    Bench_Fat_Entity    *head;
+};
+
+// NOTE: a grid over the region and a chunk around it, nothing gets further
+// than that; once out of the region it isn't updated.
+struct Bench_Fat_World
+{
+    Chunk_Position      min_pos;
+    Chunk_Position      max_pos;
+    v3i                 grid_min;
+    v3i                 grid_dim;
+    Bench_Fat_Chunk     *chunks;
+    Bench_Fat_Entity    *entities;
+};
+
+inline Bench_Fat_Chunk *
+bench_get_fat_chunk(Bench_Fat_World *world, Chunk_Position pos)
+{
+    s32 x = pos.x - world->grid_min.x;
+    s32 y = pos.y - world->grid_min.y;
+    s32 z = pos.z - world->grid_min.z;
+    Assert(x >= 0 && x < world->grid_dim.x &&
+           y >= 0 && y < world->grid_dim.y &&
+           z >= 0 && z < world->grid_dim.z);
+    Bench_Fat_Chunk *result = world->chunks + (z * world->grid_dim.y + y) * world->grid_dim.x + x;
+    return result;
+}
+
+inline Chunk_Position
+bench_get_fat_chunk_pos(Bench_Fat_World *world, Bench_Fat_Chunk *chunk)
+{
+    s32 idx = (s32)(chunk - world->chunks);
+    Chunk_Position result = {};
+    result.x = world->grid_min.x + idx % world->grid_dim.x;
+    result.y = world->grid_min.y + (idx / world->grid_dim.x) % world->grid_dim.y;
+    result.z = world->grid_min.z + idx / (world->grid_dim.x * world->grid_dim.y);
+    return result;
+}
+
+// update_entities, before the store.
+internal void
+bench_fat_integrate(Bench_Fat_World *world, f32 dt, v3 chunk_dim)
+{
+    for (s32 z = world->min_pos.z; z <= world->max_pos.z; ++z)
+    {
+        for (s32 y = world->min_pos.y; y <= world->max_pos.y; ++y)
+        {
+            for (s32 x = world->min_pos.x; x <= world->max_pos.x; ++x)
+            {
+                Bench_Fat_Chunk *chunk = bench_get_fat_chunk(world, Chunk_Position{x, y, z});
+                for (Bench_Fat_Entity *entity = chunk->head;
+                     entity != 0;
+                     entity = entity->next)
+                {
+                    entity->prev_world_translation  = entity->world_translation;
+                    entity->prev_world_rotation     = entity->world_rotation;
+
+                    Chunk_Position new_chunk_pos = entity->chunk_pos;
+                    f32 damping_factor = 4.0f;
+                    v3 accel                    = entity->accel - damping_factor * entity->velocity;
+                    entity->velocity            += dt * accel;
+                    entity->world_translation   += dt * entity->velocity;
+                    new_chunk_pos.offset        += dt * entity->velocity;
+                    renormalize_axis(&new_chunk_pos.offset.x, &new_chunk_pos.x, chunk_dim.x);
+                    renormalize_axis(&new_chunk_pos.offset.y, &new_chunk_pos.y, chunk_dim.y);
+                    renormalize_axis(&new_chunk_pos.offset.z, &new_chunk_pos.z, chunk_dim.z);
+                    entity->chunk_pos = new_chunk_pos;
+                }
+            }
+        }
+    }
+}
+
+// NOTE: unlinked by walking the old chunk's list, as map_entity_to_chunk did.
+internal void
+bench_fat_relink(Bench_Fat_World *world)
+{
+    for (s32 z = world->min_pos.z; z <= world->max_pos.z; ++z)
+    {
+        for (s32 y = world->min_pos.y; y <= world->max_pos.y; ++y)
+        {
+            for (s32 x = world->min_pos.x; x <= world->max_pos.x; ++x)
+            {
+                Bench_Fat_Chunk *chunk = bench_get_fat_chunk(world, Chunk_Position{x, y, z});
+                Bench_Fat_Entity *next = 0;
+                for (Bench_Fat_Entity *entity = chunk->head;
+                     entity != 0;
+                     entity = next)
+                {
+                    next = entity->next;
+                    Chunk_Position pos = entity->chunk_pos;
+                    if (pos.x != x || pos.y != y || pos.z != z)
+                    {
+                        for (Bench_Fat_Entity **link = &chunk->head;
+                             *link;
+                             link = &(*link)->next)
+                        {
+                            if (*link == entity)
+                            {
+                                *link = entity->next;
+                                break;
+                            }
+                        }
+                        Bench_Fat_Chunk *new_chunk = bench_get_fat_chunk(world, pos);
+                        entity->next = new_chunk->head;
+                        new_chunk->head = entity;
+                    }
+                }
+            }
+        }
+    }
+}
+
+internal void
+bench_entity_layout()
+{
+    Memory_Arena arena;
+    bench_init_arena(&arena, MB(256));
+    Random_Series series = seed(1219);
+
+    Game_State *game_state = push_struct(&arena, Game_State);
+    bench_init_arena(&game_state->world_arena, MB(128));
+    game_state->world = push_struct(&game_state->world_arena, World);
+    World *world = game_state->world;
+    init_world(world, &game_state->world_arena, v3{10.0f, 3.0f, 10.0f});
+    Entity_Store *store = &world->entities;
+    v3 chunk_dim = world->chunk_dim;
+
+    v3 sim_dim = v3{100.0f, 5.0f, 50.0f};
+    Chunk_Position min_pos = {};
+    Chunk_Position max_pos = {};
+    min_pos.offset -= 0.5f * sim_dim;
+    max_pos.offset += 0.5f * sim_dim;
+    recalc_pos(&min_pos, chunk_dim);
+    recalc_pos(&max_pos, chunk_dim);
+
+    Bench_Fat_World fat = {};
+    fat.min_pos     = min_pos;
+    fat.max_pos     = max_pos;
+    fat.grid_min    = v3i{min_pos.x - 1, min_pos.y - 1, min_pos.z - 1};
+    fat.grid_dim    = v3i{max_pos.x - min_pos.x + 3, max_pos.y - min_pos.y + 3, max_pos.z - min_pos.z + 3};
+    u32 grid_count  = (u32)(fat.grid_dim.x * fat.grid_dim.y * fat.grid_dim.z);
+    fat.chunks      = push_array(&arena, Bench_Fat_Chunk, grid_count);
+    fat.entities    = push_array(&arena, Bench_Fat_Entity, BENCH_LAYOUT_ENTITY_COUNT, ARENA_CACHE_LINE);
+    zero_array(grid_count, fat.chunks);
+    Entity_Handle *handles = push_array(&arena, Entity_Handle, BENCH_LAYOUT_ENTITY_COUNT);
+
+    // NOTE: accel keeps them going against the damping, so they cross chunks.
+    for (u32 idx = 0; idx < BENCH_LAYOUT_ENTITY_COUNT; ++idx)
+    {
+        Chunk_Position pos = {};
+        pos.offset = v3{rand_bilateral(&series) * 0.5f * sim_dim.x,
+                        rand_bilateral(&series) * 0.5f * sim_dim.y,
+                        rand_bilateral(&series) * 0.5f * sim_dim.z};
+        recalc_pos(&pos, chunk_dim);
+        v3 velocity = v3{rand_bilateral(&series), 0.0f, rand_bilateral(&series)};
+        v3 accel    = v3{4.0f * rand_bilateral(&series), 0.0f, 4.0f * rand_bilateral(&series)};
+
+        handles[idx] = push_entity(world, Entity_Type::XBOT, pos);
+        u32 entity = get_entity(store, handles[idx]);
+        set_split(store->velocity, entity, velocity);
+        set_split(store->accel, entity, accel);
+
+        Bench_Fat_Entity *fat_entity = fat.entities + idx;
+        zero_struct(*fat_entity);
+        fat_entity->type                    = Entity_Type::XBOT;
+        fat_entity->chunk_pos               = pos;
+        fat_entity->world_translation       = get_split(store->world_translation, entity);
+        fat_entity->world_rotation          = store->world_rotation[entity];
+        fat_entity->world_scaling           = store->world_scaling[entity];
+        fat_entity->prev_world_translation  = fat_entity->world_translation;
+        fat_entity->prev_world_rotation     = fat_entity->world_rotation;
+        fat_entity->velocity                = velocity;
+        fat_entity->accel                   = accel;
+        fat_entity->u                       = store->u[entity];
+        Bench_Fat_Chunk *fat_chunk = bench_get_fat_chunk(&fat, pos);
+        fat_entity->next = fat_chunk->head;
+        fat_chunk->head = fat_entity;
+    }
+
+    // NOTE: SIMD is bench integrate's business.
+    Integrate_Params integrate = bench_get_integrate_params(chunk_dim, min_pos, max_pos);
+    integrate.kernel = eIntegrate_Kernel_Scalar;
+    f32 dt = integrate.dt;
+    f64 fat_best = 1e30;
+    f64 fat_integrate_best = 1e30;
+    f64 fat_relink_best = 1e30;
+    f64 store_best = 1e30;
+    for (u32 round = 0;
+         round < BENCH_LAYOUT_ROUND_COUNT;
+         ++round)
+    {
+        f64 fat_integrate = 0.0;
+        f64 fat_relink = 0.0;
+        for (u32 step = 0; step < BENCH_LAYOUT_STEP_COUNT; ++step)
+        {
+            u64 begin = bench_get_wall_clock();
+            bench_fat_integrate(&fat, dt, chunk_dim);
+            u64 integrated = bench_get_wall_clock();
+            bench_fat_relink(&fat);
+            u64 end = bench_get_wall_clock();
+            fat_integrate += bench_get_seconds_elapsed(begin, integrated);
+            fat_relink += bench_get_seconds_elapsed(integrated, end);
+        }
+        fat_best = minimum(fat_best, fat_integrate + fat_relink);
+        fat_integrate_best = minimum(fat_integrate_best, fat_integrate);
+        fat_relink_best = minimum(fat_relink_best, fat_relink);
+
+        // NOTE: update_entities is instrumented, and nobody collates here.
+        u64 begin = bench_get_wall_clock();
+        for (u32 step = 0; step < BENCH_LAYOUT_STEP_COUNT; ++step)
+        {
+            update_entities(game_state, 0, &integrate);
+            g_debug_table->event_array_idx_event_idx = 0;
+        }
+        u64 end = bench_get_wall_clock();
+        store_best = minimum(store_best, bench_get_seconds_elapsed(begin, end));
+    }
+
+    u32 mismatch_count = 0;
+    for (u32 idx = 0; idx < BENCH_LAYOUT_ENTITY_COUNT; ++idx)
+    {
+        Bench_Fat_Entity *fat_entity = fat.entities + idx;
+        u32 entity = get_entity(store, handles[idx]);
+        Chunk_Position pos = get_chunk_pos(store, entity);
+        v3 world_translation = get_split(store->world_translation, entity);
+        v3 prev_world_translation = get_split(store->prev_world_translation, entity);
+        v3 velocity = get_split(store->velocity, entity);
+        b32 same = (memcmp(&pos.xyz, &fat_entity->chunk_pos.xyz, sizeof(pos.xyz)) == 0 &&
+                    memcmp(&pos.offset, &fat_entity->chunk_pos.offset, sizeof(pos.offset)) == 0 &&
+                    memcmp(&world_translation, &fat_entity->world_translation, sizeof(v3)) == 0 &&
+                    memcmp(&prev_world_translation, &fat_entity->prev_world_translation, sizeof(v3)) == 0 &&
+                    memcmp(&velocity, &fat_entity->velocity, sizeof(v3)) == 0);
+        mismatch_count += !same;
+    }
+    for (u32 idx = 0; idx < grid_count; ++idx)
+    {
+        u32 fat_count = 0;
+        for (Bench_Fat_Entity *entity = fat.chunks[idx].head; entity; entity = entity->next)
+        {
+            ++fat_count;
+        }
+        Chunk *chunk = find_chunk(world, bench_get_fat_chunk_pos(&fat, fat.chunks + idx));
+        mismatch_count += (fat_count != (chunk ? chunk->entity_count : 0));
+    }
+
+    f64 step_entity_count = (f64)BENCH_LAYOUT_STEP_COUNT * (f64)BENCH_LAYOUT_ENTITY_COUNT;
+    printf("entity_layout: %u xbots over %u chunks, %u steps, best of %u, one thread\n",
+           BENCH_LAYOUT_ENTITY_COUNT, world->chunk_table.count, BENCH_LAYOUT_STEP_COUNT, BENCH_LAYOUT_ROUND_COUNT);
+    printf("fat structs, chunk lists  %7.2fms a step %6.2fns an entity (%u bytes each)\n",
+           1000.0 * fat_best / BENCH_LAYOUT_STEP_COUNT, 1e9 * fat_best / step_entity_count,
+           (u32)sizeof(Bench_Fat_Entity));
+    printf("  integrating             %7.2fms a step %6.2fns an entity\n",
+           1000.0 * fat_integrate_best / BENCH_LAYOUT_STEP_COUNT, 1e9 * fat_integrate_best / step_entity_count);
+    printf("  relinking               %7.2fms a step %6.2fns an entity\n",
+           1000.0 * fat_relink_best / BENCH_LAYOUT_STEP_COUNT, 1e9 * fat_relink_best / step_entity_count);
+    printf("store columns, scalar     %7.2fms a step %6.2fns an entity (%u bytes each, over all columns)\n",
+           1000.0 * store_best / BENCH_LAYOUT_STEP_COUNT, 1e9 * store_best / step_entity_count,
+           (u32)bench_get_entity_size());
+    printf("%.2fx, %.2fx against integrating alone, entities or chunk counts that came out different: %u\n",
+           fat_best / store_best, fat_integrate_best / store_best, mismatch_count);
+    Assert(mismatch_count == 0);
+
+    free(game_state->world_arena.base);
+    free(arena.base);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Integrate
+//
+// integrate_movers' kernels over the same 100k movers, one thread, each
+// round from the same start. A tenth start out of the region, some faster
+// than the max speed, some at -0 offsets, and the count isn't a multiple of
+// 8, so every kernel goes through its masking, clamping and tail. The second
+// run takes steps long enough to cross several chunks at once. Every kernel
+// has to end up bit for bit where the scalar one does.
+//
+
+#define BENCH_INTEGRATE_COUNT       100'003
+#define BENCH_INTEGRATE_STEP_COUNT  60
+#define BENCH_INTEGRATE_ROUND_COUNT 8
+
+internal void
+bench_init_integrate_store(Entity_Store *store, Memory_Arena *arena, v3 chunk_dim,
+                           Chunk_Position min_pos, Chunk_Position max_pos)
+{
+    Random_Series series = seed(1219);
+    init_entity_store(store, arena, BENCH_INTEGRATE_COUNT);
+    for (u32 idx = 0; idx < BENCH_INTEGRATE_COUNT; ++idx)
+    {
+        u32 entity = add_entity(store, Entity_Type::XBOT);
+        v3i coord = v3i{min_pos.x + (s32)rand_range(&series, 0.0f, (f32)(max_pos.x - min_pos.x) + 0.99f),
+                        min_pos.y + (s32)rand_range(&series, 0.0f, (f32)(max_pos.y - min_pos.y) + 0.99f),
+                        min_pos.z + (s32)rand_range(&series, 0.0f, (f32)(max_pos.z - min_pos.z) + 0.99f)};
+        if (idx % 10 == 0)
+        {
+            coord.x = max_pos.x + 2;
+        }
+        v3 offset = v3{rand_bilateral(&series) * 0.49f * chunk_dim.x,
+                       rand_bilateral(&series) * 0.49f * chunk_dim.y,
+                       rand_bilateral(&series) * 0.49f * chunk_dim.z};
+        if (idx % 7 == 0)
+        {
+            offset.y = -0.0f;
+        }
+        set_split(store->chunk_coord, entity, coord);
+        set_split(store->chunk_offset, entity, offset);
+        set_split(store->world_translation, entity, v3{coord.x * chunk_dim.x + offset.x,
+                                                       coord.y * chunk_dim.y + offset.y,
+                                                       coord.z * chunk_dim.z + offset.z});
+        set_split(store->velocity, entity, 30.0f * v3{rand_bilateral(&series), rand_bilateral(&series), rand_bilateral(&series)});
+        set_split(store->accel, entity, 50.0f * v3{rand_bilateral(&series), rand_bilateral(&series), rand_bilateral(&series)});
+        f32 theta = rand_range(&series, 0.0f, pi32);
+        store->world_rotation[entity] = _qt_(cos(theta), 0, sin(theta), 0);
+    }
+}
+
+internal void
+bench_copy_integrate_store(Entity_Store *dst, Entity_Store *src)
+{
+    u32 count = src->count;
+    Split_v3 *dst_columns[] = {&dst->chunk_offset, &dst->world_translation, &dst->prev_world_translation,
+                               &dst->velocity, &dst->accel};
+    Split_v3 *src_columns[] = {&src->chunk_offset, &src->world_translation, &src->prev_world_translation,
+                               &src->velocity, &src->accel};
+    for (u32 column = 0; column < array_count(dst_columns); ++column)
+    {
+        copy_memory(dst_columns[column]->x, src_columns[column]->x, count * sizeof(f32));
+        copy_memory(dst_columns[column]->y, src_columns[column]->y, count * sizeof(f32));
+        copy_memory(dst_columns[column]->z, src_columns[column]->z, count * sizeof(f32));
+    }
+    copy_memory(dst->chunk_coord.x, src->chunk_coord.x, count * sizeof(s32));
+    copy_memory(dst->chunk_coord.y, src->chunk_coord.y, count * sizeof(s32));
+    copy_memory(dst->chunk_coord.z, src->chunk_coord.z, count * sizeof(s32));
+    copy_memory(dst->world_rotation, src->world_rotation, count * sizeof(qt));
+    copy_memory(dst->prev_world_rotation, src->prev_world_rotation, count * sizeof(qt));
+}
+
+// NOTE: how many movers differ from expected in anything the kernels write.
+internal u32
+bench_count_integrate_mismatches(Entity_Store *store, Entity_Store *expected)
+{
+    u32 result = 0;
+    for (u32 idx = 0; idx < store->count; ++idx)
+    {
+        v3i coord = get_split(store->chunk_coord, idx);
+        v3i expected_coord = get_split(expected->chunk_coord, idx);
+        v3 columns[4] = {get_split(store->chunk_offset, idx), get_split(store->world_translation, idx),
+                         get_split(store->prev_world_translation, idx), get_split(store->velocity, idx)};
+        v3 expected_columns[4] = {get_split(expected->chunk_offset, idx), get_split(expected->world_translation, idx),
+                                  get_split(expected->prev_world_translation, idx), get_split(expected->velocity, idx)};
+        b32 same = (memcmp(&coord, &expected_coord, sizeof(coord)) == 0 &&
+                    memcmp(columns, expected_columns, sizeof(columns)) == 0 &&
+                    memcmp(store->prev_world_rotation + idx, expected->prev_world_rotation + idx, sizeof(qt)) == 0);
+        result += !same;
+    }
+    return result;
+}
+
+internal void
+bench_integrate()
+{
+    Memory_Arena arena;
+    bench_init_arena(&arena, MB(256));
+    v3 chunk_dim = v3{10.0f, 3.0f, 10.0f};
+
+    v3 sim_dim = v3{100.0f, 5.0f, 50.0f};
+    Chunk_Position min_pos = {};
+    Chunk_Position max_pos = {};
+    min_pos.offset -= 0.5f * sim_dim;
+    max_pos.offset += 0.5f * sim_dim;
+    recalc_pos(&min_pos, chunk_dim);
+    recalc_pos(&max_pos, chunk_dim);
+
+    const char *kernel_names[] = {"", "scalar", "sse", "avx2"};
+    u32 kernel_count = cpu_has_avx2() ? eIntegrate_Kernel_Count : eIntegrate_Kernel_AVX2;
+    b32 ok = true;
+
+    printf("integrate: %u movers, %u steps, best of %u, one thread%s\n",
+           BENCH_INTEGRATE_COUNT, BENCH_INTEGRATE_STEP_COUNT, BENCH_INTEGRATE_ROUND_COUNT,
+           cpu_has_avx2() ? "" : ", no avx2 here");
+    for (u32 run = 0;
+         run < 2;
+         ++run)
+    {
+        Integrate_Params params = {};
+        params.dt           = (run == 0) ? (1.0f / 60.0f) : 0.5f;
+        params.gravity      = 9.8f;
+        params.drag         = (run == 0) ? 0.5f : 4.0f;
+        params.max_speed    = (run == 0) ? 20.0f : 40.0f;
+        params.chunk_dim    = chunk_dim;
+        params.min_pos      = min_pos;
+        params.max_pos      = max_pos;
+        printf("dt %.4f, max speed %.0f:\n", params.dt, params.max_speed);
+
+        Temporary_Memory run_memory = begin_temporary_memory(&arena);
+        Entity_Store start;
+        bench_init_integrate_store(&start, &arena, chunk_dim, min_pos, max_pos);
+        Entity_Store *stores = push_array(&arena, Entity_Store, eIntegrate_Kernel_Count);
+        f64 scalar_ns = 0.0;
+        for (u32 kernel = eIntegrate_Kernel_Scalar;
+             kernel < kernel_count;
+             ++kernel)
+        {
+            Entity_Store *store = stores + kernel;
+            bench_init_integrate_store(store, &arena, chunk_dim, min_pos, max_pos);
+            params.kernel = (Integrate_Kernel)kernel;
+
+            f64 best = 1e30;
+            for (u32 round = 0; round < BENCH_INTEGRATE_ROUND_COUNT; ++round)
+            {
+                bench_copy_integrate_store(store, &start);
+                u64 begin = bench_get_wall_clock();
+                for (u32 step = 0; step < BENCH_INTEGRATE_STEP_COUNT; ++step)
+                {
+                    integrate_movers(store, 0, store->mover_count, &params);
+                }
+                best = minimum(best, bench_get_seconds_elapsed(begin, bench_get_wall_clock()));
+            }
+
+            f64 ns = 1e9 * best / ((f64)BENCH_INTEGRATE_STEP_COUNT * (f64)BENCH_INTEGRATE_COUNT);
+            if (kernel == eIntegrate_Kernel_Scalar)
+            {
+                scalar_ns = ns;
+                u32 clamped_count = 0;
+                u32 crossed_count = 0;
+                for (u32 idx = 0; idx < start.count; ++idx)
+                {
+                    clamped_count += (len(get_split(store->velocity, idx)) > 0.999f * params.max_speed);
+                    crossed_count += (start.chunk_coord.x[idx] != store->chunk_coord.x[idx] ||
+                                      start.chunk_coord.y[idx] != store->chunk_coord.y[idx] ||
+                                      start.chunk_coord.z[idx] != store->chunk_coord.z[idx]);
+                }
+                printf("  %u at the max speed and %u in another chunk at the end\n", clamped_count, crossed_count);
+            }
+            u32 mismatch_count = bench_count_integrate_mismatches(store, stores + eIntegrate_Kernel_Scalar);
+            ok &= (mismatch_count == 0);
+            printf("  %-8s %7.3fms a step %6.2fns a mover %5.2fx, %u not bit for bit the scalar\n",
+                   kernel_names[kernel], 1e-6 * ns * BENCH_INTEGRATE_COUNT, ns, scalar_ns / ns, mismatch_count);
+        }
+        end_temporary_memory(&run_memory);
+    }
+
+    Assert(ok);
+    free(arena.base);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Atomics
+//
+
+#define BENCH_ATOMIC_ADD_COUNT  10000000
+
+global_var u64 volatile g_bench_atomic_counter;
+
+struct Bench_Atomic_Params
+{
+    Memory_Order    order;
+    u32             add_count;
+};
+
+internal void *
+bench_atomic_add_proc(void *param)
+{
+    Bench_Atomic_Params *params = (Bench_Atomic_Params *)param;
+    for (u32 idx = 0; idx < params->add_count; ++idx)
+    {
+        atomic_add_u64(&g_bench_atomic_counter, 1, params->order);
+    }
+    return 0;
+}
+
+internal f64
+bench_atomic_add(u32 thread_count, Memory_Order order)
+{
+    Bench_Atomic_Params params[256];
+    for (u32 idx = 0; idx < thread_count; ++idx)
+    {
+        params[idx].order       = order;
+        params[idx].add_count   = BENCH_ATOMIC_ADD_COUNT / thread_count;
+    }
+
+    g_bench_atomic_counter = 0;
+    u64 begin = bench_get_wall_clock();
+    bench_run_threads(thread_count, bench_atomic_add_proc, params, sizeof(params[0]));
+    f64 seconds = bench_get_seconds_elapsed(begin, bench_get_wall_clock());
+
+    u64 add_count = (u64)params[0].add_count * thread_count;
+    Assert(g_bench_atomic_counter == add_count);
+    f64 result = 1000000000.0 * seconds / (f64)add_count;
+    return result;
+}
+
+internal void
+bench_atomics()
+{
+    u32 core_count = bench_get_core_count();
+
+    printf("atomics: shared counter increments, ns per add\n");
+    printf("%8s %12s %12s\n", "threads", "seq_cst", "relaxed");
+    for (u32 thread_count = 1;
+         thread_count <= core_count;
+         ++thread_count)
+    {
+        f64 seq_cst = bench_atomic_add(thread_count, eMemory_Order_Seq_Cst);
+        f64 relaxed = bench_atomic_add(thread_count, eMemory_Order_Relaxed);
+        printf("%8u %12.2f %12.2f\n", thread_count, seq_cst, relaxed);
+    }
+
+    // NOTE: what an instrumented hot path pays per TIMED_BLOCK, i.e. two events.
+    u32 block_count = array_count(g_debug_table->events[0]) / 2;
+    u32 round_count = 64;
+    u64 begin = bench_get_wall_clock();
+    for (u32 round = 0; round < round_count; ++round)
+    {
+        for (u32 idx = 0; idx < block_count; ++idx)
+        {
+            TIMED_BLOCK(bench_timed_block);
+        }
+        g_debug_table->event_array_idx_event_idx = 0;
+    }
+    f64 seconds = bench_get_seconds_elapsed(begin, bench_get_wall_clock());
+    printf("\natomics: TIMED_BLOCK, %.2f ns per block\n",
+           1000000000.0 * seconds / ((f64)block_count * round_count));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct Bench
+{
+    const char  *name;
+    void        (*proc)();
+};
+
+global_var Bench g_benches[] =
+{
+    {"atomics",         bench_atomics},
+    {"work_queue",      bench_work_queue},
+    {"job_system",      bench_job_system},
+    {"parallel_for",    bench_parallel_for},
+    {"alignment",       bench_alignment},
+    {"memory",          bench_memory},
+    {"pool",            bench_pool},
+    {"asset_cache",     bench_asset_cache},
+    {"atomic_arena",    bench_atomic_arena},
+    {"chunk_table",     bench_chunk_table},
+    {"entity_layout",   bench_entity_layout},
+    {"integrate",       bench_integrate},
+};
+
+int
+main(int argc, char **argv)
+{
+    if (argc > 2)
+    {
+        g_bench_max_threads = (u32)atoi(argv[2]);
+    }
+
+    b32 found = false;
+    for (u32 idx = 0;
+         idx < array_count(g_benches);
+         ++idx)
+    {
+        Bench *bench = g_benches + idx;
+        if (argc < 2 ||
+            strcmp(argv[1], "all") == 0 ||
+            strcmp(argv[1], bench->name) == 0)
+        {
+            bench->proc();
+            printf("\n");
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        fprintf(stderr, "unknown benchmark %s. one of:\n", argv[1]);
+        for (u32 idx = 0; idx < array_count(g_benches); ++idx)
+        {
+            fprintf(stderr, "  %s\n", g_benches[idx].name);
+        }
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,26 @@
+#!/bin/sh
+
+CCFLAGS="-O2 -g -fno-exceptions -fno-rtti -msse4.1 -D_GNU_SOURCE"
+# NOTE: same warnings build.bat turns off with -W4 -wd..., plus the idioms
+# MSVC never warns about (string literals as char *, partial switches).
+CCFLAGS="$CCFLAGS -Wall -Wextra -Wno-unused-parameter -Wno-unused-variable -Wno-unused-but-set-variable"
+CCFLAGS="$CCFLAGS -Wno-unused-function -Wno-write-strings -Wno-switch -Wno-missing-field-initializers"
+CCFLAGS="$CCFLAGS -Wno-char-subscripts"
+CCFLAGS="-D__DEVELOPER=1 -D__LLVM=1 $CCFLAGS"
+CLFLAGS="-ldl -lpthread"
+
+mkdir -p ../build
+cd ../build
+
+# Simple Preprocessor
+g++ $CCFLAGS ../src/simple_preprocessor.cpp -o simple_preprocessor
+(cd ../src && ../build/simple_preprocessor > generated.h)
+
+# game code
+g++ $CCFLAGS -shared -fPIC ../src/game.cpp -o game.so
+
+# linux layer (headless)
+g++ $CCFLAGS ../src/linux.cpp -o linux $CLFLAGS
+
+# benchmarks
+g++ $CCFLAGS ../src/bench.cpp -o bench $CLFLAGS
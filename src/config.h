@@ -1,4 +1,12 @@
-#define GlobalConstants_Xbot_Accel_Constant 2000.0f
+#define GlobalConstants_Xbot_Accel_Constant 33.333332f
 #define GlobalConstants_Xbot_Animation_Speed 1.000000f
 #define GlobalConstants_Render_DrawStar 0
 #define GlobalConstants_Render_DrawGrass 0
+#define GlobalConstants_Sim_Step_Hz 60.000000f
+#define GlobalConstants_Sim_Gravity 0.000000f
+#define GlobalConstants_Sim_Drag 4.000000f
+#define GlobalConstants_Sim_Max_Speed 20.000000f
+#define GlobalConstants_Sim_Kernel 0
+#define GlobalConstants_Memory_Thread_Scratch_KB 1024
+#define GlobalConstants_Memory_Asset_Budget_KB 16384
+#define GlobalConstants_Memory_DrawAllocations 0
@@ -11,7 +11,7 @@
 
 #include "debug.h"
 
-inline b32 arena_has_room_for(Memory_Arena *arena, size_t size);
+inline b32 arena_has_room_for(Memory_Arena *arena, size_t size, size_t alignment);
 
 inline b32
 debug_ids_are_equal(Debug_ID a, Debug_ID b)
@@ -1525,6 +1525,111 @@ get_element_from_event(Debug_State *debug_state, Debug_Event *event)
     return result;
 }
 
+//
+// Allocations
+//
+global_var char *g_debug_arena_tag_names[eArena_Tag_Count] =
+{
+    "untagged",
+    "world",
+    "transient",
+    "render",
+    "asset",
+    "thread scratch",
+};
+
+// NOTE: open addressing on the guid, which is a string literal, so the
+// address is enough. 0 once the table is 3/4 full.
+internal Debug_Allocation_Site *
+get_allocation_site(Debug_State *debug_state, char *guid, u32 arena_tag)
+{
+    Debug_Allocation_Site *result = 0;
+
+    u32 mask = DEBUG_ALLOCATION_SITE_COUNT - 1;
+    u32 hash = (u32)((((u64)guid >> 3) + arena_tag) * 2654435761u);
+    for (u32 probe = 0;
+         probe < DEBUG_ALLOCATION_SITE_COUNT;
+         ++probe)
+    {
+        Debug_Allocation_Site *site = debug_state->allocation_sites + ((hash + probe) & mask);
+        if (site->guid == guid && site->arena_tag == arena_tag)
+        {
+            result = site;
+            break;
+        }
+        else if (!site->guid)
+        {
+            if (debug_state->allocation_site_count < (3 * DEBUG_ALLOCATION_SITE_COUNT) / 4)
+            {
+                ++debug_state->allocation_site_count;
+                site->guid      = guid;
+                site->arena_tag = arena_tag;
+                result = site;
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+internal void
+collate_allocation(Debug_State *debug_state, Debug_Event *event)
+{
+    Debug_Allocation *allocation = &event->value_Debug_Allocation;
+    Assert(allocation->arena_tag < eArena_Tag_Count);
+
+    Debug_Allocation_Arena *arena = debug_state->allocation_arenas + allocation->arena_tag;
+    arena->frame_size += allocation->size;
+    arena->total_size += allocation->size;
+    ++arena->frame_count;
+
+    Debug_Allocation_Site *site = get_allocation_site(debug_state, event->guid, allocation->arena_tag);
+    if (site)
+    {
+        site->frame_size += allocation->size;
+        site->total_size += allocation->size;
+        ++site->frame_count;
+        ++site->total_count;
+    }
+}
+
+internal void
+end_allocation_frame(Debug_State *debug_state)
+{
+    for (u32 site_idx = 0;
+         site_idx < DEBUG_ALLOCATION_SITE_COUNT;
+         ++site_idx)
+    {
+        Debug_Allocation_Site *site = debug_state->allocation_sites + site_idx;
+        site->last_frame_size   = site->frame_size;
+        site->last_frame_count  = site->frame_count;
+        site->frame_size        = 0;
+        site->frame_count       = 0;
+    }
+
+    for (u32 tag = 0;
+         tag < eArena_Tag_Count;
+         ++tag)
+    {
+        Debug_Allocation_Arena *arena = debug_state->allocation_arenas + tag;
+        arena->last_frame_size  = arena->frame_size;
+        arena->last_frame_count = arena->frame_count;
+        arena->history[debug_state->allocation_history_idx] = arena->frame_size;
+        arena->frame_size       = 0;
+        arena->frame_count      = 0;
+    }
+    debug_state->allocation_history_idx = (debug_state->allocation_history_idx + 1) % DEBUG_ALLOCATION_HISTORY;
+}
+
+// NOTE: the sites point into the game code that was unloaded.
+internal void
+reset_allocation_sites(Debug_State *debug_state)
+{
+    debug_state->allocation_site_count = 0;
+    zero_array(DEBUG_ALLOCATION_SITE_COUNT, debug_state->allocation_sites);
+}
+
 internal void
 collate_debug_records(Debug_State *debug_state, u32 event_count, Debug_Event *event_array)
 {
@@ -1533,6 +1638,12 @@ collate_debug_records(Debug_State *debug_state, u32 event_count, Debug_Event *ev
          ++event_idx)
     {
         Debug_Event *event = event_array + event_idx;
+        if (event->type == eDebug_Type_Allocation)
+        {
+            collate_allocation(debug_state, event);
+            continue;
+        }
+
         Debug_Element *element = get_element_from_event(debug_state, event);
 
         if (!debug_state->collation_frame)
@@ -1550,6 +1661,7 @@ collate_debug_records(Debug_State *debug_state, u32 event_count, Debug_Event *ev
 
             debug_state->collation_frame->end_clock = event->clock;
             debug_state->collation_frame->wall_seconds_elapsed = event->value_f32;
+            end_allocation_frame(debug_state);
 
             f32 clock_range = (f32)(debug_state->collation_frame->end_clock - debug_state->collation_frame->begin_clock);
 #if 0
@@ -1744,8 +1856,13 @@ debug_start(Debug_State *debug_state, Game_Assets *game_assets, u32 width, u32 h
 
         Camera *debug_overlay_camera = push_camera(&debug_state->debug_arena, eCamera_Type_Orthographic, (f32)width, (f32)height,
                                                    0.0f, 0.0f, 500.0f);
-        debug_state->render_group = alloc_render_group(&debug_state->debug_arena, MB(16),
-                                                       debug_overlay_camera);
+        for (u32 idx = 0;
+             idx < array_count(debug_state->render_groups);
+             ++idx)
+        {
+            debug_state->render_groups[idx] = alloc_render_group(&debug_state->debug_arena, MB(8),
+                                                                 debug_overlay_camera);
+        }
 
         debug_state->font = &game_assets->debug_font;
 
@@ -1757,6 +1874,7 @@ debug_start(Debug_State *debug_state, Game_Assets *game_assets, u32 width, u32 h
         add_tree(debug_state, debug_state->root_group, _v2_(0.0f, (f32)height));
     }
 
+    debug_state->render_group = debug_state->render_groups[g_debug_memory->render_slot];
     begin_render(debug_state->render_group);
 
     debug_state->left_edge = 0.0f;
@@ -1838,6 +1956,143 @@ debug_dump_struct(u32 member_count, Member_Definition *member_defs, void *struct
     }
 };
 
+// "file(line)" out of a site's guid, "path/file(line).counter".
+internal void
+get_allocation_site_label(char *guid, char *dest, size_t dest_size)
+{
+    char *begin = guid;
+    for (char *at = guid; *at; ++at)
+    {
+        if (*at == '/' || *at == '\\')
+        {
+            begin = at + 1;
+        }
+    }
+
+    size_t length = 0;
+    for (char *at = begin;
+         *at && length + 1 < dest_size;
+         ++at)
+    {
+        dest[length++] = *at;
+        if (*at == ')')
+        {
+            break;
+        }
+    }
+    dest[length] = 0;
+}
+
+#define DEBUG_ALLOCATION_TOP_SITE_COUNT 6
+
+internal void
+debug_draw_top_allocation_sites(Debug_State *debug_state, b32 last_frame)
+{
+    Debug_Allocation_Site *picked[DEBUG_ALLOCATION_TOP_SITE_COUNT] = {};
+    for (u32 pick_idx = 0;
+         pick_idx < DEBUG_ALLOCATION_TOP_SITE_COUNT;
+         ++pick_idx)
+    {
+        u64 best_size = 0;
+        for (u32 site_idx = 0;
+             site_idx < DEBUG_ALLOCATION_SITE_COUNT;
+             ++site_idx)
+        {
+            Debug_Allocation_Site *site = debug_state->allocation_sites + site_idx;
+            u64 size = last_frame ? site->last_frame_size : site->total_size;
+            b32 already_picked = false;
+            for (u32 idx = 0;
+                 idx < pick_idx;
+                 ++idx)
+            {
+                already_picked |= (picked[idx] == site);
+            }
+            if (site->guid && !already_picked && size > best_size)
+            {
+                best_size = size;
+                picked[pick_idx] = site;
+            }
+        }
+
+        Debug_Allocation_Site *site = picked[pick_idx];
+        if (!site)
+        {
+            break;
+        }
+
+        char label[128];
+        get_allocation_site_label(site->guid, label, sizeof(label));
+        char text_buffer[256];
+        _snprintf_s(text_buffer, sizeof(text_buffer),
+                    "  %-32s %-14s %9.2fkb in %llu",
+                    label, g_debug_arena_tag_names[site->arena_tag], (f64)best_size / 1024.0,
+                    (unsigned long long)(last_frame ? site->last_frame_count : site->total_count));
+        debug_text_line(text_buffer);
+    }
+}
+
+// NOTE: per arena, what was pushed last frame and since the start, next to
+// the last DEBUG_ALLOCATION_HISTORY frames of it. Then the sites that pushed
+// the most.
+internal void
+debug_draw_allocations(Debug_State *debug_state)
+{
+    u64 max_history = 1;
+    for (u32 tag = eArena_Tag_None + 1;
+         tag < eArena_Tag_Count;
+         ++tag)
+    {
+        Debug_Allocation_Arena *arena = debug_state->allocation_arenas + tag;
+        for (u32 idx = 0;
+             idx < DEBUG_ALLOCATION_HISTORY;
+             ++idx)
+        {
+            max_history = maximum(max_history, arena->history[idx]);
+        }
+    }
+
+    debug_text_line("pushed last frame, and since the start:");
+    f32 line_advance = (f32)debug_state->font->v_advance;
+    for (u32 tag = eArena_Tag_None + 1;
+         tag < eArena_Tag_Count;
+         ++tag)
+    {
+        Debug_Allocation_Arena *arena = debug_state->allocation_arenas + tag;
+
+        f32 bar_width = 2.0f;
+        v2 graph_min = _v2_(debug_state->left_edge + 560.0f, debug_state->at_y - line_advance);
+        push_rect(debug_state->render_group,
+                  rect2_min_dim(graph_min, _v2_(bar_width * DEBUG_ALLOCATION_HISTORY, line_advance)),
+                  0.0f, _v4_(0.2f, 0.2f, 0.2f, 0.5f));
+        for (u32 idx = 0;
+             idx < DEBUG_ALLOCATION_HISTORY;
+             ++idx)
+        {
+            // NOTE: oldest on the left.
+            u64 size = arena->history[(debug_state->allocation_history_idx + idx) % DEBUG_ALLOCATION_HISTORY];
+            if (size)
+            {
+                f32 height = line_advance * (f32)((f64)size / (f64)max_history);
+                push_rect(debug_state->render_group,
+                          rect2_min_dim(graph_min + _v2_(bar_width * idx, 0.0f), _v2_(bar_width, height)),
+                          0.0f, _v4_(1.0f, 0.6f, 0.1f, 1.0f));
+            }
+        }
+
+        char text_buffer[256];
+        _snprintf_s(text_buffer, sizeof(text_buffer),
+                    "  %-14s %9.2fkb in %5u %12.2fkb",
+                    g_debug_arena_tag_names[tag], (f64)arena->last_frame_size / 1024.0,
+                    arena->last_frame_count, (f64)arena->total_size / 1024.0);
+        debug_text_line(text_buffer);
+    }
+
+    debug_text_line("biggest push sites, last frame:");
+    debug_draw_top_allocation_sites(debug_state, true);
+    debug_text_line("biggest push sites, since the start:");
+    debug_draw_top_allocation_sites(debug_state, false);
+}
+
 internal void
 debug_end(Debug_State *debug_state, Game_Input *input)
 {
@@ -1931,6 +2186,11 @@ debug_end(Debug_State *debug_state, Game_Input *input)
                     "per-frame arena used: %ukb",
                     (u32)(get_arena_size_remaining(&debug_state->per_frame_arena) / 1024));
         debug_text_line(text_buffer);
+
+        DEBUG_IF(Memory_DrawAllocations)
+        {
+            debug_draw_allocations(debug_state);
+        }
     }
 
 
@@ -1947,7 +2207,7 @@ debug_end(Debug_State *debug_state, Game_Input *input)
         }
     }
 
-    render_group_to_output_batch(debug_state->render_group, &g_debug_memory->render_batch);
+    render_group_to_output_batch(debug_state->render_group, g_debug_memory->render_batch);
     end_render(debug_state->render_group);
 
     // clear the UI state for the next frame.
@@ -1982,6 +2242,11 @@ DEBUG_FRAME_END(debug_frame_end)
     Debug_State *debug_state = (Debug_State *)memory->debug_storage;
     if (debug_state)
     {
+        if (memory->executable_reloaded)
+        {
+            reset_allocation_sites(debug_state);
+        }
+
         Game_Assets *game_assets = debug_get_game_assets(memory);
 
         debug_start(debug_state, game_assets, game_screen_buffer->width, game_screen_buffer->height);
@@ -179,6 +179,36 @@ struct Debug_Thread
     
 };
 
+// NOTE: pushes to tagged arenas, per push site and per arena. A frame's
+// counts move to last_frame_* at its frame marker.
+#define DEBUG_ALLOCATION_SITE_COUNT     1024
+#define DEBUG_ALLOCATION_HISTORY        128
+
+struct Debug_Allocation_Site
+{
+    char    *guid;
+    u32     arena_tag;
+
+    u64     frame_size;
+    u32     frame_count;
+    u64     last_frame_size;
+    u32     last_frame_count;
+    u64     total_size;
+    u64     total_count;
+};
+
+struct Debug_Allocation_Arena
+{
+    u64     frame_size;
+    u32     frame_count;
+    u64     last_frame_size;
+    u32     last_frame_count;
+    u64     total_size;
+
+    // bytes pushed per frame, the last DEBUG_ALLOCATION_HISTORY frames.
+    u64     history[DEBUG_ALLOCATION_HISTORY];
+};
+
 enum Debug_Interaction_Type
 {
     eDebug_Interaction_None,
@@ -220,6 +250,8 @@ struct Debug_State
     Memory_Arena debug_arena;
     Memory_Arena per_frame_arena;
     
+    // NOTE: one per frame in flight, render_group is this frame's.
+    Render_Group *render_groups[RENDER_MAX_FRAMES_IN_FLIGHT];
     Render_Group *render_group;
 
     Game_Assets *game_assets;
@@ -270,6 +302,11 @@ struct Debug_State
     Debug_Stored_Event *first_free_stored_event;
     Debug_Frame *first_free_frame;
 
+    u32 allocation_site_count;
+    Debug_Allocation_Site allocation_sites[DEBUG_ALLOCATION_SITE_COUNT];
+    Debug_Allocation_Arena allocation_arenas[eArena_Tag_Count];
+    u32 allocation_history_idx;
+
 };
 
 #define DEBUG_H
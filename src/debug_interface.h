@@ -36,11 +36,20 @@ enum Debug_Type
 
     eDebug_Type_Bitmap,
 
+    eDebug_Type_Allocation,
+
     //
 
     eDebug_Type_Counter_Thread_List,
 };
 
+// NOTE: a push to a tagged arena. The event's guid is the push's site.
+struct Debug_Allocation
+{
+    u64 size;
+    u32 arena_tag;
+};
+
 struct Debug_Event
 {
     u64 clock;
@@ -65,6 +74,8 @@ struct Debug_Event
         Rect3 value_Rect3;
 
         Bitmap *value_Bitmap;
+
+        Debug_Allocation value_Debug_Allocation;
     };
 };
 
@@ -87,8 +98,10 @@ typedef DEBUG_FRAME_END(Debug_Frame_End);
 #define unique_file_counter_string() unique_file_counter_string_(__FILE__, __LINE__, __COUNTER__)
 
 #if __DEVELOPER
+// NOTE: the event index only has to be unique, so the add is relaxed. The
+// event's contents reach debug_frame_end through the frame's job waits.
 #define record_debug_event(event_type, block) \
-    u64 array_idx_event_idx = atomic_add_u64(&g_debug_table->event_array_idx_event_idx, 1); \
+    u64 array_idx_event_idx = atomic_add_u64(&g_debug_table->event_array_idx_event_idx, 1, eMemory_Order_Relaxed); \
     u32 event_idx       = (u32)(array_idx_event_idx & 0xffffffff); \
     Assert(event_idx < array_count(g_debug_table->events[0])); \
     Debug_Event *event = g_debug_table->events[array_idx_event_idx >> 32] + event_idx; \
@@ -106,10 +119,18 @@ typedef DEBUG_FRAME_END(Debug_Frame_End);
     event->value_f32 = seconds_elapsed_init; \
 }
 
+#define DEBUG_RECORD_ALLOCATION(site_init, arena_tag_init, size_init)\
+{\
+    record_debug_event(eDebug_Type_Allocation, "Allocation"); \
+    event->guid = site_init; \
+    event->value_Debug_Allocation.size = size_init; \
+    event->value_Debug_Allocation.arena_tag = arena_tag_init; \
+}
+
 #define TIMED_BLOCK__(block_name, number, ...) Timed_Block timed_block_##number(__COUNTER__, __FILE__, __LINE__, block_name, ##__VA_ARGS__)
 #define TIMED_BLOCK_(block_name, number, ...) TIMED_BLOCK__(block_name, number, ##__VA_ARGS__)
 #define TIMED_BLOCK(block_name, ...) TIMED_BLOCK_(#block_name, __LINE__, ##__VA_ARGS__)
-#define TIMED_FUNCTION(...) TIMED_BLOCK_(__FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define TIMED_FUNCTION(...) TIMED_BLOCK_((char *)__FUNCTION__, __LINE__, ##__VA_ARGS__)
 
 #define BEGIN_BLOCK_(counter, file_name_init, line_number_init, block_name_init)\
 { record_debug_event(eDebug_Type_Begin_Block, block_name_init); }
@@ -148,6 +169,7 @@ struct Timed_Block
 #define BEGIN_BLOCK(...)
 #define END_BLOCK(...)
 #define FRAME_MARKER(...)
+#define DEBUG_RECORD_ALLOCATION(...)
 #endif
 
 #if defined(__cplusplus) && __DEVELOPER
@@ -0,0 +1,118 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+
+/*
+ * Hands finished frames from the game thread to a render thread, shared by
+ * the platform layers.
+ *
+ * There is one Render_Batch per frame in flight. The game thread records
+ * into a free one while the render thread consumes the ones already
+ * submitted, in order. With frames_in_flight == 1 the game waits for every
+ * frame to be rendered before it builds the next, which is the old serial
+ * loop with the submission on another thread.
+ *
+ * The game gets the slot index with the batch (Game_Memory.render_slot), and
+ * keeps whatever its batch points at in memory of that slot, so frame N+1
+ * never writes over what frame N's batch is still being rendered from.
+ */
+
+#define FRAME_PIPELINE_RENDER(name) void name(Render_Batch *batch, void *data)
+typedef FRAME_PIPELINE_RENDER(Frame_Pipeline_Render);
+
+struct Platform_Frame_Pipeline
+{
+    u32                     frames_in_flight;
+    Render_Batch            batches[RENDER_MAX_FRAMES_IN_FLIGHT];
+
+    // NOTE: each is touched by one thread only.
+    u32                     next_slot_to_build;
+    u32                     next_slot_to_render;
+
+    u32                     submitted_count;
+    alignas(64) u32 volatile rendered_count;
+
+    Platform_Semaphore      free_semaphore;
+    Platform_Semaphore      ready_semaphore;
+
+    Frame_Pipeline_Render   *render;
+    void                    *render_data;
+};
+
+// NOTE: the batches' memory is the platform's to set up, after this.
+internal void
+frame_pipeline_init(Platform_Frame_Pipeline *pipeline, u32 frames_in_flight,
+                    Frame_Pipeline_Render *render, void *render_data)
+{
+    frames_in_flight = maximum(1, minimum(frames_in_flight, RENDER_MAX_FRAMES_IN_FLIGHT));
+
+    pipeline->frames_in_flight      = frames_in_flight;
+    pipeline->next_slot_to_build    = 0;
+    pipeline->next_slot_to_render   = 0;
+    pipeline->submitted_count       = 0;
+    pipeline->rendered_count        = 0;
+    pipeline->render                = render;
+    pipeline->render_data           = render_data;
+
+    platform_init_semaphore(&pipeline->free_semaphore, frames_in_flight);
+    platform_init_semaphore(&pipeline->ready_semaphore, frames_in_flight);
+    for (u32 idx = 0;
+         idx < frames_in_flight;
+         ++idx)
+    {
+        platform_release_semaphore(&pipeline->free_semaphore);
+    }
+}
+
+// waits for a free batch, returns its slot.
+internal u32
+frame_pipeline_begin_frame(Platform_Frame_Pipeline *pipeline)
+{
+    platform_wait_semaphore(&pipeline->free_semaphore);
+
+    u32 result = pipeline->next_slot_to_build;
+    pipeline->next_slot_to_build = (result + 1) % pipeline->frames_in_flight;
+    return result;
+}
+
+internal void
+frame_pipeline_submit(Platform_Frame_Pipeline *pipeline)
+{
+    ++pipeline->submitted_count;
+    platform_release_semaphore(&pipeline->ready_semaphore);
+}
+
+// NOTE: for when nothing may be in flight, e.g. before the game module is
+// unloaded. Only the game thread may call this.
+internal void
+frame_pipeline_flush(Platform_Frame_Pipeline *pipeline)
+{
+    while (atomic_load_u32(&pipeline->rendered_count, eMemory_Order_Acquire) != pipeline->submitted_count)
+    {
+        _mm_pause();
+    }
+}
+
+// the render thread's loop, called by each platform's render thread proc.
+internal void
+frame_pipeline_render_loop(Platform_Frame_Pipeline *pipeline)
+{
+    for (;;)
+    {
+        platform_wait_semaphore(&pipeline->ready_semaphore);
+
+        u32 slot = pipeline->next_slot_to_render;
+        pipeline->next_slot_to_render = (slot + 1) % pipeline->frames_in_flight;
+
+        Render_Batch *batch = pipeline->batches + slot;
+        pipeline->render(batch, pipeline->render_data);
+        batch->used = 0;
+
+        atomic_add_u32(&pipeline->rendered_count, 1, eMemory_Order_Release);
+        platform_release_semaphore(&pipeline->free_semaphore);
+    }
+}
@@ -10,6 +10,7 @@
 #include "types.h"
 #include "game.h"
 #include "memory.cpp"
+#include "parallel.cpp"
 #include "render_group.cpp"
 #include "sim.cpp"
 #include "asset.cpp"
@@ -23,6 +24,13 @@
 #define TURBULENCE_MAP_SIDE 256 
 
 #define STAR_COUNT_MAX 100'000
+#define STAR_COUNT 10'000
+#define STAR_SCALE 0.2f
+#define STAR_DIST  200.0f
+
+// NOTE: past this many sim steps in a frame the rest of the frame time is
+// dropped, so that one hitch doesn't make every frame after it slower.
+#define SIM_MAX_STEPS_PER_FRAME 8
 
 #if __DEVELOPER
 global_var Game_Memory *g_debug_memory;
@@ -49,7 +57,7 @@ init_console(Console *console, f32 screen_height, f32 screen_width, Font *font)
 }
 
 internal void
-interpolate(Model *model, Animation *anim1, f32 dt1, f32 t, Animation *anim2, f32 dt2)
+interpolate(Model *model, m4x4 *pose, Animation *anim1, f32 dt1, f32 t, Animation *anim2, f32 dt2)
 {
     for (s32 id = 0;
          id < (s32)model->node_count;
@@ -69,15 +77,120 @@ interpolate(Model *model, Animation *anim1, f32 dt1, f32 t, Animation *anim2, f3
             TRS trs2 = interpolate_sample(sample2, dt2);
             TRS r = interpolate_trs(trs1, t, trs2);
             m4x4 transform = trs_to_transform(r.translation, r.rotation, r.scaling);
-            node->current_transform = transform;
+            pose[id] = transform;
         }
         else
         {
-            node->current_transform = node->base_transform;
+            pose[id] = node->base_transform;
         }
     }
 }
 
+// NOTE: the pose is per call, so entities sharing a model can animate in parallel.
+internal void
+animate_entity(Model *model, Animation *idle, Animation *run, Entity_Store *store, u32 idx, f32 dt,
+               Memory_Arena *scratch)
+{
+    m4x4 *pose = push_array(scratch, m4x4, model->node_count, ARENA_CACHE_LINE);
+    m4x4 *animation_transform = store->animation_transform[idx];
+
+    f32 scalar = len(get_split(store->velocity, idx));
+    f32 lo = epsilon_f32;
+    f32 hi = 0.7f;
+    Animation_Channel *channel = &store->animation_channel[idx];
+
+    if (scalar <= lo)
+    {
+        Animation *new_anim = idle;
+        if (channel->animation != new_anim)
+        {
+            channel->animation = new_anim;
+            channel->dt = 0.0f;
+        }
+        eval(model, channel->animation, channel->dt, pose, animation_transform, true);
+        accumulate(channel, dt);
+    }
+    else if (scalar > hi)
+    {
+        Animation *new_anim = run;
+        if (channel->animation != new_anim)
+        {
+            channel->animation = new_anim;
+            channel->dt = 0.0f;
+        }
+        eval(model, channel->animation, channel->dt, pose, animation_transform, true);
+        accumulate(channel, dt);
+    }
+    else
+    {
+        f32 t = (scalar - lo) / (hi - lo);
+        if (channel->animation == idle)
+        {
+            interpolate(model, pose, channel->animation, channel->dt, t, run, 0.0f);
+        }
+        else
+        {
+            interpolate(model, pose, idle, 0.0f, t, channel->animation, channel->dt);
+        }
+        eval(model, 0, 0, pose, animation_transform, false);
+    }
+}
+
+// NOTE: acquired from the asset cache on the main thread beforehand, the
+// tasks don't touch the cache.
+struct Animate_Entities_Data
+{
+    Model           *model;
+    Animation       *idle;
+    Animation       *run;
+    Entity_Store    *store;
+    u32             *entities;  // dense indices.
+    f32             dt;
+};
+
+PARALLEL_FOR_CALLBACK(animate_entities)
+{
+    Animate_Entities_Data *animate = (Animate_Entities_Data *)data;
+    for (u32 entity_idx = first;
+         entity_idx < one_past_last;
+         ++entity_idx)
+    {
+        Temporary_Memory pose_memory = begin_temporary_memory(scratch);
+        animate_entity(animate->model, animate->idle, animate->run,
+                       animate->store, animate->entities[entity_idx], animate->dt, scratch);
+        end_temporary_memory(&pose_memory);
+    }
+}
+
+struct Star_Seed
+{
+    v3  v;
+    f32 theta;
+};
+
+struct Generate_Stars_Data
+{
+    Star_Seed   *seeds;
+    m4x4        *world_transforms;
+};
+
+PARALLEL_FOR_CALLBACK(generate_stars)
+{
+    Generate_Stars_Data *stars = (Generate_Stars_Data *)data;
+    for (u32 idx = first;
+         idx < one_past_last;
+         ++idx)
+    {
+        Star_Seed *seed = stars->seeds + idx;
+        f32 theta = seed->theta;
+        v3 v = normalize(seed->v);
+        v3 translation  = STAR_DIST * v;
+        qt rotation     = _qt_(cos(theta), sin(theta) * v);
+        v3 scaling      = _v3_(STAR_SCALE, STAR_SCALE, STAR_SCALE);
+        stars->world_transforms[idx] = transpose(trs_to_transform(translation, rotation, scaling));
+    }
+}
+
 extern "C"
 GAME_UPDATE(game_update)
 {
@@ -89,22 +202,22 @@ GAME_UPDATE(game_update)
     {
         init_arena(&game_state->world_arena,
                    game_memory->permanent_memory_size - sizeof(Game_State),
-                   (u8 *)game_memory->permanent_memory + sizeof(Game_State));
+                   (u8 *)game_memory->permanent_memory + sizeof(Game_State),
+                   game_memory->platform.platform_commit_memory, eArena_Commit_Lazy);
+        game_state->world_arena.tag     = eArena_Tag_World;
 
         game_state->world               = push_struct(&game_state->world_arena, World);
         World *world                    = game_state->world;
-        world->chunk_dim                = v3{10.0f, 3.0f, 10.0f};
-        Memory_Arena *world_arena       = &game_state->world_arena;
-        Chunk_Hashmap *chunk_hashmap    = &game_state->world->chunkHashmap;
+        init_world(world, &game_state->world_arena, v3{10.0f, 3.0f, 10.0f});
 
         game_state->mode = Game_Mode::GAME;
 
         game_state->random_series = seed(1219);
 
-        Chunk *chunk = get_chunk(&game_state->world_arena, chunk_hashmap, Chunk_Position{0, 0, 0});
+        Chunk *chunk = get_chunk(world, Chunk_Position{0, 0, 0});
         v3 dim = _v3_(1.0f, 1.0f, 1.0f);
 
-        game_state->grass_world_transforms = push_array(&game_state->world_arena, m4x4, GRASS_COUNT_MAX); 
+        game_state->grass_world_transforms = push_array(&game_state->world_arena, m4x4, GRASS_COUNT_MAX, ARENA_CACHE_LINE);
 
         s32 hX = round_f32_to_s32(game_state->world->chunk_dim.x * 0.5f);
         s32 hZ = round_f32_to_s32(game_state->world->chunk_dim.z * 0.5f);
@@ -116,12 +229,12 @@ GAME_UPDATE(game_update)
                 tile_pos.offset.x += dim.x * X;
                 tile_pos.offset.z += dim.z * Z;
                 recalc_pos(&tile_pos, game_state->world->chunk_dim);
-                Entity *tile1 = push_entity(world_arena, chunk_hashmap, Entity_Type::TILE, tile_pos, world->chunk_dim);
+                push_entity(world, Entity_Type::TILE, tile_pos);
                 if (X == -hX || X == hX || Z == -hZ || Z == hZ)
                 {
                     tile_pos.offset.y += 0.5f;
                     recalc_pos(&tile_pos, game_state->world->chunk_dim);
-                    Entity *tile2 = push_entity(world_arena, chunk_hashmap, Entity_Type::TILE, tile_pos, world->chunk_dim);
+                    push_entity(world, Entity_Type::TILE, tile_pos);
                 }
 #if 0
                 for (s32 z = -GRASS_DENSITY; z <= GRASS_DENSITY; ++z)
@@ -151,11 +264,10 @@ GAME_UPDATE(game_update)
             }
         }
 
-        Entity *red_wall = push_entity(world_arena, chunk_hashmap, Entity_Type::RED_WALL, Chunk_Position{0, 0, 0, v3{-2, 2, 0}}, world->chunk_dim);
-        Entity *green_wall = push_entity(world_arena, chunk_hashmap, Entity_Type::GREEN_WALL, Chunk_Position{0, 0, 0, v3{2, 2, 0}}, world->chunk_dim);
+        push_entity(world, Entity_Type::RED_WALL, Chunk_Position{0, 0, 0, v3{-2, 2, 0}});
+        push_entity(world, Entity_Type::GREEN_WALL, Chunk_Position{0, 0, 0, v3{2, 2, 0}});
 
-        Entity *xbot = push_entity(world_arena, chunk_hashmap, Entity_Type::XBOT, Chunk_Position{0, 0, 0}, world->chunk_dim);
-        game_state->player = xbot;
+        game_state->player = push_entity(world, Entity_Type::XBOT, Chunk_Position{0, 0, 0});
 
         f32 T = pi32 * 0.1f;
         f32 Dpc = 5;
@@ -184,29 +296,8 @@ GAME_UPDATE(game_update)
         game_state->using_camera = game_state->player_camera;
 
 
-        // Star
-        game_state->star_world_transforms = push_array(&game_state->world_arena, m4x4, STAR_COUNT_MAX);
-#define STAR_COUNT 10'000
-#define STAR_SCALE 0.2f
-#define STAR_DIST  200.0f
-        for (u32 cnt = 0;
-             cnt < STAR_COUNT;
-             ++cnt)
-        {
-            Assert(game_state->star_count < STAR_COUNT_MAX);
-            f32 x = rand_bilateral(&game_state->random_series);
-            f32 y = rand_bilateral(&game_state->random_series);
-            f32 z = rand_bilateral(&game_state->random_series);
-            f32 theta = rand_range(&game_state->random_series, 0.0f, pi32 * 0.5f);
-            v3 v = normalize(_v3_(x, y, z));
-            v3 translation  = STAR_DIST * v;
-            qt rotation     = _qt_(cos(theta), sin(theta) * v);
-            v3 scaling      = _v3_(STAR_SCALE, STAR_SCALE, STAR_SCALE);
-            game_state->star_world_transforms[game_state->star_count++] = transpose(trs_to_transform(translation, rotation, scaling));
-        }
-
         // @Temporary
-        game_state->light = push_entity(world_arena, chunk_hashmap, Entity_Type::LIGHT, Chunk_Position{0, 0, 0, v3{0, 2.0f, 0}}, world->chunk_dim);
+        game_state->light = push_entity(world, Entity_Type::LIGHT, Chunk_Position{0, 0, 0, v3{0, 2.0f, 0}});
 
         game_state->initted = true;
     }
@@ -218,10 +309,25 @@ GAME_UPDATE(game_update)
     f32 height = (f32)game_screen_buffer->height;
     f32 width = (f32)game_screen_buffer->width;
 
-    Entity *player = game_state->player;
+    // NOTE: dense indices hold for the frame, nothing spawns or despawns.
+    Entity_Store *entities = &game_state->world->entities;
+    u32 player = get_entity(entities, game_state->player);
+    u32 light = get_entity(entities, game_state->light);
+    Assert(player != ENTITY_NONE && light != ENTITY_NONE);
 
     DEBUG_VARIABLE(f32, Xbot, Accel_Constant);
-    player->u = Accel_Constant;
+    entities->u[player] = Accel_Constant;
+
+    // NOTE: 0 steps the sim once per frame with the frame's dt.
+    DEBUG_VARIABLE(f32, Sim, Step_Hz);
+    DEBUG_VARIABLE(f32, Sim, Gravity);
+    DEBUG_VARIABLE(f32, Sim, Drag);
+    DEBUG_VARIABLE(f32, Sim, Max_Speed);
+    // NOTE: an Integrate_Kernel, 0 for the widest the CPU has.
+    DEBUG_VARIABLE(u32, Sim, Kernel);
+
+    // NOTE: models and animations past it are evicted, least recently used first.
+    DEBUG_VARIABLE(u32, Memory, Asset_Budget_KB);
 
     ///////////////////////////////////////////////////////////////////////////
     //
@@ -234,82 +340,116 @@ GAME_UPDATE(game_update)
 
     if (!transient_state->init)
     {
-        init_arena(&transient_state->transient_arena, MB(200),
-                   (u8 *)transient_memory + sizeof(Transient_State));
-
-        // reserved memory for multi-thread work data.
+        Memory_Block_Source *block_source = &transient_state->block_source;
+        init_block_source(block_source, transient_state + 1,
+                          transient_memory_capacity - sizeof(Transient_State),
+                          game_memory->platform.platform_commit_memory);
+
+        // NOTE: commits as it's needed, and so do the arenas carved out of it
+        // unless they say otherwise.
+        init_growable_arena(&transient_state->transient_arena, block_source, MB(16));
+        transient_state->transient_arena.tag = eArena_Tag_Transient;
+
+        // one per frame in flight, the render thread reads the last ones.
+        // NOTE: blocks a frame grew into stay with its arena, nobody else
+        // gets them while the render thread may still be reading.
         for (u32 idx = 0;
-             idx < array_count(transient_state->work_arenas);
+             idx < array_count(transient_state->render_arenas);
              ++idx) 
         {
-            Work_Memory_Arena *work_slot = transient_state->work_arenas + idx;
-            init_sub_arena(&work_slot->arena, &transient_state->transient_arena, MB(4));
+            init_growable_arena(transient_state->render_arenas + idx, block_source, MB(1));
+            transient_state->render_arenas[idx].tag = eArena_Tag_Render;
+        }
+
+        // scratch for parallel_for and the loads, per job thread.
+        DEBUG_VARIABLE(u32, Memory, Thread_Scratch_KB);
+        init_parallel_context(&transient_state->parallel, &game_memory->platform,
+                              game_memory->job_thread_count,
+                              &transient_state->transient_arena, block_source,
+                              KB((size_t)Thread_Scratch_KB));
+        Parallel_Context *parallel = &transient_state->parallel;
+
+        // Star
+        // NOTE: draw the random numbers in order, so the sky doesn't depend
+        // on how the work was split.
+        {
+            Memory_Arena *scratch = get_thread_scratch(parallel);
+            Temporary_Memory star_memory = begin_temporary_memory(scratch);
+
+            Generate_Stars_Data stars = {};
+            stars.seeds = push_array(scratch, Star_Seed, STAR_COUNT);
+            for (u32 cnt = 0;
+                 cnt < STAR_COUNT;
+                 ++cnt)
+            {
+                Star_Seed *star_seed = stars.seeds + cnt;
+                star_seed->v.x      = rand_bilateral(&game_state->random_series);
+                star_seed->v.y      = rand_bilateral(&game_state->random_series);
+                star_seed->v.z      = rand_bilateral(&game_state->random_series);
+                star_seed->theta    = rand_range(&game_state->random_series, 0.0f, pi32 * 0.5f);
+            }
+
+            Assert(STAR_COUNT <= STAR_COUNT_MAX);
+            game_state->star_world_transforms = push_array(&game_state->world_arena, m4x4, STAR_COUNT_MAX, ARENA_CACHE_LINE);
+            stars.world_transforms = game_state->star_world_transforms;
+            parallel_for(parallel, 0, STAR_COUNT, 0, generate_stars, &stars);
+            game_state->star_count = STAR_COUNT;
+
+            end_temporary_memory(&star_memory);
         }
 
         // asset arena.
-        init_arena(&transient_state->asset_arena, MB(200),
-                   (u8 *)transient_memory + sizeof(Transient_State) + transient_state->transient_arena.size);
+        init_growable_arena(&transient_state->asset_arena, block_source, MB(64));
+        transient_state->asset_arena.tag = eArena_Tag_Asset;
 
         transient_state->high_priority_queue    = game_memory->high_priority_queue;
         transient_state->low_priority_queue     = game_memory->low_priority_queue;
         Game_Assets *assets            = &transient_state->game_assets; // TODO: Ain't thrilled about it.
         assets->read_entire_file       = game_memory->platform.debug_platform_read_file;
 
+        //
+        // Map every file, then parse them in place. Models and animations
+        // are the asset cache's, loaded the first time they're used.
+        //
+        init_asset_cache(&assets->cache, &game_memory->platform, block_source,
+                         KB((size_t)Asset_Budget_KB));
+
+        enum
+        {
+            eAsset_File_Debug_Font,
+            eAsset_File_Menu_Font,
+            eAsset_File_Turbulence_Map,
 #if __DEVELOPER
-        assets->xbot_model = push_struct(&transient_state->asset_arena, Model);
-        assets->cube_model = push_struct(&transient_state->asset_arena, Model);
-        assets->octahedral_model = push_struct(&transient_state->asset_arena, Model);
-        assets->sphere_model = push_struct(&transient_state->asset_arena, Model);
-        assets->grass_model = push_struct(&transient_state->asset_arena, Model);
-        assets->red_wall_model = push_struct(&transient_state->asset_arena, Model);
-        assets->green_wall_model = push_struct(&transient_state->asset_arena, Model);
-
-        assets->xbot_idle = push_struct(&transient_state->asset_arena, Animation);
-        load_animation(assets->xbot_idle, "animation/xbot_idle.sanm", &transient_state->asset_arena, game_memory->platform.debug_platform_read_file);
-
-        assets->xbot_run = push_struct(&transient_state->asset_arena, Animation);
-        load_animation(assets->xbot_run, "animation/xbot_run.sanm", &transient_state->asset_arena, game_memory->platform.debug_platform_read_file);
+            eAsset_File_Debug_Bitmap,
 #endif
-        // @Temporary
-        // @Temporary
-        // @Temporary
-        load_model(assets->xbot_model, "mesh/xbot.smsh", &transient_state->asset_arena, game_memory->platform.debug_platform_read_file);
-        player->animation_transform = push_array(&transient_state->transient_arena, m4x4, assets->xbot_model->node_count);
-        f32 xbot_scale = 0.01f;
-        assets->xbot_model->nodes[0].base_transform =
-            scale(assets->xbot_model->nodes[0].base_transform, xbot_scale * v3{1, 1, 1});
-        player->animation_channels[0].animation = assets->xbot_idle;
-
-        load_model(assets->cube_model, "mesh/cube.smsh", &transient_state->asset_arena, game_memory->platform.debug_platform_read_file);
-        load_model(assets->octahedral_model, "mesh/octahedral.smsh", &transient_state->asset_arena, game_memory->platform.debug_platform_read_file);
-        load_model(assets->sphere_model, "mesh/sphere.smsh", &transient_state->asset_arena, game_memory->platform.debug_platform_read_file);
-        load_model(assets->grass_model, "mesh/grass.smsh", &transient_state->asset_arena, game_memory->platform.debug_platform_read_file);
-        load_model(assets->red_wall_model, "mesh/red_wall.smsh", &transient_state->asset_arena, game_memory->platform.debug_platform_read_file);
-        assets->red_wall_model->materials->color_diffuse = v3{1, 0, 0};
-        load_model(assets->green_wall_model, "mesh/green_wall.smsh", &transient_state->asset_arena, game_memory->platform.debug_platform_read_file);
-        assets->green_wall_model->materials->color_diffuse = v3{0, 1, 0};
-        for (u32 vertex_idx = 0;
-             vertex_idx < assets->grass_model->meshes[0].vertex_count;
-             ++vertex_idx)
-        {
-            Vertex *vertex = assets->grass_model->meshes[0].vertices + vertex_idx;
-            assets->grass_max_vertex_y = maximum(assets->grass_max_vertex_y, vertex->pos.y);
-        }
-
 
+            eAsset_File_Count
+        };
+        Asset_File files[eAsset_File_Count] = {};
+        files[eAsset_File_Debug_Font].file_name         = "font/courier_new.sfnt";
+        files[eAsset_File_Menu_Font].file_name          = "font/gill_sans.sfnt";
+        files[eAsset_File_Turbulence_Map].file_name     = "turbulence.bmp";
+#if __DEVELOPER
+        files[eAsset_File_Debug_Bitmap].file_name       = "doggo.bmp";
+#endif
+        map_asset_files(&game_memory->platform, &transient_state->asset_arena, files, eAsset_File_Count);
 
-        assets->star_mesh = assets->octahedral_model->meshes;
+        // @Temporary
+        Model *xbot_model = get_model(assets, eCached_Asset_Xbot_Model);
+        entities->animation_transform[player] = push_array(&transient_state->transient_arena, m4x4, xbot_model->node_count,
+                                                           ARENA_CACHE_LINE);
+        entities->animation_channel[player].animation = get_animation(assets, eCached_Asset_Xbot_Idle);
 
-        load_font(&transient_state->asset_arena, game_memory->platform.debug_platform_read_file, "font/courier_new.sfnt", &assets->debug_font);
-        load_font(&transient_state->asset_arena, game_memory->platform.debug_platform_read_file, "font/gill_sans.sfnt", &assets->menu_font);
+        load_font(&transient_state->asset_arena, files[eAsset_File_Debug_Font].contents, &assets->debug_font);
+        load_font(&transient_state->asset_arena, files[eAsset_File_Menu_Font].contents, &assets->menu_font);
 
         //
         // Noise Map
         //
-        assets->turbulence_map = load_bmp(&transient_state->asset_arena, game_memory->platform.debug_platform_read_file, "turbulence.bmp");
+        assets->turbulence_map = load_bmp(&transient_state->asset_arena, files[eAsset_File_Turbulence_Map].contents, parallel);
 
 #if __DEVELOPER
-        assets->debug_bitmap = load_bmp(&transient_state->asset_arena, game_memory->platform.debug_platform_read_file, "doggo.bmp");
+        assets->debug_bitmap = load_bmp(&transient_state->asset_arena, files[eAsset_File_Debug_Bitmap].contents, parallel);
 #endif
 
         if (!game_state->console.initted)
@@ -322,10 +462,12 @@ GAME_UPDATE(game_update)
     Console *console = &game_state->console;
     v3 chunk_dim = game_state->world->chunk_dim;
 
-    Temporary_Memory render_memory = begin_temporary_memory(&transient_state->transient_arena);
+    Assert(game_memory->render_slot < RENDER_MAX_FRAMES_IN_FLIGHT);
+    Memory_Arena *render_arena = transient_state->render_arenas + game_memory->render_slot;
+    Temporary_Memory render_memory = begin_temporary_memory(render_arena);
 
-    Render_Group *render_group = alloc_render_group(&transient_state->transient_arena, MB(16), game_state->using_camera);
-    Render_Group *orthographic_group = alloc_render_group(&transient_state->transient_arena, MB(16), game_state->orthographic_camera);
+    Render_Group *render_group = alloc_render_group(render_arena, RENDER_GROUP_INITIAL_SIZE, game_state->using_camera);
+    Render_Group *orthographic_group = alloc_render_group(render_arena, RENDER_GROUP_INITIAL_SIZE, game_state->orthographic_camera);
 
     //
     // Input
@@ -520,16 +662,16 @@ GAME_UPDATE(game_update)
         {
             if (input->keys[KEY_W].is_down)
             {
-                m4x4 rotation = to_m4x4(player->world_rotation);
-                player->accel = rotation * _v3_(0, 0, dt * player->u);
+                m4x4 rotation = to_m4x4(entities->world_rotation[player]);
+                set_split(entities->accel, player, rotation * _v3_(0, 0, entities->u[player]));
             }
             if (input->keys[KEY_D].is_down)
             {
-                player->world_rotation = _qt_(cos(dt), 0, -sin(dt), 0) * player->world_rotation;
+                entities->world_rotation[player] = _qt_(cos(dt), 0, -sin(dt), 0) * entities->world_rotation[player];
             }
             if (input->keys[KEY_A].is_down)
             {
-                player->world_rotation = _qt_(cos(dt), 0, sin(dt), 0) * player->world_rotation;
+                entities->world_rotation[player] = _qt_(cos(dt), 0, sin(dt), 0) * entities->world_rotation[player];
             }
         }
 
@@ -588,198 +730,235 @@ GAME_UPDATE(game_update)
         recalc_pos(&max_pos, chunk_dim);
 
 
+        Memory_Arena *scratch = get_thread_scratch(&transient_state->parallel);
+        Temporary_Memory sim_memory = begin_temporary_memory(scratch);
+
         //
         // Update entities
         //
-        update_entities(game_state, dt, min_pos, max_pos);
+        f32 sim_dt = dt;
+        u32 sim_step_count = 1;
+        game_state->sim_alpha = 1.0f;
+        if (Step_Hz > 0.0f)
+        {
+            sim_dt = 1.0f / Step_Hz;
+            game_state->sim_accumulator += dt;
+            sim_step_count = (u32)(game_state->sim_accumulator / sim_dt);
+            if (sim_step_count > SIM_MAX_STEPS_PER_FRAME)
+            {
+                sim_step_count = SIM_MAX_STEPS_PER_FRAME;
+                game_state->sim_accumulator = sim_step_count * sim_dt;
+            }
+            game_state->sim_accumulator -= sim_step_count * sim_dt;
+            game_state->sim_alpha = clamp(game_state->sim_accumulator / sim_dt, 0.0f, 1.0f);
+        }
+
+        Integrate_Params integrate = {};
+        integrate.dt            = sim_dt;
+        integrate.gravity       = Gravity;
+        integrate.drag          = Drag;
+        integrate.max_speed     = Max_Speed;
+        integrate.chunk_dim     = chunk_dim;
+        integrate.min_pos       = min_pos;
+        integrate.max_pos       = max_pos;
+        integrate.kernel        = (Integrate_Kernel)minimum(Kernel, eIntegrate_Kernel_Count - 1);
+        for (u32 step_idx = 0;
+             step_idx < sim_step_count;
+             ++step_idx)
+        {
+            update_entities(game_state, &transient_state->parallel, &integrate);
+        }
+
+        if (sim_step_count)
+        {
+            // input's accel has been applied to all of this frame's steps.
+            set_split(entities->accel, player, v3{});
+        }
 
-        game_state->player_camera->world_translation = game_state->player->world_translation + v3{0.0f, 5.0f, 5.0f};
+        f32 sim_alpha = game_state->sim_alpha;
+        game_state->player_camera->world_translation = get_render_translation(entities, player, sim_alpha) + v3{0.0f, 5.0f, 5.0f};
         char DEBUG_player_pos_buf[256];
         snprintf(DEBUG_player_pos_buf, 256, "x: %f, y: %f, z: %f",
-                 player->world_translation.x,
-                 player->world_translation.y,
-                 player->world_translation.z);
+                 entities->world_translation.x[player],
+                 entities->world_translation.y[player],
+                 entities->world_translation.z[player]);
         string_op(String_Op::DRAW, orthographic_group, v3{400, height - 100, 0}, DEBUG_player_pos_buf, &assets->debug_font);
 
 
+        //
+        // Animate
+        //
+        {
+            Temporary_Memory animate_memory = begin_temporary_memory(scratch);
+
+            // NOTE: xbots are movers, they're all in front.
+            Animate_Entities_Data animate = {};
+            animate.dt          = dt;
+            animate.store       = entities;
+            animate.entities    = push_array(scratch, u32, entities->mover_count);
+
+            u32 entity_count = 0;
+            for (u32 idx = 0;
+                 idx < entities->mover_count;
+                 ++idx)
+            {
+                if (entities->type[idx] == Entity_Type::XBOT &&
+                    is_in_region(entities->chunk[idx], min_pos, max_pos))
+                {
+                    animate.entities[entity_count++] = idx;
+                }
+            }
+
+            if (entity_count)
+            {
+                animate.model   = get_model(assets, eCached_Asset_Xbot_Model);
+                animate.idle    = get_animation(assets, eCached_Asset_Xbot_Idle);
+                animate.run     = get_animation(assets, eCached_Asset_Xbot_Run);
+            }
+
+            if (animate.model && animate.idle && animate.run)
+            {
+                // one entity per task, a pose is a lot of work.
+                parallel_for(&transient_state->parallel, 0, entity_count, 1, animate_entities, &animate);
+            }
+
+            end_temporary_memory(&animate_memory);
+        }
+
         //
         // Draw
         //
 #if 1
-        for (s32 Z = min_pos.z;
-             Z <= max_pos.z;
-             ++Z) 
+        for (u32 idx = 0;
+             idx < entities->count;
+             ++idx) 
         {
-            for (s32 Y = min_pos.y;
-                 Y <= max_pos.y;
-                 ++Y) 
+            if (!is_in_region(entities->chunk[idx], min_pos, max_pos))
             {
-                for (s32 X = min_pos.x;
-                     X <= max_pos.x;
-                     ++X) 
-                {
-                    Chunk *chunk = get_chunk(&game_state->world_arena,
-                                             &game_state->world->chunkHashmap,
-                                             Chunk_Position{X, Y, Z});
-                    for (Entity *entity = chunk->entities.head;
-                         entity != 0;
-                         entity = entity->next) 
-                    {
+                continue;
+            }
 
-                        m4x4 world_transform = trs_to_transform(entity->world_translation,
-                                                                entity->world_rotation,
-                                                                entity->world_scaling);
+            m4x4 world_transform = get_render_transform(entities, idx, sim_alpha);
 
-                        switch (entity->type) 
+            switch (entities->type[idx]) 
+            {
+                case Entity_Type::XBOT: 
+                {
+                    Model *model = get_model(assets, eCached_Asset_Xbot_Model);
+                    if (model)
+                    {
+                        for (u32 mesh_idx = 0;
+                             mesh_idx < model->mesh_count;
+                             ++mesh_idx)
                         {
-                            case Entity_Type::XBOT: 
-                            {
-                                Model *model = assets->xbot_model;
-                                if (model)
-                                {
-                                    f32 scalar = len(entity->velocity);
-                                    f32 lo = epsilon_f32;
-                                    f32 hi = 0.7f;
-                                    Animation_Channel *channel = &entity->animation_channels[0];
-
-                                    if (scalar <= lo)
-                                    {
-                                        Animation *new_anim = assets->xbot_idle;
-                                        if (channel->animation != new_anim)
-                                        {
-                                            channel->animation = new_anim;
-                                            channel->dt = 0.0f;
-                                        }
-                                        eval(model, channel->animation, channel->dt, entity->animation_transform, true);
-                                        accumulate(channel, dt);
-                                    }
-                                    else if (scalar > hi)
-                                    {
-                                        Animation *new_anim = assets->xbot_run;
-                                        if (channel->animation != new_anim)
-                                        {
-                                            channel->animation = new_anim;
-                                            channel->dt = 0.0f;
-                                        }
-                                        eval(model, channel->animation, channel->dt, entity->animation_transform, true);
-                                        accumulate(channel, dt);
-                                    }
-                                    else
-                                    {
-                                        f32 t = (scalar - lo) / (hi - lo);
-                                        if (channel->animation == assets->xbot_idle)
-                                        {
-                                            interpolate(model, channel->animation, channel->dt, t, assets->xbot_run, 0.0f);
-                                        }
-                                        else
-                                        {
-                                            interpolate(model, assets->xbot_idle, 0.0f, t, channel->animation, channel->dt);
-                                        }
-                                        eval(model, 0, 0, entity->animation_transform, false);
-                                    }
-
-                                    for (u32 mesh_idx = 0;
-                                         mesh_idx < model->mesh_count;
-                                         ++mesh_idx)
-                                    {
-                                        Mesh *mesh = model->meshes + mesh_idx;
-                                        Material *mat = model->materials + mesh->material_idx;
-                                        v3 light_pos = subtract(game_state->light->chunk_pos, {}, game_state->world->chunk_dim);
-                                        push_mesh(render_group, mesh, mat, world_transform, entity->animation_transform);
-                                    }
-                                }
-                            } break;
+                            Mesh *mesh = model->meshes + mesh_idx;
+                            Material *mat = model->materials + mesh->material_idx;
+                            v3 light_pos = subtract(get_chunk_pos(entities, light), {}, game_state->world->chunk_dim);
+                            push_mesh(render_group, mesh, mat, world_transform,
+                                      entities->animation_transform[idx], model->node_count);
+                        }
+                    }
+                } break;
 
-                            case Entity_Type::TILE: 
-                            {
+                case Entity_Type::TILE: 
+                {
 #if 1
-                                Model *model = assets->cube_model;
-                                if (model)
-                                {
-                                    for (u32 mesh_idx = 0;
-                                         mesh_idx < model->mesh_count;
-                                         ++mesh_idx)
-                                    {
-                                        Mesh *mesh = model->meshes + mesh_idx;
-                                        Material *mat = model->materials + mesh->material_idx;
-                                        v3 light_pos = subtract(game_state->light->chunk_pos, {}, game_state->world->chunk_dim);
-                                        push_mesh(render_group, mesh, mat, world_transform);
-                                    }
-                                }
+                    Model *model = get_model(assets, eCached_Asset_Cube_Model);
+                    if (model)
+                    {
+                        for (u32 mesh_idx = 0;
+                             mesh_idx < model->mesh_count;
+                             ++mesh_idx)
+                        {
+                            Mesh *mesh = model->meshes + mesh_idx;
+                            Material *mat = model->materials + mesh->material_idx;
+                            v3 light_pos = subtract(get_chunk_pos(entities, light), {}, game_state->world->chunk_dim);
+                            push_mesh(render_group, mesh, mat, world_transform);
+                        }
+                    }
 #endif
-                            } break;
+                } break;
 
-                            case Entity_Type::LIGHT:
-                            {
+                case Entity_Type::LIGHT:
+                {
 #if 0
-                                Model *model = assets->sphere_model;
-                                if (model)
-                                {
-                                    for (u32 mesh_idx = 0;
-                                         mesh_idx < model->mesh_count;
-                                         ++mesh_idx)
-                                    {
-                                        Mesh *mesh = model->meshes + mesh_idx;
-                                        Material *mat = model->materials + mesh->material_idx;
-                                        v3 light_pos = subtract(game_state->light->chunk_pos, {}, game_state->world->chunk_dim);
-                                        push_mesh(render_group, mesh, mat, world_transform);
-                                    }
-                                }
+                    Model *model = get_model(assets, eCached_Asset_Sphere_Model);
+                    if (model)
+                    {
+                        for (u32 mesh_idx = 0;
+                             mesh_idx < model->mesh_count;
+                             ++mesh_idx)
+                        {
+                            Mesh *mesh = model->meshes + mesh_idx;
+                            Material *mat = model->materials + mesh->material_idx;
+                            v3 light_pos = subtract(get_chunk_pos(entities, light), {}, game_state->world->chunk_dim);
+                            push_mesh(render_group, mesh, mat, world_transform);
+                        }
+                    }
 #endif
-                            } break;
-
-                            case Entity_Type::RED_WALL: 
-                            {
-                                Model *model = assets->red_wall_model;
-                                if (model)
-                                {
-                                    for (u32 mesh_idx = 0;
-                                         mesh_idx < model->mesh_count;
-                                         ++mesh_idx)
-                                    {
-                                        Mesh *mesh = model->meshes + mesh_idx;
-                                        Material *mat = model->materials + mesh->material_idx;
-                                        v3 light_pos = subtract(game_state->light->chunk_pos, {}, game_state->world->chunk_dim);
-                                        push_mesh(render_group, mesh, mat, world_transform);
-                                    }
-                                }
-                            } break;
-
-                            case Entity_Type::GREEN_WALL: 
-                            {
-                                Model *model = assets->green_wall_model;
-                                if (model)
-                                {
-                                    for (u32 mesh_idx = 0;
-                                         mesh_idx < model->mesh_count;
-                                         ++mesh_idx)
-                                    {
-                                        Mesh *mesh = model->meshes + mesh_idx;
-                                        Material *mat = model->materials + mesh->material_idx;
-                                        v3 light_pos = subtract(game_state->light->chunk_pos, {}, game_state->world->chunk_dim);
-                                        push_mesh(render_group, mesh, mat, world_transform);
-                                    }
-                                }
-                            } break;
+                } break;
 
-                            INVALID_DEFAULT_CASE
+                case Entity_Type::RED_WALL: 
+                {
+                    Model *model = get_model(assets, eCached_Asset_Red_Wall_Model);
+                    if (model)
+                    {
+                        for (u32 mesh_idx = 0;
+                             mesh_idx < model->mesh_count;
+                             ++mesh_idx)
+                        {
+                            Mesh *mesh = model->meshes + mesh_idx;
+                            Material *mat = model->materials + mesh->material_idx;
+                            v3 light_pos = subtract(get_chunk_pos(entities, light), {}, game_state->world->chunk_dim);
+                            push_mesh(render_group, mesh, mat, world_transform);
                         }
+                    }
+                } break;
 
+                case Entity_Type::GREEN_WALL: 
+                {
+                    Model *model = get_model(assets, eCached_Asset_Green_Wall_Model);
+                    if (model)
+                    {
+                        for (u32 mesh_idx = 0;
+                             mesh_idx < model->mesh_count;
+                             ++mesh_idx)
+                        {
+                            Mesh *mesh = model->meshes + mesh_idx;
+                            Material *mat = model->materials + mesh->material_idx;
+                            v3 light_pos = subtract(get_chunk_pos(entities, light), {}, game_state->world->chunk_dim);
+                            push_mesh(render_group, mesh, mat, world_transform);
+                        }
                     }
-                }
+                } break;
+
+                INVALID_DEFAULT_CASE
             }
+
         }
 #endif
+        end_temporary_memory(&sim_memory);
+
+        // NOTE: chunks left empty outside the sim region can go back to the pool.
+        release_empty_chunks(game_state->world, min_pos, max_pos);
 
 
         DEBUG_IF(Render_DrawGrass)
         {
-            push_grass(render_group, &assets->grass_model->meshes[0], game_state->grass_count, game_state->grass_world_transforms, time, assets->grass_max_vertex_y, assets->turbulence_map);
+            Model *grass_model = get_model(assets, eCached_Asset_Grass_Model);
+            if (grass_model)
+            {
+                push_grass(render_group, &grass_model->meshes[0], game_state->grass_count, game_state->grass_world_transforms, time, assets->grass_max_vertex_y, assets->turbulence_map);
+            }
         }
 
         DEBUG_IF(Render_DrawStar)
         {
-            push_star(render_group, assets->star_mesh, game_state->star_count, game_state->star_world_transforms, time);
+            Model *star_model = get_model(assets, eCached_Asset_Octahedral_Model);
+            if (star_model)
+            {
+                push_star(render_group, star_model->meshes, game_state->star_count, game_state->star_world_transforms, time);
+            }
         }
 
     }
@@ -805,25 +984,27 @@ GAME_UPDATE(game_update)
 #if __DEVELOPER && 0
         if (DEBUG_UI_ENABLED)
         {
-            Debug_ID entity_debug_id = DEBUG_POINTER_ID(player);
+            Debug_ID entity_debug_id = DEBUG_POINTER_ID(&game_state->player);
 
             DEBUG_BEGIN_DATA_BLOCK("player entity", entity_debug_id);
-            DEBUG_VALUE(player->world_translation);
-            DEBUG_VALUE(player->velocity);
-            DEBUG_VALUE(player->accel);
-            DEBUG_VALUE(player->u);
+            DEBUG_VALUE(get_split(entities->world_translation, player));
+            DEBUG_VALUE(get_split(entities->velocity, player));
+            DEBUG_VALUE(get_split(entities->accel, player));
+            DEBUG_VALUE(entities->u[player]);
             DEBUG_VALUE(assets->debug_bitmap);
             DEBUG_END_DATA_BLOCK();
         }
 #endif
 
         // Render Batch to Graphics API
-        game_memory->render_batch.DEBUG_voxel_level = 10;
-        game_memory->render_batch.dt = dt;
-        game_memory->render_batch.time = time;
-        render_group_to_output_batch(render_group, &game_memory->render_batch);
-        render_group_to_output_batch(orthographic_group, &game_memory->render_batch);
+        game_memory->render_batch->DEBUG_voxel_level = 10;
+        game_memory->render_batch->dt = dt;
+        game_memory->render_batch->time = time;
+        render_group_to_output_batch(render_group, game_memory->render_batch);
+        render_group_to_output_batch(orthographic_group, game_memory->render_batch);
         end_temporary_memory(&render_memory);
+
+        end_asset_cache_frame(&assets->cache, KB((size_t)Asset_Budget_KB));
 }
 
 
@@ -33,7 +33,6 @@
 #include "random.h"
 
 struct Camera;
-enum Animation_State;
 
 internal b32
 string_equal(char *str1, u32 len1, char *str2, u32 len2)
@@ -59,24 +58,166 @@ string_equal(char *str1, u32 len1, char *str2, u32 len2)
 }
 
 
-#define zero_struct(INSTANCE) zero_size(sizeof(INSTANCE), &(INSTANCE))
-#define zero_array(COUNT, POINTER) zero_size(COUNT * sizeof((POINTER)[0]), POINTER)
-internal void
-zero_size(size_t size, void *data) 
+//
+// Copy, zero and fill
+//
+// 16 bytes at a time with SSE, 64 a loop. The first and last 16 bytes are
+// done unaligned and the loop in between stores aligned, overlapping them,
+// so there's no byte loop for the ends. Blocks of MEMORY_STREAM_THRESHOLD
+// and up are stored non-temporal: they'd only evict the cache on their way
+// through, and whoever reads them back is rarely right behind.
+//
+// NOTE: like memcpy, the source and destination of a copy can't overlap.
+//
+#define MEMORY_STREAM_THRESHOLD     MB(4)
+
+inline void
+fill_memory_(void *dst_init, u8 value, size_t size, b32 stream)
 {
-    u8 *at = (u8 *)data;
-    while (size--) 
+    u8 *dst = (u8 *)dst_init;
+    if (size < 16)
+    {
+        while (size--)
+        {
+            *dst++ = value;
+        }
+        return;
+    }
+
+    __m128i v = _mm_set1_epi8((char)value);
+    u8 *end = dst + size;
+    _mm_storeu_si128((__m128i *)dst, v);
+    _mm_storeu_si128((__m128i *)(end - 16), v);
+
+    u8 *at = (u8 *)(((size_t)dst + 16) & ~(size_t)15);
+    u8 *last = end - 16;
+    if (stream)
     {
-        *at++ = 0;
+        for (; at + 64 <= last; at += 64)
+        {
+            _mm_stream_si128((__m128i *)at + 0, v);
+            _mm_stream_si128((__m128i *)at + 1, v);
+            _mm_stream_si128((__m128i *)at + 2, v);
+            _mm_stream_si128((__m128i *)at + 3, v);
+        }
+        for (; at < last; at += 16)
+        {
+            _mm_stream_si128((__m128i *)at, v);
+        }
+        _mm_sfence();
+    }
+    else
+    {
+        for (; at + 64 <= last; at += 64)
+        {
+            _mm_store_si128((__m128i *)at + 0, v);
+            _mm_store_si128((__m128i *)at + 1, v);
+            _mm_store_si128((__m128i *)at + 2, v);
+            _mm_store_si128((__m128i *)at + 3, v);
+        }
+        for (; at < last; at += 16)
+        {
+            _mm_store_si128((__m128i *)at, v);
+        }
     }
 }
 
+inline void
+copy_memory_(void *dst_init, void *src_init, size_t size, b32 stream)
+{
+    u8 *dst = (u8 *)dst_init;
+    u8 *src = (u8 *)src_init;
+    if (size < 16)
+    {
+        while (size--)
+        {
+            *dst++ = *src++;
+        }
+        return;
+    }
+
+    __m128i first = _mm_loadu_si128((__m128i *)src);
+    __m128i last_16 = _mm_loadu_si128((__m128i *)(src + size - 16));
+
+    u8 *end = dst + size;
+    u8 *at = (u8 *)(((size_t)dst + 16) & ~(size_t)15);
+    u8 *from = src + (at - dst);
+    u8 *last = end - 16;
+    if (stream)
+    {
+        for (; at + 64 <= last; at += 64, from += 64)
+        {
+            __m128i a = _mm_loadu_si128((__m128i *)from + 0);
+            __m128i b = _mm_loadu_si128((__m128i *)from + 1);
+            __m128i c = _mm_loadu_si128((__m128i *)from + 2);
+            __m128i d = _mm_loadu_si128((__m128i *)from + 3);
+            _mm_stream_si128((__m128i *)at + 0, a);
+            _mm_stream_si128((__m128i *)at + 1, b);
+            _mm_stream_si128((__m128i *)at + 2, c);
+            _mm_stream_si128((__m128i *)at + 3, d);
+        }
+        for (; at < last; at += 16, from += 16)
+        {
+            _mm_stream_si128((__m128i *)at, _mm_loadu_si128((__m128i *)from));
+        }
+        _mm_sfence();
+    }
+    else
+    {
+        for (; at + 64 <= last; at += 64, from += 64)
+        {
+            __m128i a = _mm_loadu_si128((__m128i *)from + 0);
+            __m128i b = _mm_loadu_si128((__m128i *)from + 1);
+            __m128i c = _mm_loadu_si128((__m128i *)from + 2);
+            __m128i d = _mm_loadu_si128((__m128i *)from + 3);
+            _mm_store_si128((__m128i *)at + 0, a);
+            _mm_store_si128((__m128i *)at + 1, b);
+            _mm_store_si128((__m128i *)at + 2, c);
+            _mm_store_si128((__m128i *)at + 3, d);
+        }
+        for (; at < last; at += 16, from += 16)
+        {
+            _mm_store_si128((__m128i *)at, _mm_loadu_si128((__m128i *)from));
+        }
+    }
+
+    _mm_storeu_si128((__m128i *)dst, first);
+    _mm_storeu_si128((__m128i *)last, last_16);
+}
+
+inline void *
+fill_memory(void *dst, u8 value, size_t size)
+{
+    fill_memory_(dst, value, size, (size >= MEMORY_STREAM_THRESHOLD));
+    return dst;
+}
+
+inline void *
+zero_memory(void *dst, size_t size)
+{
+    fill_memory_(dst, 0, size, (size >= MEMORY_STREAM_THRESHOLD));
+    return dst;
+}
+
+inline void *
+copy_memory(void *dst, void *src, size_t size)
+{
+    copy_memory_(dst, src, size, (size >= MEMORY_STREAM_THRESHOLD));
+    return dst;
+}
+
+#define zero_struct(INSTANCE) zero_memory(&(INSTANCE), sizeof(INSTANCE))
+#define zero_array(COUNT, POINTER) zero_memory(POINTER, (COUNT) * sizeof((POINTER)[0]))
+inline void
+zero_size(size_t size, void *data) 
+{
+    zero_memory(data, size);
+}
+
 inline void *
 copy(size_t size, void *src_init, void *dst_init)
 {
-    u8 *src = (u8 *)src_init;
-    u8 *dst = (u8 *)dst_init;
-    while (size--) { *dst++ = *src++; }
+    copy_memory(dst_init, src_init, size);
     return dst_init;
 }
 
@@ -96,12 +237,87 @@ copy(size_t size, void *src_init, void *dst_init)
 #define FREELIST_DEALLOC(ptr, free_list_ptr) \
     if (ptr) {ptr->next_free = free_list_ptr; (free_list_ptr) = ptr;}
 
+enum Arena_Commit
+{
+    eArena_Commit_Lazy,         // as pushes get to it.
+    eArena_Commit_Prefault,     // all of it at init, faults and all.
+};
+
+// NOTE: at the start of every block of a growable arena, on a cache line of
+// its own. Says what the arena was before it moved on to this block.
+struct Memory_Block
+{
+    void            *prev_base;
+    size_t          prev_size;
+    size_t          prev_used;
+    size_t          prev_committed;
+    Memory_Block    *prev;
+
+    // all of it, this header included. committed is kept while it's free.
+    size_t          size;
+    size_t          committed;
+    Memory_Block    *next_free;
+};
+
+// NOTE: hands out blocks off the top of a reserved range, to any thread.
+// Blocks never go back, arenas keep the ones they are done with for later.
+struct Memory_Block_Source
+{
+    u8                      *base;
+    size_t                  size;
+    u64 volatile            used;
+    Platform_Commit_Memory  *commit;
+};
+
+// NOTE: which arena it is, for the debug allocation view. Pushes to
+// untagged arenas aren't recorded, the debug arenas among them.
+enum Arena_Tag
+{
+    eArena_Tag_None,
+
+    eArena_Tag_World,
+    eArena_Tag_Transient,
+    eArena_Tag_Render,
+    eArena_Tag_Asset,
+    eArena_Tag_Thread_Scratch,
+
+    eArena_Tag_Count
+};
+
 struct Memory_Arena 
 {
     size_t  size;
     size_t  used;
     void    *base;
 
+    // NOTE: only the first committed bytes are backed, pushes commit more
+    // through commit. Nothing to commit when committed is size.
+    size_t                  committed;
+    Platform_Commit_Memory  *commit;
+    // NOTE: [sub_arena_begin, sub_arena_end) went to sub-arenas, which commit
+    // it themselves. It counts as committed until the arena is rolled back
+    // into it, or leaves the block.
+    size_t                  sub_arena_begin;
+    size_t                  sub_arena_end;
+
+    // NOTE: with a source, the arena grows. Once the block it's in is full,
+    // it moves on to one of its free blocks or a new one from source. Without
+    // one it's fixed, and a push that doesn't fit Asserts. The chained counts
+    // are of the blocks before this one.
+    Memory_Block_Source     *source;
+    size_t                  minimum_block_size;
+    Memory_Block            *block;
+    Memory_Block            *first_free_block;
+    u32                     block_count;
+    size_t                  chained_size;
+    size_t                  chained_used;
+    size_t                  chained_committed;
+
+    // the most that was ever used at once, over all blocks.
+    size_t                  high_water;
+
+    Arena_Tag               tag;
+
     u32     tempCount;
 };
 
@@ -111,13 +327,137 @@ struct Temporary_Memory
     // simply stores what was the used amount before.
     // restoring without any precedence issues problem in multi-threading.
     size_t used;
+    // and in which block, for growable arenas.
+    Memory_Block *block;
+};
+
+// NOTE: fixed size slots for one type, out of slabs pushed on an arena.
+// Slabs are POOL_SLAB_SIZE and aligned to it, so a slot finds its slab from
+// its address. Freed slots go on the typed pool's free list
+// (FREELIST_ALLOC/DEALLOC), slabs are never given back to the arena.
+struct Pool_Slab
+{
+    Pool_Slab   *next;
+    u32         carved_count;   // slots handed out of it at least once.
+    u32         live_count;
+};
+
+struct Pool
+{
+    Memory_Arena    *arena;
+    size_t          slot_size;
+    u32             slots_per_slab;
+
+    Pool_Slab       *first_slab;    // new slots come out of this one.
+    u32             slab_count;
+    u32             live_count;
+    u32             high_water;
+    u64             alloc_count;
+    u64             free_count;
+};
+
+// how scattered a pool's live slots are. packed_slab_count is how many slabs
+// they'd take if they were moved together.
+struct Pool_Stats
+{
+    u32     slab_count;
+    u32     capacity;
+    u32     live_count;
+    u32     high_water;
+    u32     free_slot_count;    // on the free list.
+    u32     used_slab_count;    // with at least one live slot.
+    u32     packed_slab_count;
+    u64     alloc_count;
+    u64     free_count;
+};
+
+// NOTE: here, the platform reports it too.
+inline Pool_Stats
+get_pool_stats(Pool *pool)
+{
+    Pool_Stats result = {};
+    result.slab_count           = pool->slab_count;
+    result.capacity             = pool->slab_count * pool->slots_per_slab;
+    result.live_count           = pool->live_count;
+    result.high_water           = pool->high_water;
+    result.packed_slab_count    = (pool->live_count + pool->slots_per_slab - 1) / pool->slots_per_slab;
+    result.alloc_count          = pool->alloc_count;
+    result.free_count           = pool->free_count;
+    for (Pool_Slab *slab = pool->first_slab;
+         slab;
+         slab = slab->next)
+    {
+        result.free_slot_count += slab->carved_count - slab->live_count;
+        if (slab->live_count)
+        {
+            ++result.used_slab_count;
+        }
+    }
+    return result;
+}
+
+// NOTE: what a thread has left of the chunk it took last, on a cache line
+// of its own.
+struct alignas(64) Atomic_Arena_Cursor
+{
+    u8      *at;
+    u8      *end;
+};
+
+// NOTE: an arena any number of threads push to at once. Each thread takes
+// chunk_size off the arena with one atomic add and bumps through it on its
+// own, so most pushes touch nothing shared. Threads without a cursor, and
+// pushes too big for a chunk, go to used directly. Fixed, out of one block
+// of a source, committed a chunk at a time.
+struct Atomic_Arena
+{
+    u8                      *base;
+    size_t                  size;
+    size_t                  chunk_size;
+    Platform_Commit_Memory  *commit;
+
+    u32                     cursor_count;
+    Atomic_Arena_Cursor     *cursors;
+    u32                     temp_count;
+
+    // NOTE: a flag per ARENA_COMMIT_GRANULARITY of the arena, set once it's
+    // committed. Kept through rollbacks, the memory stays committed.
+    u32 volatile            *committed_granules;
+    u32                     granule_count;
+
+    // NOTE: written by every thread that takes a chunk, off on its own line.
+    alignas(64) u64 volatile used;
+    u64 volatile            wasted;     // chunk ends nothing fit in.
+    u8                      pad[64 - 2 * sizeof(u64)];
+};
+
+// NOTE: only begun and ended while nobody pushes.
+struct Atomic_Temporary_Memory
+{
+    Atomic_Arena    *arena;
+    u64             used;
 };
 
-struct Work_Memory_Arena 
+// NOTE: two, so that code holding one can still ask for scratch that
+// doesn't step on it.
+#define THREAD_SCRATCH_COUNT 2
+
+// a job thread's scratch arenas. Cache lines of its own, the arenas are
+// written on every push.
+struct alignas(64) Thread_Scratch
 {
-    b32                 is_used;
-    Memory_Arena        arena;
-    Temporary_Memory    flush;
+    Memory_Arena        arenas[THREAD_SCRATCH_COUNT];
+};
+
+// NOTE: parallel_for over the platform job system. Scratch arenas per job thread.
+struct Parallel_Context
+{
+    Platform_Add_Job                *add_job;
+    Platform_Wait_For_Counter       *wait_for_counter;
+    Platform_Get_Job_Thread_Index   *get_job_thread_index;
+
+    u32                             thread_count;
+    Thread_Scratch                  *thread_scratch;
 };
 
 struct Chunk_Position 
@@ -151,58 +491,141 @@ enum Entity_Flag
 {
     eEntity_Flag_Collides = 1
 };
-struct Entity 
+
+struct Chunk 
 {
-    Entity_Type         type;
-    Chunk_Position      chunk_pos;
+    s32             x;
+    s32             y;
+    s32             z;
+    u32             entity_count;   // the ones whose chunk it is.
 
-    v3                  world_translation;
-    qt                  world_rotation;
-    v3                  world_scaling;
+    Chunk           *next_free;
+};
 
-    v3                  velocity;
-    v3                  accel;
-    f32                 u;
-    u32                 flags;
+// NOTE: an entity that may be gone by the time it's looked at. get_entity
+// gives ENTITY_NONE once it's despawned, even if its slot holds another
+// entity by then. A zeroed handle is none.
+struct Entity_Handle
+{
+    u32     slot;
+    u32     generation;
+};
 
-    Animation_Channel   animation_channels[1];
-    m4x4                *animation_transform;
+// NOTE: a v3 column as an array per axis, so that a kernel loads the x of
+// 4 or 8 entities at once.
+struct Split_v3
+{
+    f32     *x;
+    f32     *y;
+    f32     *z;
+};
 
-    Entity              *next;
+struct Split_v3i
+{
+    s32     *x;
+    s32     *y;
+    s32     *z;
 };
 
-struct Entity_List 
+// NOTE: entities as columns, one array per component, all indexed by the
+// same dense index. Movers, the types that get integrated, are kept in
+// front, [0, mover_count), so a sim step walks the front of the physics
+// columns and nothing else; the rest leave theirs alone.
+//
+// Pushing and despawning move entities around, so a dense index is only
+// good until then. Hold on to a handle instead, it goes through a slot
+// that knows where its entity is now.
+//
+// Columns double once full. The old ones stay behind on the arena, like
+// the chunk table's.
+struct Entity_Store
 {
-    Entity  *head;
+    Memory_Arena        *arena;
+    u32                 capacity;
+    u32                 count;
+    u32                 mover_count;
+
+    Entity_Type         *type;
+    u32                 *flags;
+    u32                 *slot;                  // the slot that points here.
+    Chunk               **chunk;                // the one it's counted in.
+
+    // transform. chunk_pos is the chunk and the offset in it, get_chunk_pos
+    // puts them back together.
+    Split_v3i           chunk_coord;
+    Split_v3            chunk_offset;
+    Split_v3            world_translation;
+    qt                  *world_rotation;
+    v3                  *world_scaling;
+
+    // NOTE: state as of the sim step before, drawn blended with the current one.
+    Split_v3            prev_world_translation;
+    qt                  *prev_world_rotation;
+
+    // physics, movers only.
+    Split_v3            velocity;
+    Split_v3            accel;
+    f32                 *u;
+
+    // animation
+    Animation_Channel   *animation_channel;
+    m4x4                **animation_transform;
+
+    // NOTE: per slot, where its entity is and how many times the slot has
+    // been freed. Free slots chain through dense_idx.
+    u32                 *slot_dense_idx;
+    u32                 *slot_generation;
+    u32                 slot_count;
+    u32                 first_free_slot;
+
+    u64                 push_count;
+    u64                 despawn_count;
 };
 
-struct Chunk 
+// NOTE: chunk is 0 for an empty slot. The position is kept in the slot, so
+// probing doesn't touch the chunks.
+struct Chunk_Table_Slot
 {
-    s32             x;
-    s32             y;
-    s32             z;
-    Entity_List     entities;
-    Chunk           *next;
+    s32     x;
+    s32     y;
+    s32     z;
+    u32     hash;
+    Chunk   *chunk;
 };
 
-struct Chunk_List 
+// NOTE: open addressing with Robin Hood linear probing, so a miss stops as
+// soon as it's further from home than the slot it's looking at. Doubles
+// once it's 3/4 full; old slots stay behind on the arena, less than the
+// table they grew into all together.
+struct Chunk_Table
 {
-    Chunk   *head;
-    u32     count;
+    Memory_Arena        *arena;
+    Chunk_Table_Slot    *slots;
+    u32                 capacity;   // a power of two.
+    u32                 count;
 };
 
-struct Chunk_Hashmap 
+struct Chunk_Pool
 {
-    Chunk_List   chunks[4096];
+    Pool    pool;
+    Chunk   *first_free;
 };
 
+// NOTE: a chunk is in the table as long as it has entities or is in the
+// sim region. release_empty_chunks gives the rest back to the pool.
 struct World 
 {
-    Chunk_Hashmap   chunkHashmap;
+    Chunk_Table     chunk_table;
     v3              chunk_dim;
 
-    Entity          entities[1024];
-    u32             entityCount;
+    Entity_Store    entities;
+    Chunk_Pool      chunk_pool;
+
+    // NOTE: release_empty_chunks only walks the table when there's
+    // something new to release.
+    u32             emptied_chunk_count;
+    Chunk_Position  released_min_pos;
+    Chunk_Position  released_max_pos;
 };
 
 
@@ -281,6 +704,61 @@ struct Font
     Asset_Glyph         *glyphs[256];
 };
 
+//
+// Asset cache
+//
+// NOTE: models and animations, the assets that can be evicted. Fonts and
+// bitmaps stay in asset_arena for good.
+enum Cached_Asset
+{
+    eCached_Asset_Xbot_Model,
+    eCached_Asset_Cube_Model,
+    eCached_Asset_Octahedral_Model,
+    eCached_Asset_Sphere_Model,
+    eCached_Asset_Grass_Model,
+    eCached_Asset_Red_Wall_Model,
+    eCached_Asset_Green_Wall_Model,
+
+    eCached_Asset_Xbot_Idle,
+    eCached_Asset_Xbot_Run,
+
+    eCached_Asset_Count
+};
+
+// NOTE: the Model or Animation itself is the slot's, so pointers to it stay
+// good across evictions, e.g. an entity's animation channel. What it points
+// to is in the slot's arena, and is gone once the slot is evicted.
+struct Asset_Slot
+{
+    Asset_State     state;
+    u64             last_used_frame;
+    size_t          size;
+    Memory_Arena    arena;
+    union
+    {
+        Model       model;
+        Animation   animation;
+    };
+};
+
+struct Asset_Cache
+{
+    Platform_API    *platform;
+    // NOTE: blocks of evicted slots, lent to whichever slot loads next.
+    Memory_Block    *first_free_block;
+
+    u64             frame_idx;
+    size_t          budget;
+    size_t          used;
+
+    u64             hit_count;
+    u64             miss_count;
+    u64             eviction_count;
+    u64             failed_load_count;
+
+    Asset_Slot      slots[eCached_Asset_Count];
+};
+
 struct Game_Assets 
 {
     Asset_State         bitmapStates[GAI_Count];
@@ -291,35 +769,15 @@ struct Game_Assets
     Font                debug_font;
     Font                menu_font;
 
-    Model               *xbot_model;
-    Model               *cube_model;
-    Model               *sphere_model;
-    Model               *octahedral_model;
-
-    Model               *red_wall_model;
-    Model               *green_wall_model;
+    Asset_Cache         cache;
 
-    Model               *grass_model;
+    // NOTE: of the grass model, set every time it's loaded.
     f32                 grass_max_vertex_y;
     Bitmap              *turbulence_map;
 
-    Mesh                *star_mesh;
-
-    Animation           *xbot_idle;
-    Animation           *xbot_run;
-
     Read_Entire_File    *read_entire_file;
 };
 
-struct Load_Asset_Work_Data 
-{
-    Game_Assets         *game_assets;
-    Memory_Arena        *assetArena;
-    Asset_ID            assetID;
-    const char          *fileName;
-    Work_Memory_Arena   *workSlot;
-};
-
 struct Console_Cursor
 {
     v2 offset;
@@ -360,11 +818,16 @@ struct Game_State
     b32                 initted;
     f32                 time;
 
+    // NOTE: fixed-step sim. Frame time not yet simulated, and how far the
+    // frame is between the previous and the current step.
+    f32                 sim_accumulator;
+    f32                 sim_alpha;
+
     Game_Mode           mode;
 
     Random_Series       random_series;
 
-    Entity              *player;
+    Entity_Handle       player;
 
     World               *world;
     Memory_Arena        world_arena;
@@ -381,7 +844,7 @@ struct Game_State
     Camera              *orthographic_camera;
 
     // @TEMPORARY
-    Entity              *light;
+    Entity_Handle       light;
 
     // @TEMPORARY: this is meant to be in dev-engine memory.
     Console             console;
@@ -390,11 +853,16 @@ struct Game_State
 struct Transient_State 
 {
     b32                     init;
+    // NOTE: all of transient memory past this struct. Every arena in here
+    // grows out of it, but the ones carved out of the transient arena.
+    Memory_Block_Source     block_source;
     Memory_Arena            transient_arena;
     Platform_Work_Queue     *high_priority_queue;
     Platform_Work_Queue     *low_priority_queue;
 
-    Work_Memory_Arena       work_arenas[4];
+    Parallel_Context        parallel;
+
+    Memory_Arena            render_arenas[RENDER_MAX_FRAMES_IN_FLIGHT];
 
     Memory_Arena            asset_arena;
     Game_Assets             game_assets;
@@ -6,9 +6,16 @@
    $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
    ======================================================================== */
 
-#include <intrin.h>
+#if __MSVC
+  #include <intrin.h>
+#else
+  #include <x86intrin.h>
+  #include <unistd.h>
+  #include <sys/syscall.h>
+#endif
 
 
+#if __MSVC
 inline u32
 get_thread_id()
 {
@@ -16,6 +23,44 @@ get_thread_id()
     u32 thread_id = *(u32 *)(thread_local_storage + 0x48);
     return thread_id;
 }
+#else
+inline u32
+get_thread_id()
+{
+    // NOTE: gettid is a syscall, so cache it per thread.
+    static thread_local u32 thread_id;
+    if (!thread_id)
+    {
+        thread_id = (u32)syscall(SYS_gettid);
+    }
+    return thread_id;
+}
+#endif
+
+// NOTE: functions that use AVX2 are compiled for it one by one, so the rest
+// keep running on CPUs without it. Only call them when cpu_has_avx2 says so.
+#if __MSVC
+  #define TARGET_AVX2
+#else
+  #define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// NOTE: the CPU has it and the OS saves the ymm registers.
+inline b32
+cpu_has_avx2()
+{
+#if __MSVC
+    int info[4];
+    __cpuid(info, 1);
+    b32 os_saves_ymm = ((info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6);
+    __cpuidex(info, 7, 0);
+    b32 result = (os_saves_ymm && (info[1] & (1 << 5)));
+#else
+    __builtin_cpu_init();
+    b32 result = __builtin_cpu_supports("avx2");
+#endif
+    return result;
+}
 
 //
 // @trigonometry
@@ -23,28 +68,45 @@ get_thread_id()
 inline f32
 cos(f32 x) 
 {
+#if __MSVC
     f32 result = _mm_cvtss_f32(_mm_cos_ps(_mm_set1_ps(x)));
+#else
+    // NOTE: SVML is MSVC-only.
+    f32 result = __builtin_cosf(x);
+#endif
     return result;
 }
 
 inline f32
 acos(f32 x) 
 {
+#if __MSVC
     f32 result = _mm_cvtss_f32(_mm_acos_ps(_mm_set1_ps(x)));
+#else
+    f32 result = __builtin_acosf(x);
+#endif
     return result;
 }
 
 inline f32
 sin(f32 x) 
 {
+#if __MSVC
     f32 result = _mm_cvtss_f32(_mm_sin_ps(_mm_set1_ps(x)));
+#else
+    f32 result = __builtin_sinf(x);
+#endif
     return result;
 }
 
 inline f32
 tan(f32 x) 
 {
+#if __MSVC
     f32 result = _mm_cvtss_f32(_mm_tan_ps(_mm_set1_ps(x)));
+#else
+    f32 result = __builtin_tanf(x);
+#endif
     return result;
 }
 
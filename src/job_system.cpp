@@ -0,0 +1,853 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+
+/*
+ * Work-stealing job scheduler shared by the platform layers.
+ * Include after work_queue.cpp; it borrows the semaphore and the MPMC queue.
+ *
+ * Every job thread owns a Chase-Lev deque. The owner pushes and pops at the
+ * bottom (LIFO, so children run hot in cache), idle threads steal from the
+ * top of a random victim (FIFO, so they take the biggest pieces of work).
+ * The thread that calls job_system_init becomes worker 0 and only runs jobs
+ * while it waits on a counter. Threads that aren't job threads hand their
+ * jobs in through an MPMC injection queue and never run jobs themselves, so
+ * a job can always index per-thread data with job_system_get_thread_index.
+ *
+ * Jobs come out of a per-thread ring, so nothing is ever freed. A slot is
+ * reused only once the job in it has finished; if the whole ring is in flight
+ * the allocating thread helps running jobs.
+ *
+ * Fiber jobs (job_system_add_fiber_job) run on a stack of their own from a
+ * fixed pool. Waiting on a counter inside one doesn't help, it parks the
+ * fiber and gives the thread back; any worker resumes it once the counter
+ * hits zero. So the fiber may come back on another thread: don't hold
+ * per-thread data (scratch arenas, thread index) across a wait. With every
+ * fiber taken, a fiber job just runs on the thread like a plain one.
+ *
+ * The platform tells the system where the game module's code is
+ * (job_system_set_game_module). Jobs with a callback in there are counted on
+ * their own, so a hot reload waits for those only and platform jobs carry on.
+ */
+
+struct Platform_Core_Topology
+{
+    u32 logical_core_count;
+    u32 physical_core_count;
+};
+
+#define JOB_DEQUE_SIZE      4096
+#define JOB_POOL_SIZE       4096
+#define JOB_MAX_WORKERS     64
+#define JOB_SPIN_COUNT      64
+#define JOB_MAX_FIBERS      256
+
+struct Platform_Job
+{
+    Platform_Job_Callback   *callback;
+    void                    *data;
+    Platform_Job            *parent;
+    Platform_Job_Counter    *counter;
+    b32                     use_fiber;
+    b32                     in_game_module;
+
+    // itself plus unfinished children.
+    u32 volatile            unfinished_count;
+};
+
+struct Job_Deque
+{
+    alignas(64) u32 volatile    top;
+    alignas(64) u32 volatile    bottom;
+    Platform_Job * volatile     entries[JOB_DEQUE_SIZE];
+};
+
+struct Job_Pool
+{
+    u32 volatile    next;
+    Platform_Job    jobs[JOB_POOL_SIZE];
+};
+
+enum Job_Fiber_State
+{
+    eJob_Fiber_Free,
+    eJob_Fiber_Running,
+    eJob_Fiber_Waiting,
+};
+
+struct Job_Fiber
+{
+    u32 volatile            state;
+
+    Platform_Job            *job;
+    Platform_Job_Counter    *wait_counter;
+    // set by the fiber right before it switches out, acted on by the caller.
+    b32                     finished;
+
+    Job_Fiber               *caller_fiber;
+#if _WIN32
+    void                    *handle;
+    void                    *caller;
+#else
+    void                    *stack_pointer;
+    void                    *caller_stack_pointer;
+#endif
+};
+
+struct Platform_Job_System;
+struct Job_Worker
+{
+    Platform_Job_System *system;
+    u32                 worker_idx;
+    u32                 random_state;
+
+    Job_Deque           deque;
+    Job_Pool            pool;
+};
+
+struct Platform_Job_System
+{
+    u32                 worker_count;
+    Job_Worker          workers[JOB_MAX_WORKERS];
+
+    // for threads that aren't job threads.
+    Job_Pool            external_pool;
+    Platform_Work_Queue injection_queue;
+
+    alignas(64) u32 volatile sleeping_count;
+    alignas(64) u32 volatile outstanding_count;
+    Platform_Semaphore  semaphore;
+
+    u8                  *game_module_base;
+    u8                  *game_module_end;
+    alignas(64) u32 volatile game_module_outstanding_count;
+
+    u32                 fiber_count;
+    alignas(64) u32 volatile next_fiber;
+    alignas(64) u32 volatile waiting_fiber_count;
+    Job_Fiber           fibers[JOB_MAX_FIBERS];
+};
+
+global_var Platform_Job_System *g_job_system;
+global_var thread_local Job_Worker *t_job_worker;
+global_var thread_local Job_Fiber *t_job_fiber;
+
+//
+// Chase-Lev deque. Indices wrap, so compare them through signed differences.
+//
+internal b32
+job_deque_push(Job_Deque *deque, Platform_Job *job)
+{
+    u32 bottom = deque->bottom;
+    u32 top = atomic_load_u32(&deque->top, eMemory_Order_Acquire);
+    if ((s32)(bottom - top) >= JOB_DEQUE_SIZE)
+    {
+        return false;
+    }
+
+    deque->entries[bottom & (JOB_DEQUE_SIZE - 1)] = job;
+    atomic_store_u32(&deque->bottom, bottom + 1, eMemory_Order_Release);
+
+    return true;
+}
+
+internal Platform_Job *
+job_deque_pop(Job_Deque *deque)
+{
+    Platform_Job *result = 0;
+
+    u32 bottom = deque->bottom - 1;
+    deque->bottom = bottom;
+    atomic_fence(eMemory_Order_Seq_Cst);
+    u32 top = deque->top;
+
+    if ((s32)(bottom - top) >= 0)
+    {
+        result = deque->entries[bottom & (JOB_DEQUE_SIZE - 1)];
+        if (bottom == top)
+        {
+            // last one, race the thieves for it.
+            if (atomic_compare_exchange_u32(&deque->top, top + 1, top) != top)
+            {
+                result = 0;
+            }
+            deque->bottom = bottom + 1;
+        }
+    }
+    else
+    {
+        deque->bottom = bottom + 1;
+    }
+
+    return result;
+}
+
+internal Platform_Job *
+job_deque_steal(Job_Deque *deque)
+{
+    Platform_Job *result = 0;
+
+    u32 top = atomic_load_u32(&deque->top, eMemory_Order_Acquire);
+    atomic_fence(eMemory_Order_Seq_Cst);
+    u32 bottom = atomic_load_u32(&deque->bottom, eMemory_Order_Acquire);
+
+    if ((s32)(bottom - top) > 0)
+    {
+        Platform_Job *job = deque->entries[top & (JOB_DEQUE_SIZE - 1)];
+        if (atomic_compare_exchange_u32(&deque->top, top + 1, top) == top)
+        {
+            result = job;
+        }
+    }
+
+    return result;
+}
+
+inline b32
+job_deque_is_empty(Job_Deque *deque)
+{
+    b32 result = ((s32)(deque->bottom - deque->top) <= 0);
+    return result;
+}
+
+//
+// Scheduling
+//
+internal b32 job_system_run_next(Platform_Job_System *system, Job_Worker *worker);
+
+// NOTE: for work on a counter that doesn't run as a job, like a file read.
+// Add before the work is issued, done when it is over.
+inline void
+job_counter_add(Platform_Job_Counter *counter, u32 count)
+{
+    atomic_add_u32(&counter->value, count);
+}
+
+internal void
+job_counter_done(Platform_Job_System *system, Platform_Job_Counter *counter)
+{
+    if (atomic_add_u32(&counter->value, (u32)-1) == 1 &&
+        system->waiting_fiber_count)
+    {
+        // a parked fiber may be runnable now.
+        platform_release_semaphore(&system->semaphore);
+    }
+}
+
+internal void
+job_finish(Platform_Job_System *system, Platform_Job *job)
+{
+    // NOTE: read everything before the decrement, the slot can be reused
+    // right after it.
+    Platform_Job *parent = job->parent;
+    Platform_Job_Counter *counter = job->counter;
+    b32 in_game_module = job->in_game_module;
+
+    if (atomic_add_u32(&job->unfinished_count, (u32)-1) == 1)
+    {
+        if (counter)
+        {
+            job_counter_done(system, counter);
+        }
+        if (in_game_module)
+        {
+            atomic_add_u32(&system->game_module_outstanding_count, (u32)-1);
+        }
+        atomic_add_u32(&system->outstanding_count, (u32)-1);
+
+        if (parent)
+        {
+            job_finish(system, parent);
+        }
+    }
+}
+
+internal void job_run_on_fiber(Platform_Job_System *system, Platform_Job *job);
+
+inline void
+job_run(Platform_Job_System *system, Platform_Job *job)
+{
+    if (job->use_fiber)
+    {
+        job_run_on_fiber(system, job);
+    }
+    else
+    {
+        job->callback(job, job->data);
+        job_finish(system, job);
+    }
+}
+
+// run something if this is a job thread, otherwise just back off.
+inline void
+job_system_help(Platform_Job_System *system, Job_Worker *worker)
+{
+    if (!worker || !job_system_run_next(system, worker))
+    {
+        _mm_pause();
+    }
+}
+
+// NOTE: long-lived parents hold their slot while the ring laps them, so
+// busy slots are skipped. A slot is claimed by moving its count off zero.
+// The ring cursor is only a hint, so it is bumped relaxed.
+internal Platform_Job *
+job_alloc(Platform_Job_System *system, Job_Worker *worker)
+{
+    Job_Pool *pool = worker ? &worker->pool : &system->external_pool;
+
+    for (;;)
+    {
+        for (u32 idx = 0;
+             idx < JOB_POOL_SIZE;
+             ++idx)
+        {
+            Platform_Job *job = pool->jobs + (atomic_add_u32(&pool->next, 1, eMemory_Order_Relaxed) & (JOB_POOL_SIZE - 1));
+            if (atomic_compare_exchange_u32(&job->unfinished_count, 1, 0, eMemory_Order_Acquire) == 0)
+            {
+                return job;
+            }
+        }
+
+        // every slot is in flight.
+        job_system_help(system, worker);
+    }
+}
+
+inline void
+job_system_wake_one(Platform_Job_System *system)
+{
+    atomic_fence(eMemory_Order_Seq_Cst);
+    if (system->sleeping_count)
+    {
+        platform_release_semaphore(&system->semaphore);
+    }
+}
+
+internal void
+job_system_push_job(Platform_Job_Counter *counter, Platform_Job *parent,
+                    Platform_Job_Callback *callback, void *data, b32 use_fiber)
+{
+    Job_Worker *worker = t_job_worker;
+    Platform_Job_System *system = worker ? worker->system : g_job_system;
+    Assert(!use_fiber || system->fiber_count);
+
+    Platform_Job *job       = job_alloc(system, worker);
+    job->callback           = callback;
+    job->data               = data;
+    job->parent             = parent;
+    job->counter            = counter;
+    job->use_fiber          = use_fiber;
+    job->in_game_module     = ((u8 *)callback >= system->game_module_base &&
+                               (u8 *)callback < system->game_module_end);
+
+    if (parent)
+    {
+        atomic_add_u32(&parent->unfinished_count, 1);
+    }
+    if (counter)
+    {
+        atomic_add_u32(&counter->value, 1);
+    }
+    if (job->in_game_module)
+    {
+        atomic_add_u32(&system->game_module_outstanding_count, 1);
+    }
+    atomic_add_u32(&system->outstanding_count, 1);
+
+    if (worker)
+    {
+        if (!job_deque_push(&worker->deque, job))
+        {
+            // back-pressure: the deque is full, just do it now.
+            job_run(system, job);
+            return;
+        }
+    }
+    else
+    {
+        while (!work_queue_try_add(&system->injection_queue, 0, job))
+        {
+            _mm_pause();
+        }
+    }
+
+    job_system_wake_one(system);
+}
+
+internal void
+job_system_add_job(Platform_Job_Counter *counter, Platform_Job *parent,
+                   Platform_Job_Callback *callback, void *data)
+{
+    job_system_push_job(counter, parent, callback, data, false);
+}
+
+// NOTE: needs job_system_init_fibers.
+internal void
+job_system_add_fiber_job(Platform_Job_Counter *counter, Platform_Job *parent,
+                         Platform_Job_Callback *callback, void *data)
+{
+    job_system_push_job(counter, parent, callback, data, true);
+}
+
+internal Platform_Job *
+job_system_steal(Platform_Job_System *system, Job_Worker *worker)
+{
+    Platform_Job *result = 0;
+
+    u32 start = 0;
+    if (worker)
+    {
+        // xorshift
+        u32 x = worker->random_state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        worker->random_state = x;
+        start = x;
+    }
+
+    for (u32 idx = 0;
+         idx < system->worker_count && !result;
+         ++idx)
+    {
+        Job_Worker *victim = system->workers + ((start + idx) % system->worker_count);
+        if (victim != worker)
+        {
+            result = job_deque_steal(&victim->deque);
+        }
+    }
+
+    return result;
+}
+
+//
+// Fibers
+//
+// NOTE: a fiber can move between threads, and the compiler may keep a
+// thread-local's address in a register across a switch. Fiber-side code
+// reads t_job_fiber only through this.
+#if _WIN32
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+internal Job_Fiber *
+job_get_current_fiber()
+{
+    return t_job_fiber;
+}
+
+#if _WIN32
+internal void CALLBACK job_fiber_proc(void *parameter);
+
+inline void
+job_fiber_create(Job_Fiber *fiber, void *stack, size_t stack_size)
+{
+    // NOTE: Windows fibers can't be handed a stack, the OS reserves it.
+    fiber->handle = CreateFiberEx(stack_size, stack_size, 0, job_fiber_proc, fiber);
+}
+
+inline void
+job_fiber_switch_in(Job_Fiber *fiber)
+{
+    if (!IsThreadAFiber())
+    {
+        ConvertThreadToFiber(0);
+    }
+    fiber->caller = GetCurrentFiber();
+    SwitchToFiber(fiber->handle);
+}
+
+inline void
+job_fiber_switch_out(Job_Fiber *fiber)
+{
+    SwitchToFiber(fiber->caller);
+}
+#else
+// x86-64 System V: push the callee-saved registers and the SSE/x87 control
+// words, swap stacks, pop the other side's.
+extern "C" void job_fiber_switch(void **save_stack_pointer, void *load_stack_pointer);
+extern "C" void job_fiber_start();
+asm(R"(
+    .text
+job_fiber_switch:
+    pushq   %rbp
+    pushq   %rbx
+    pushq   %r12
+    pushq   %r13
+    pushq   %r14
+    pushq   %r15
+    subq    $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw  4(%rsp)
+    movq    %rsp, (%rdi)
+    movq    %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw   4(%rsp)
+    addq    $8, %rsp
+    popq    %r15
+    popq    %r14
+    popq    %r13
+    popq    %r12
+    popq    %rbx
+    popq    %rbp
+    ret
+
+job_fiber_start:
+    movq    %r12, %rdi
+    andq    $-16, %rsp
+    call    job_fiber_entry
+    ud2
+)");
+
+extern "C" void job_fiber_entry(Job_Fiber *fiber);
+
+inline void
+job_fiber_create(Job_Fiber *fiber, void *stack, size_t stack_size)
+{
+    // the lowest page catches overflows.
+    mprotect(stack, 4096, PROT_NONE);
+
+    // what job_fiber_switch pops: control words, r15..r12, rbx, rbp, return.
+    u64 *top = (u64 *)(((u64)stack + stack_size) & ~(u64)15);
+    u64 *sp = top - 8;
+    u32 control_words[2] = {0x1F80, 0x037F};
+    memcpy(sp, control_words, sizeof(control_words));
+    sp[1] = 0;                      // r15
+    sp[2] = 0;                      // r14
+    sp[3] = 0;                      // r13
+    sp[4] = (u64)fiber;             // r12
+    sp[5] = 0;                      // rbx
+    sp[6] = 0;                      // rbp
+    sp[7] = (u64)job_fiber_start;
+    fiber->stack_pointer = sp;
+}
+
+inline void
+job_fiber_switch_in(Job_Fiber *fiber)
+{
+    job_fiber_switch(&fiber->caller_stack_pointer, fiber->stack_pointer);
+}
+
+inline void
+job_fiber_switch_out(Job_Fiber *fiber)
+{
+    job_fiber_switch(&fiber->stack_pointer, fiber->caller_stack_pointer);
+}
+#endif
+
+// every fiber runs this forever, one job per trip.
+#if _WIN32
+internal void CALLBACK
+job_fiber_proc(void *parameter)
+#else
+extern "C" void
+job_fiber_entry(Job_Fiber *parameter)
+#endif
+{
+    Job_Fiber *fiber = (Job_Fiber *)parameter;
+    for (;;)
+    {
+        Platform_Job *job = fiber->job;
+        job->callback(job, job->data);
+        job_finish(g_job_system, job);
+
+        fiber->finished = true;
+        job_fiber_switch_out(fiber);
+    }
+}
+
+// switch to the fiber until it finishes or parks, then settle its state
+// from this side, where its stack is no longer in use.
+internal void
+job_fiber_run(Platform_Job_System *system, Job_Fiber *fiber)
+{
+    fiber->caller_fiber = t_job_fiber;
+    fiber->finished = false;
+    t_job_fiber = fiber;
+
+    job_fiber_switch_in(fiber);
+
+    t_job_fiber = fiber->caller_fiber;
+    if (fiber->finished)
+    {
+        fiber->job = 0;
+        atomic_store_u32(&fiber->state, eJob_Fiber_Free, eMemory_Order_Release);
+    }
+    else
+    {
+        atomic_add_u32(&system->waiting_fiber_count, 1);
+        atomic_store_u32(&fiber->state, eJob_Fiber_Waiting, eMemory_Order_Release);
+    }
+}
+
+internal void
+job_fiber_yield(Platform_Job_Counter *counter)
+{
+    Job_Fiber *fiber = job_get_current_fiber();
+    fiber->wait_counter = counter;
+    job_fiber_switch_out(fiber);
+    // NOTE: possibly on another thread from here on.
+}
+
+internal Job_Fiber *
+job_claim_free_fiber(Platform_Job_System *system)
+{
+    for (u32 idx = 0;
+         idx < system->fiber_count;
+         ++idx)
+    {
+        Job_Fiber *fiber = system->fibers + (atomic_add_u32(&system->next_fiber, 1, eMemory_Order_Relaxed) % system->fiber_count);
+        if (fiber->state == eJob_Fiber_Free &&
+            atomic_compare_exchange_u32(&fiber->state, eJob_Fiber_Running, eJob_Fiber_Free) == eJob_Fiber_Free)
+        {
+            return fiber;
+        }
+    }
+    return 0;
+}
+
+// returns false if no parked fiber was ready.
+internal b32
+job_resume_fiber(Platform_Job_System *system)
+{
+    for (u32 idx = 0;
+         idx < system->fiber_count;
+         ++idx)
+    {
+        Job_Fiber *fiber = system->fibers + idx;
+        if (fiber->state == eJob_Fiber_Waiting &&
+            atomic_load_u32(&fiber->wait_counter->value, eMemory_Order_Acquire) == 0 &&
+            atomic_compare_exchange_u32(&fiber->state, eJob_Fiber_Running, eJob_Fiber_Waiting) == eJob_Fiber_Waiting)
+        {
+            atomic_add_u32(&system->waiting_fiber_count, (u32)-1);
+            job_fiber_run(system, fiber);
+            return true;
+        }
+    }
+    return false;
+}
+
+internal void
+job_run_on_fiber(Platform_Job_System *system, Platform_Job *job)
+{
+    Job_Fiber *fiber = job_claim_free_fiber(system);
+    if (fiber)
+    {
+        fiber->job = job;
+        job_fiber_run(system, fiber);
+    }
+    else
+    {
+        // NOTE: every fiber is taken. Run it right here like any other job,
+        // its waits then help instead of parking. Queueing it up instead
+        // could deadlock when all fibers wait on jobs behind this one.
+        job->callback(job, job->data);
+        job_finish(system, job);
+    }
+}
+
+// returns false if there was nothing to run.
+internal b32
+job_system_run_next(Platform_Job_System *system, Job_Worker *worker)
+{
+    if (system->waiting_fiber_count && job_resume_fiber(system))
+    {
+        return true;
+    }
+
+    Platform_Job *job = 0;
+
+    if (worker)
+    {
+        job = job_deque_pop(&worker->deque);
+    }
+    if (!job)
+    {
+        Platform_Work_Queue_Entry entry;
+        if (work_queue_try_take(&system->injection_queue, &entry))
+        {
+            job = (Platform_Job *)entry.data;
+        }
+    }
+    if (!job)
+    {
+        job = job_system_steal(system, worker);
+    }
+
+    if (job)
+    {
+        job_run(system, job);
+    }
+
+    return (job != 0);
+}
+
+internal b32
+job_system_has_work(Platform_Job_System *system)
+{
+    b32 result = (system->injection_queue.next_entry_to_read !=
+                  system->injection_queue.next_entry_to_write);
+
+    for (u32 idx = 0;
+         idx < system->worker_count && !result;
+         ++idx)
+    {
+        result = !job_deque_is_empty(&system->workers[idx].deque);
+    }
+
+    for (u32 idx = 0;
+         idx < system->fiber_count && system->waiting_fiber_count && !result;
+         ++idx)
+    {
+        Job_Fiber *fiber = system->fibers + idx;
+        result = (fiber->state == eJob_Fiber_Waiting &&
+                  atomic_load_u32(&fiber->wait_counter->value, eMemory_Order_Acquire) == 0);
+    }
+
+    return result;
+}
+
+internal void
+job_system_wait_for_counter(Platform_Job_Counter *counter)
+{
+    if (job_get_current_fiber())
+    {
+        if (atomic_load_u32(&counter->value, eMemory_Order_Acquire) != 0)
+        {
+            job_fiber_yield(counter);
+        }
+        return;
+    }
+
+    Job_Worker *worker = t_job_worker;
+    Platform_Job_System *system = worker ? worker->system : g_job_system;
+
+    while (atomic_load_u32(&counter->value, eMemory_Order_Acquire) != 0)
+    {
+        job_system_help(system, worker);
+    }
+}
+
+// index of the calling job thread, worker_count for any other thread.
+internal u32
+job_system_get_thread_index()
+{
+    u32 result = t_job_worker ? t_job_worker->worker_idx : g_job_system->worker_count;
+    return result;
+}
+
+// everything in flight, from every thread.
+internal void
+job_system_complete_all_jobs(Platform_Job_System *system)
+{
+    Job_Worker *worker = (t_job_worker && t_job_worker->system == system) ? t_job_worker : 0;
+    while (atomic_load_u32(&system->outstanding_count, eMemory_Order_Acquire) != 0)
+    {
+        job_system_help(system, worker);
+    }
+}
+
+// NOTE: only call this with no game jobs in flight, e.g. right after
+// job_system_complete_game_module_jobs.
+internal void
+job_system_set_game_module(Platform_Job_System *system, void *base, u64 size)
+{
+    system->game_module_base = (u8 *)base;
+    system->game_module_end  = (u8 *)base + size;
+}
+
+// the jobs that would run game module code, before that module goes away.
+internal void
+job_system_complete_game_module_jobs(Platform_Job_System *system)
+{
+    Job_Worker *worker = (t_job_worker && t_job_worker->system == system) ? t_job_worker : 0;
+    while (atomic_load_u32(&system->game_module_outstanding_count, eMemory_Order_Acquire) != 0)
+    {
+        job_system_help(system, worker);
+    }
+}
+
+// worker_count includes the calling thread, which becomes worker 0.
+// The platform layer starts worker_count - 1 threads on job_system_thread_loop.
+internal void
+job_system_init(Platform_Job_System *system, u32 worker_count)
+{
+    if (worker_count < 1)               worker_count = 1;
+    if (worker_count > JOB_MAX_WORKERS) worker_count = JOB_MAX_WORKERS;
+
+    system->worker_count = worker_count;
+    for (u32 idx = 0;
+         idx < worker_count;
+         ++idx)
+    {
+        Job_Worker *worker      = system->workers + idx;
+        worker->system          = system;
+        worker->worker_idx      = idx;
+        worker->random_state    = 0x9E3779B9u * (idx + 1);
+    }
+
+    work_queue_init(&system->injection_queue, 0);
+    platform_init_semaphore(&system->semaphore, worker_count);
+
+    t_job_worker = system->workers;
+    g_job_system = system;
+}
+
+// Optional. Carves fiber_count stacks of stack_size out of memory, which
+// must hold fiber_count * stack_size bytes, page aligned.
+internal void
+job_system_init_fibers(Platform_Job_System *system, void *memory, size_t stack_size, u32 fiber_count)
+{
+    if (fiber_count > JOB_MAX_FIBERS) fiber_count = JOB_MAX_FIBERS;
+
+    for (u32 idx = 0;
+         idx < fiber_count;
+         ++idx)
+    {
+        Job_Fiber *fiber = system->fibers + idx;
+        fiber->state = eJob_Fiber_Free;
+        job_fiber_create(fiber, (u8 *)memory + idx * stack_size, stack_size);
+    }
+
+    system->fiber_count = fiber_count;
+}
+
+internal void
+job_system_thread_loop(Job_Worker *worker)
+{
+    Platform_Job_System *system = worker->system;
+    t_job_worker = worker;
+
+    for (;;)
+    {
+        b32 did_work = false;
+        for (u32 spin = 0;
+             spin < JOB_SPIN_COUNT && !did_work;
+             ++spin)
+        {
+            did_work = job_system_run_next(system, worker);
+            if (!did_work)
+            {
+                _mm_pause();
+            }
+        }
+
+        if (!did_work)
+        {
+            // NOTE: announce first, look again after. A producer pushes first
+            // and looks at sleeping_count after, so one of us sees the other.
+            atomic_add_u32(&system->sleeping_count, 1);
+            if (!job_system_has_work(system))
+            {
+                platform_wait_semaphore(&system->semaphore);
+            }
+            atomic_add_u32(&system->sleeping_count, (u32)-1);
+        }
+    }
+}
@@ -0,0 +1,1423 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+/*
+ * Headless Linux host. No window, no GL, no audio: it loads game.so, feeds
+ * a scripted input stream and runs game_update + debug_frame_end for a fixed
+ * number of frames, then reports per-frame wall time.
+ *
+ * usage: linux [--frames N] [--dt seconds] [--width W] [--height H] [--script file]
+ *              [--frames-in-flight N] [--render-ms ms] [--io io_uring|pread]
+ *              [--loop-start frame] [--loop-frames N] [--huge-pages off|thp|hugetlb]
+ * Batches go to a render thread that stands in for GL, up to N frames behind.
+ * With --loop-frames, the input of frames [loop-start, loop-start + N) is
+ * recorded and then played back over and over from a snapshot, like the
+ * looped live-editing of win32.
+ * Run it with the data folder as the working directory, same as win32.exe.
+ */
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <link.h>
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "types.h"
+#include "game.h"
+#include "render_group.h"
+#include "linux.h"
+
+inline u64
+linux_get_wall_clock()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    u64 result = (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+    return result;
+}
+
+inline f32
+linux_get_seconds_elapsed(u64 begin, u64 end)
+{
+    f32 result = (f32)((f64)(end - begin) / 1000000000.0);
+    return result;
+}
+
+inline f64
+linux_get_elapsed_ms(u64 begin, u64 end)
+{
+    f64 result = (f64)(end - begin) / 1000000.0;
+    return result;
+}
+
+DEBUG_PLATFORM_FREE_MEMORY(linux_free_memory)
+{
+    if (memory) free(memory);
+}
+
+PLATFORM_READ_ENTIRE_FILE(linux_read_entire_file)
+{
+    Entire_File result = {};
+
+    int fd = open(filename, O_RDONLY);
+    if (fd != -1)
+    {
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == 0)
+        {
+            u32 filesize32 = (u32)file_stat.st_size;
+            result.contents = malloc(filesize32);
+            if (result.contents)
+            {
+                u8 *at = (u8 *)result.contents;
+                u32 bytes_left = filesize32;
+                while (bytes_left)
+                {
+                    ssize_t bytes_read = read(fd, at, bytes_left);
+                    if (bytes_read <= 0)
+                    {
+                        break;
+                    }
+                    at += bytes_read;
+                    bytes_left -= (u32)bytes_read;
+                }
+
+                if (bytes_left == 0)
+                {
+                    result.content_size = filesize32;
+                }
+                else
+                {
+                    linux_free_memory(result.contents);
+                    result.contents = 0;
+                }
+            }
+        }
+        close(fd);
+    }
+    else
+    {
+        fprintf(stderr, "couldn't open %s\n", filename);
+    }
+
+    return result;
+}
+
+DEBUG_PLATFORM_WRITE_FILE(linux_write_entire_file)
+{
+    b32 result = false;
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd != -1)
+    {
+        ssize_t bytes_written = write(fd, contents, size);
+        result = (bytes_written == (ssize_t)size);
+        close(fd);
+    }
+
+    return result;
+}
+
+// NOTE: command_line is handed to the shell; path is the working directory.
+DEBUG_PLATFORM_EXECUTE_SYSTEM_COMMAND(linux_execute_system_command)
+{
+    Debug_Executing_Process result = {};
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        if (path) chdir(path);
+        execl("/bin/sh", "sh", "-c", command_line, (char *)0);
+        _exit(127);
+    }
+    result.os_handle = (pid > 0) ? (u64)pid : 0;
+
+    return result;
+}
+
+DEBUG_PLATFORM_GET_PROCESS_STATE(linux_get_process_state)
+{
+    Debug_Process_State result = {};
+
+    pid_t pid = (pid_t)process.os_handle;
+    if (pid > 0)
+    {
+        result.started_successfully = true;
+
+        int status;
+        if (waitpid(pid, &status, WNOHANG) == pid)
+        {
+            result.return_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        }
+        else
+        {
+            result.is_running = true;
+        }
+    }
+
+    return result;
+}
+
+internal void
+linux_init_render_batch(Render_Batch *batch, size_t size)
+{
+    batch->base     = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    batch->size     = size;
+    batch->used     = 0;
+
+    batch->width    = 0;
+    batch->height   = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Multi-Threading
+//
+
+#include "work_queue.cpp"
+#include "job_system.cpp"
+#include "frame_pipeline.cpp"
+#include "linux_file_io.cpp"
+#include "snapshot.cpp"
+
+internal
+FRAME_PIPELINE_RENDER(linux_render_batch)
+{
+    Linux_Null_Renderer *renderer = (Linux_Null_Renderer *)data;
+    u64 begin = linux_get_wall_clock();
+
+    for (Render_Group *group = (Render_Group *)batch->base;
+         (u8 *)group < (u8 *)batch->base + batch->used;
+         ++group)
+    {
+        ++renderer->group_count;
+        for (u8 *at = group->base;
+             at < group->base + group->used;
+             at += ((Render_Entity_Header *)at)->size)
+        {
+            ++renderer->piece_count;
+        }
+    }
+
+    while (linux_get_elapsed_ms(begin, linux_get_wall_clock()) < renderer->render_ms)
+    {
+        _mm_pause();
+    }
+}
+
+internal void *
+linux_render_thread_proc(void *parameter)
+{
+    frame_pipeline_render_loop((Platform_Frame_Pipeline *)parameter);
+    return 0;
+}
+
+internal void *
+linux_thread_proc(void *parameter)
+{
+    Platform_Work_Queue *queue = (Platform_Work_Queue *)parameter;
+    work_queue_thread_loop(queue);
+    return 0;
+}
+
+internal void
+linux_make_queue(Platform_Work_Queue *queue, u32 thread_count)
+{
+    work_queue_init(queue, thread_count);
+
+    for (u32 thread_idx = 0;
+         thread_idx < thread_count;
+         ++thread_idx)
+    {
+        pthread_t thread;
+        pthread_create(&thread, 0, linux_thread_proc, queue);
+        pthread_detach(thread);
+    }
+}
+
+internal void *
+linux_job_thread_proc(void *parameter)
+{
+    job_system_thread_loop((Job_Worker *)parameter);
+    return 0;
+}
+
+internal Platform_Job_System *
+linux_make_job_system(u32 worker_count)
+{
+    Platform_Job_System *system = (Platform_Job_System *)mmap(0, sizeof(Platform_Job_System),
+                                                              PROT_READ | PROT_WRITE,
+                                                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    job_system_init(system, worker_count);
+
+    // worker 0 is this thread.
+    for (u32 worker_idx = 1;
+         worker_idx < system->worker_count;
+         ++worker_idx)
+    {
+        pthread_t thread;
+        pthread_create(&thread, 0, linux_job_thread_proc, system->workers + worker_idx);
+        pthread_detach(thread);
+    }
+
+    return system;
+}
+
+internal u32
+linux_read_sysfs_u32(const char *path)
+{
+    u32 result = 0;
+    FILE *file = fopen(path, "r");
+    if (file)
+    {
+        if (fscanf(file, "%u", &result) != 1)
+        {
+            result = 0;
+        }
+        fclose(file);
+    }
+    return result;
+}
+
+// NOTE: a physical core is a distinct (package, core) pair in sysfs.
+internal Platform_Core_Topology
+linux_get_core_topology()
+{
+    Platform_Core_Topology result = {};
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    result.logical_core_count = (online > 0) ? (u32)online : 1;
+
+    u64 cores[1024];
+    for (u32 cpu_idx = 0;
+         cpu_idx < result.logical_core_count && cpu_idx < array_count(cores);
+         ++cpu_idx)
+    {
+        char path[256];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu_idx);
+        u64 package_id = linux_read_sysfs_u32(path);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu_idx);
+        u64 core_id = linux_read_sysfs_u32(path);
+        u64 core = (package_id << 32) | core_id;
+
+        b32 seen = false;
+        for (u32 idx = 0; idx < result.physical_core_count; ++idx)
+        {
+            if (cores[idx] == core)
+            {
+                seen = true;
+                break;
+            }
+        }
+        if (!seen)
+        {
+            cores[result.physical_core_count++] = core;
+        }
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Game Module
+//
+
+// NOTE: the loaded module's address range, from its PT_LOAD segments.
+internal int
+linux_find_module_range(struct dl_phdr_info *info, size_t size, void *data)
+{
+    Linux_Game *game = (Linux_Game *)data;
+    if (info->dlpi_addr != game->link_map_addr)
+    {
+        return 0;
+    }
+
+    u8 *base = 0;
+    u8 *end = 0;
+    for (u32 idx = 0;
+         idx < info->dlpi_phnum;
+         ++idx)
+    {
+        const ElfW(Phdr) *segment = info->dlpi_phdr + idx;
+        if (segment->p_type == PT_LOAD)
+        {
+            u8 *segment_base = (u8 *)(info->dlpi_addr + segment->p_vaddr);
+            u8 *segment_end = segment_base + segment->p_memsz;
+            base = (base && base < segment_base) ? base : segment_base;
+            end = (end > segment_end) ? end : segment_end;
+        }
+    }
+    game->module_base = base;
+    game->module_size = (u64)(end - base);
+    return 1;
+}
+
+// NOTE: the image is loaded from a copy that is deleted right away, so the
+// build can write game.so while it is loaded. dlopen matches loaded objects
+// by name and hands back the old image for a path it has seen, so every load
+// needs a path of its own.
+internal void
+linux_load_game(Linux_Game *game, const char *so_path, const char *load_path)
+{
+    *game = {};
+
+    int source = open(so_path, O_RDONLY);
+    int dest = open(load_path, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+    struct stat source_stat;
+    b32 copied = false;
+    if (source != -1 && dest != -1 && fstat(source, &source_stat) == 0)
+    {
+        off_t offset = 0;
+        while (offset < source_stat.st_size &&
+               sendfile(dest, source, &offset, (size_t)(source_stat.st_size - offset)) > 0)
+        {
+        }
+        copied = (offset == source_stat.st_size);
+    }
+    if (source != -1) close(source);
+    if (dest != -1) close(dest);
+
+    if (copied)
+    {
+        game->so = dlopen(load_path, RTLD_NOW | RTLD_LOCAL);
+    }
+    unlink(load_path);
+
+    if (game->so)
+    {
+        game->game_update       = (Game_Update *)dlsym(game->so, "game_update");
+        game->debug_frame_end   = (Debug_Frame_End *)dlsym(game->so, "debug_frame_end");
+
+        game->is_valid          = (game->game_update != 0);
+        if (!game->is_valid)
+        {
+            game->game_update = 0;
+        }
+
+        struct link_map *map = 0;
+        if (dlinfo(game->so, RTLD_DI_LINKMAP, &map) == 0)
+        {
+            game->link_map_addr = map->l_addr;
+            dl_iterate_phdr(linux_find_module_range, game);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "dlopen failed: %s\n", copied ? dlerror() : so_path);
+    }
+}
+
+internal void
+linux_unload_game(Linux_Game *game)
+{
+    if (game->so)
+    {
+        dlclose(game->so);
+    }
+    *game = {};
+}
+
+// NOTE: watches the directory rather than the file, the linker may write a
+// new file in place of the old one.
+internal void
+linux_watch_game(Linux_Game_Watch *watch, const char *so_path)
+{
+    *watch = {};
+
+    char directory[4096];
+    snprintf(directory, sizeof(directory), "%s", so_path);
+    char *last_slash = strrchr(directory, '/');
+    watch->file_name = so_path;
+    if (last_slash)
+    {
+        watch->file_name = so_path + (last_slash - directory) + 1;
+        *last_slash = 0;
+    }
+    else
+    {
+        snprintf(directory, sizeof(directory), ".");
+    }
+
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->fd != -1)
+    {
+        inotify_add_watch(watch->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+    }
+}
+
+// NOTE: doesn't block. True once game.so has been written out again.
+internal b32
+linux_game_changed(Linux_Game_Watch *watch)
+{
+    b32 result = false;
+    if (watch->fd == -1)
+    {
+        return result;
+    }
+
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t bytes_read = read(watch->fd, buffer, sizeof(buffer));
+        if (bytes_read <= 0)
+        {
+            break;
+        }
+
+        for (char *at = buffer;
+             at < buffer + bytes_read;
+             at += sizeof(struct inotify_event) + ((struct inotify_event *)at)->len)
+        {
+            struct inotify_event *event = (struct inotify_event *)at;
+            if (event->len && strcmp(event->name, watch->file_name) == 0)
+            {
+                result = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Scripted Input
+//
+
+struct Linux_Key_Name
+{
+    const char  *name;
+    u8          key;
+};
+
+global_var Linux_Key_Name g_linux_key_names[] =
+{
+    {"ESC",         KEY_ESC},
+    {"SPACE",       KEY_SPACE},
+    {"ENTER",       KEY_ENTER},
+    {"TAB",         KEY_TAB},
+    {"BACKSPACE",   KEY_BACKSPACE},
+    {"SHIFT",       KEY_LEFTSHIFT},
+    {"TILDE",       KEY_HASHTILDE},
+    {"LEFT",        KEY_LEFT},
+    {"RIGHT",       KEY_RIGHT},
+    {"UP",          KEY_UP},
+    {"DOWN",        KEY_DOWN},
+};
+
+internal b32
+linux_key_from_name(const char *name, u8 *key)
+{
+    b32 result = false;
+
+    if (name[0] && !name[1])
+    {
+        if (name[0] >= 'A' && name[0] <= 'Z')
+        {
+            *key = (u8)(KEY_A + (name[0] - 'A'));
+            result = true;
+        }
+        else if (name[0] >= '0' && name[0] <= '9')
+        {
+            *key = (u8)(KEY_0 + (name[0] - '0'));
+            result = true;
+        }
+    }
+    else
+    {
+        for (u32 idx = 0;
+             idx < array_count(g_linux_key_names);
+             ++idx)
+        {
+            if (strcmp(name, g_linux_key_names[idx].name) == 0)
+            {
+                *key = g_linux_key_names[idx].key;
+                result = true;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+internal void
+linux_push_script_event(Linux_Input_Script *script, u32 frame_idx, u8 key, u8 flag)
+{
+    if (script->event_count < array_count(script->events))
+    {
+        Linux_Script_Event *script_event = script->events + script->event_count++;
+        script_event->frame_idx     = frame_idx;
+        script_event->event.key     = key;
+        script_event->event.flag    = flag;
+    }
+}
+
+// NOTE: Run forward, turn, and stop, so that both the idle/run blend and the
+// chunk remapping get exercised every cycle.
+internal void
+linux_default_script(Linux_Input_Script *script, u32 frame_count)
+{
+    for (u32 cycle = 0;
+         cycle < frame_count;
+         cycle += 240)
+    {
+        linux_push_script_event(script, cycle +   0, KEY_W, PRESSED);
+        linux_push_script_event(script, cycle +  60, KEY_D, PRESSED);
+        linux_push_script_event(script, cycle +  90, KEY_D, RELEASED);
+        linux_push_script_event(script, cycle + 180, KEY_W, RELEASED);
+    }
+}
+
+internal b32
+linux_load_script(Linux_Input_Script *script, const char *file_name)
+{
+    b32 result = false;
+
+    FILE *file = fopen(file_name, "r");
+    if (file)
+    {
+        char line[256];
+        u32 line_number = 0;
+        while (fgets(line, sizeof(line), file))
+        {
+            ++line_number;
+            if (line[0] == '#' || line[0] == '\n')
+            {
+                continue;
+            }
+
+            u32 frame_idx;
+            char key_name[64];
+            char action[16];
+            u8 key;
+            if (sscanf(line, "%u %63s %15s", &frame_idx, key_name, action) == 3 &&
+                linux_key_from_name(key_name, &key))
+            {
+                u8 flag = (strcmp(action, "down") == 0) ? PRESSED : RELEASED;
+                linux_push_script_event(script, frame_idx, key, flag);
+            }
+            else
+            {
+                fprintf(stderr, "%s(%u): can't parse script line\n", file_name, line_number);
+            }
+        }
+        fclose(file);
+        result = true;
+    }
+
+    return result;
+}
+
+internal void
+linux_feed_script(Linux_Input_Script *script, u32 frame_idx, Event_Queue *event_queue)
+{
+    while (script->next_event_idx < script->event_count &&
+           script->events[script->next_event_idx].frame_idx <= frame_idx)
+    {
+        if (event_queue->next_idx < array_count(event_queue->events))
+        {
+            event_queue->events[event_queue->next_idx++] = script->events[script->next_event_idx].event;
+        }
+        ++script->next_event_idx;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Game Memory Pages
+//
+
+global_var u64 g_linux_commit_page_size;
+
+// NOTE: the range is only reserved, PROT_NONE, and linux_commit_memory makes
+// pages of it usable. hugetlb comes out of the pages reserved in
+// /proc/sys/vm/nr_hugepages. The mapping is not MAP_NORESERVE, so that too
+// few of them fails here and falls back instead of SIGBUSing later.
+// Transparent huge pages are only a hint, the kernel backs what it can. Both
+// need base and size 2MB aligned.
+internal Linux_Page_Backing
+linux_map_game_memory(void *base_address, u64 size, Linux_Page_Backing backing, void **memory)
+{
+    *memory = MAP_FAILED;
+    if (backing == eLinux_Pages_Huge_TLB)
+    {
+        *memory = mmap(base_address, (size_t)size, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (*memory == MAP_FAILED)
+        {
+            backing = eLinux_Pages_Transparent_Huge;
+        }
+    }
+
+    if (*memory == MAP_FAILED)
+    {
+        *memory = mmap(base_address, (size_t)size, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (backing == eLinux_Pages_Transparent_Huge &&
+            (*memory == MAP_FAILED || madvise(*memory, (size_t)size, MADV_HUGEPAGE) != 0))
+        {
+            backing = eLinux_Pages_Default;
+        }
+    }
+
+    // NOTE: with huge pages, commit whole ones. A 2MB page only comes out of
+    // a fault if all of it is already read-write.
+    g_linux_commit_page_size = ((backing == eLinux_Pages_Default) ?
+                                (u64)sysconf(_SC_PAGESIZE) : MB(2));
+
+    return backing;
+}
+
+// NOTE: while the snapshots write-protect game memory, all of it is readable
+// and the first write to a page is how they find out about it, so leave the
+// protection to them. Prefaulting would have to write, which is out then too.
+PLATFORM_COMMIT_MEMORY(linux_commit_memory)
+{
+    u64 page_mask = g_linux_commit_page_size - 1;
+    u8 *first = (u8 *)((u64)base & ~page_mask);
+    u8 *end = (u8 *)(((u64)base + size + page_mask) & ~page_mask);
+
+    Platform_Snapshots *snapshots = g_write_protected_snapshots;
+    if (!snapshots || !snapshots->armed)
+    {
+        mprotect(first, (size_t)(end - first), PROT_READ | PROT_WRITE);
+        if (prefault &&
+            madvise(first, (size_t)(end - first), MADV_POPULATE_WRITE) != 0)
+        {
+            // NOTE: kernels before 5.14 don't have MADV_POPULATE_WRITE.
+            for (u8 volatile *at = first;
+                 at < end;
+                 at += g_linux_commit_page_size)
+            {
+                *at = *at;
+            }
+        }
+    }
+}
+
+// in MB, from /proc/self/smaps_rollup. Both kinds.
+internal f64
+linux_get_huge_page_mb()
+{
+    f64 result = 0.0;
+    FILE *file = fopen("/proc/self/smaps_rollup", "r");
+    if (file)
+    {
+        char line[256];
+        while (fgets(line, sizeof(line), file))
+        {
+            unsigned long long kb;
+            if (sscanf(line, "AnonHugePages: %llu kB", &kb) == 1 ||
+                sscanf(line, "Private_Hugetlb: %llu kB", &kb) == 1)
+            {
+                result += (f64)kb / 1024.0;
+            }
+        }
+        fclose(file);
+    }
+    return result;
+}
+
+//
+// dTLB counters
+//
+// NOTE: opened before any thread is started, with inherit, so every thread
+// counts. User space only, which perf_event_paranoid 2 still allows. VMs
+// often have no hardware counters at all; then they stay at -1.
+//
+inline int
+linux_open_dtlb_counter(u64 result)
+{
+    perf_event_attr attr = {};
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HW_CACHE;
+    attr.config         = (PERF_COUNT_HW_CACHE_DTLB |
+                           (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                           (result << 16));
+    attr.disabled       = 1;
+    attr.inherit        = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    return fd;
+}
+
+internal void
+linux_open_dtlb_counters(Linux_DTLB_Counters *counters)
+{
+    counters->access_fd = linux_open_dtlb_counter(PERF_COUNT_HW_CACHE_RESULT_ACCESS);
+    counters->miss_fd   = linux_open_dtlb_counter(PERF_COUNT_HW_CACHE_RESULT_MISS);
+}
+
+internal void
+linux_enable_dtlb_counters(Linux_DTLB_Counters *counters, b32 enable)
+{
+    unsigned long request = enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE;
+    if (counters->access_fd != -1) ioctl(counters->access_fd, request, 0);
+    if (counters->miss_fd != -1)   ioctl(counters->miss_fd, request, 0);
+}
+
+internal void
+linux_report_dtlb_counters(Linux_DTLB_Counters *counters)
+{
+    u64 access_count = 0;
+    u64 miss_count = 0;
+    if (counters->access_fd != -1 && counters->miss_fd != -1 &&
+        read(counters->access_fd, &access_count, sizeof(access_count)) == sizeof(access_count) &&
+        read(counters->miss_fd, &miss_count, sizeof(miss_count)) == sizeof(miss_count) &&
+        access_count)
+    {
+        printf("dTLB load misses: %.3f%% (%llu of %llu loads, frames 1 and on)\n",
+               100.0 * (f64)miss_count / (f64)access_count,
+               (unsigned long long)miss_count, (unsigned long long)access_count);
+    }
+    else
+    {
+        printf("dTLB load misses: no hardware counters\n");
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Frame Statistics
+//
+
+internal int
+linux_compare_f64(const void *a, const void *b)
+{
+    f64 x = *(f64 *)a;
+    f64 y = *(f64 *)b;
+    int result = (x < y) ? -1 : ((x > y) ? 1 : 0);
+    return result;
+}
+
+inline f64
+linux_percentile(f64 *sorted, u32 count, f64 p)
+{
+    u32 idx = (u32)(p * (f64)(count - 1) + 0.5);
+    f64 result = sorted[idx];
+    return result;
+}
+
+internal void
+linux_report_frame_times(f64 *frame_ms, u32 frame_count)
+{
+    // NOTE: frame 0 does all the initialization and asset loading, so it is
+    // reported on its own and kept out of the steady-state percentiles.
+    printf("frame 0 (init): %.3fms\n", frame_ms[0]);
+
+    u32 count = frame_count - 1;
+    if (count)
+    {
+        f64 *sorted = frame_ms + 1;
+        f64 total = 0.0;
+        for (u32 idx = 0; idx < count; ++idx)
+        {
+            total += sorted[idx];
+        }
+        qsort(sorted, count, sizeof(f64), linux_compare_f64);
+
+        printf("frames: %u\n", count);
+        printf("mean:   %.3fms\n", total / (f64)count);
+        printf("min:    %.3fms\n", sorted[0]);
+        printf("p50:    %.3fms\n", linux_percentile(sorted, count, 0.50));
+        printf("p95:    %.3fms\n", linux_percentile(sorted, count, 0.95));
+        printf("p99:    %.3fms\n", linux_percentile(sorted, count, 0.99));
+        printf("max:    %.3fms\n", sorted[count - 1]);
+    }
+}
+
+struct Linux_Arena_Totals
+{
+    u64 used;
+    u64 committed;
+    u64 size;
+    u64 high_water;
+    u32 block_count;
+};
+
+// NOTE: arrays of arenas are summed up, count is how many. A growable
+// arena's counts are over all of its blocks, the ones it keeps for later too.
+internal Linux_Arena_Totals
+linux_sum_arenas(Memory_Arena *arenas, u32 count)
+{
+    Linux_Arena_Totals result = {};
+    for (u32 idx = 0;
+         idx < count;
+         ++idx)
+    {
+        Memory_Arena *arena = arenas + idx;
+        result.used         += arena->chained_used + arena->used;
+        result.committed    += arena->chained_committed + arena->committed;
+        result.size         += arena->chained_size + arena->size;
+        result.high_water   += arena->high_water;
+        result.block_count  += arena->block_count;
+        for (Memory_Block *block = arena->first_free_block;
+             block;
+             block = block->next_free)
+        {
+            result.committed    += block->committed;
+            result.size         += block->size;
+            ++result.block_count;
+        }
+    }
+    return result;
+}
+
+internal void
+linux_report_arena_totals(const char *name, Linux_Arena_Totals totals)
+{
+    printf("  %-16s %8.2fMB %8.2fMB %8.2fMB %8.2fMB %7u\n", name,
+           (f64)totals.used / (f64)MB(1), (f64)totals.committed / (f64)MB(1),
+           (f64)totals.size / (f64)MB(1), (f64)totals.high_water / (f64)MB(1),
+           totals.block_count);
+}
+
+internal void
+linux_report_arenas(const char *name, Memory_Arena *arenas, u32 count)
+{
+    linux_report_arena_totals(name, linux_sum_arenas(arenas, count));
+}
+
+internal void
+linux_report_pool(const char *name, Pool *pool)
+{
+    Pool_Stats stats = get_pool_stats(pool);
+    printf("  %-16s %6u live %6u high water %6u slots, %4u of %4u slabs in use, %4u if packed, %llu freed\n",
+           name, stats.live_count, stats.high_water, stats.capacity, stats.used_slab_count,
+           stats.slab_count, stats.packed_slab_count, (unsigned long long)stats.free_count);
+}
+
+internal void
+linux_report_entities(Entity_Store *store)
+{
+    printf("  %-16s %6u live %6u movers %6u slots %6u capacity, %llu pushed, %llu despawned\n",
+           "entities", store->count, store->mover_count, store->slot_count, store->capacity,
+           (unsigned long long)store->push_count, (unsigned long long)store->despawn_count);
+}
+
+// used vs committed, per arena, and the most each ever used.
+internal void
+linux_report_game_memory(Game_State *game_state, Transient_State *transient_state)
+{
+    printf("arenas:                used    committed     size  high water  blocks\n");
+    linux_report_arenas("world", &game_state->world_arena, 1);
+    if (game_state->world)
+    {
+        linux_report_entities(&game_state->world->entities);
+        linux_report_pool("chunks", &game_state->world->chunk_pool.pool);
+    }
+    if (transient_state->init)
+    {
+        Parallel_Context *parallel = &transient_state->parallel;
+        linux_report_arenas("transient", &transient_state->transient_arena, 1);
+        linux_report_arenas("thread scratch", parallel->thread_scratch->arenas,
+                            parallel->thread_count * THREAD_SCRATCH_COUNT);
+        linux_report_arenas("render", transient_state->render_arenas,
+                            array_count(transient_state->render_arenas));
+        linux_report_arenas("asset", &transient_state->asset_arena, 1);
+        Asset_Cache *cache = &transient_state->game_assets.cache;
+        Linux_Arena_Totals cache_totals = {};
+        for (u32 slot_idx = 0;
+             slot_idx < eCached_Asset_Count;
+             ++slot_idx)
+        {
+            Linux_Arena_Totals slot_totals = linux_sum_arenas(&cache->slots[slot_idx].arena, 1);
+            cache_totals.used           += slot_totals.used;
+            cache_totals.committed      += slot_totals.committed;
+            cache_totals.size           += slot_totals.size;
+            cache_totals.high_water     += slot_totals.high_water;
+            cache_totals.block_count    += slot_totals.block_count;
+        }
+        // NOTE: and the blocks evicted slots gave back.
+        for (Memory_Block *block = cache->first_free_block;
+             block;
+             block = block->next_free)
+        {
+            cache_totals.committed  += block->committed;
+            cache_totals.size       += block->size;
+            ++cache_totals.block_count;
+        }
+        linux_report_arena_totals("asset cache", cache_totals);
+        printf("  asset cache: %.2fMB of %.2fMB budget, %llu hits, %llu misses, %llu evictions, %llu failed loads\n",
+               (f64)cache->used / (f64)MB(1), (f64)cache->budget / (f64)MB(1),
+               (unsigned long long)cache->hit_count, (unsigned long long)cache->miss_count,
+               (unsigned long long)cache->eviction_count, (unsigned long long)cache->failed_load_count);
+
+        Memory_Block_Source *source = &transient_state->block_source;
+        printf("  blocks handed out: %.2fMB of %.2fMB\n",
+               (f64)source->used / (f64)MB(1), (f64)source->size / (f64)MB(1));
+    }
+}
+
+internal void
+linux_parse_args(Linux_Headless_Config *config, int argc, char **argv)
+{
+    for (int idx = 1;
+         idx + 1 < argc;
+         idx += 2)
+    {
+        char *option = argv[idx];
+        char *value = argv[idx + 1];
+        if      (strcmp(option, "--frames") == 0)   config->frame_count = (u32)atoi(value);
+        else if (strcmp(option, "--dt") == 0)       config->dt = (f32)atof(value);
+        else if (strcmp(option, "--width") == 0)    config->width = (u32)atoi(value);
+        else if (strcmp(option, "--height") == 0)   config->height = (u32)atoi(value);
+        else if (strcmp(option, "--script") == 0)   config->script_file_name = value;
+        else if (strcmp(option, "--frames-in-flight") == 0) config->frames_in_flight = (u32)atoi(value);
+        else if (strcmp(option, "--render-ms") == 0)        config->render_ms = (f32)atof(value);
+        else if (strcmp(option, "--io") == 0)               config->use_io_uring = (strcmp(value, "pread") != 0);
+        else if (strcmp(option, "--loop-start") == 0)       config->loop_start_frame = (u32)atoi(value);
+        else if (strcmp(option, "--loop-frames") == 0)      config->loop_frame_count = (u32)atoi(value);
+        else if (strcmp(option, "--huge-pages") == 0)
+        {
+            config->page_backing = ((strcmp(value, "hugetlb") == 0) ? eLinux_Pages_Huge_TLB :
+                                    (strcmp(value, "thp") == 0) ? eLinux_Pages_Transparent_Huge :
+                                    eLinux_Pages_Default);
+        }
+        else fprintf(stderr, "unknown option %s\n", option);
+    }
+}
+
+// NOTE: nothing may write to game memory while it is saved or restored,
+// including the render thread reading a batch out of the transient arena.
+internal void
+linux_wait_for_game_memory(Platform_Work_Queue *high_priority_queue, Platform_Work_Queue *low_priority_queue,
+                           Platform_Job_System *job_system, Platform_Frame_Pipeline *frame_pipeline)
+{
+    work_queue_complete_all_work(high_priority_queue);
+    work_queue_complete_all_work(low_priority_queue);
+    job_system_complete_all_jobs(job_system);
+    frame_pipeline_flush(frame_pipeline);
+}
+
+#if __DEVELOPER
+global_var Debug_Table g_debug_table_;
+Debug_Table *g_debug_table = &g_debug_table_;
+#endif
+
+int
+main(int argc, char **argv)
+{
+    Linux_Headless_Config config = {};
+    config.frame_count  = 1000;
+    config.dt           = 1.0f / 60.0f;
+    config.width        = 1920;
+    config.height       = 1080;
+    config.frames_in_flight = RENDER_DEFAULT_FRAMES_IN_FLIGHT;
+    config.use_io_uring     = true;
+    linux_parse_args(&config, argc, argv);
+    if (config.frame_count < 1)
+    {
+        config.frame_count = 1;
+    }
+    if (config.loop_frame_count && config.loop_start_frame < 1)
+    {
+        // NOTE: frame 0 loads everything, a loop can't start before it.
+        config.loop_start_frame = 1;
+    }
+
+    Linux_DTLB_Counters dtlb_counters = {};
+    linux_open_dtlb_counters(&dtlb_counters);
+    // NOTE: for the faults taken after frame 0, the init one.
+    struct rusage init_usage = {};
+
+    //
+    // Multi-Threading
+    //
+    Platform_Core_Topology topology = linux_get_core_topology();
+
+    // leave a physical core to this thread.
+    u32 high_priority_thread_count = (topology.physical_core_count > 1) ? topology.physical_core_count - 1 : 1;
+
+    Platform_Work_Queue high_priority_queue = {};
+    linux_make_queue(&high_priority_queue, high_priority_thread_count);
+
+    Platform_Work_Queue low_priority_queue = {};
+    linux_make_queue(&low_priority_queue, 2);
+
+    // one job thread per logical core, this one included.
+    Platform_Job_System *job_system = linux_make_job_system(topology.logical_core_count);
+
+    Linux_File_IO_Backend io_backend = linux_init_file_io(job_system, config.use_io_uring);
+
+    // @TEMPORARY
+    void *base_address = (void *)TB(2);
+    Game_Memory game_memory = {};
+    Linux_State linux_state = {};
+    game_memory.permanent_memory_size   = MB(256);
+    game_memory.transient_memory_size   = GB(1);
+    game_memory.debug_storage_size      = MB(64);
+
+    u64 total_capacity = (game_memory.permanent_memory_size +
+                          game_memory.transient_memory_size +
+                          game_memory.debug_storage_size);
+
+    Linux_Page_Backing page_backing = linux_map_game_memory(base_address, total_capacity, config.page_backing,
+                                                            &linux_state.game_memory);
+    if (linux_state.game_memory == MAP_FAILED)
+    {
+        fprintf(stderr, "couldn't map game memory\n");
+        return 1;
+    }
+
+    // NOTE: fiber stacks go right after, outside of what counts as game
+    // memory, so that nothing that snapshots it rewrites a live stack. Always
+    // small pages, a guard-less 256KB stack has no use for 2MB ones.
+    u32 fiber_count = 64;
+    u64 fiber_stack_size = KB(256);
+    u64 fiber_stack_capacity = fiber_count * fiber_stack_size;
+    void *fiber_stacks = mmap((u8 *)linux_state.game_memory + total_capacity, (size_t)fiber_stack_capacity,
+                              PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (fiber_stacks == MAP_FAILED)
+    {
+        fprintf(stderr, "couldn't map fiber stacks\n");
+        return 1;
+    }
+    linux_state.game_mem_total_cap = total_capacity;
+    game_memory.permanent_memory = linux_state.game_memory;
+    game_memory.transient_memory = ((u8 *)(game_memory.permanent_memory) + game_memory.permanent_memory_size);
+    game_memory.debug_storage = ((u8 *)(game_memory.transient_memory) + game_memory.transient_memory_size);
+    linux_commit_memory(game_memory.permanent_memory, sizeof(Game_State), false);
+    linux_commit_memory(game_memory.transient_memory, sizeof(Transient_State), false);
+    linux_commit_memory(game_memory.debug_storage, game_memory.debug_storage_size, false);
+
+    job_system_init_fibers(job_system, fiber_stacks, fiber_stack_size, fiber_count);
+
+    game_memory.high_priority_queue = &high_priority_queue;
+    game_memory.low_priority_queue = &low_priority_queue;
+    game_memory.platform.platform_add_entry = work_queue_add_entry;
+    game_memory.platform.platform_complete_all_work = work_queue_complete_all_work;
+    game_memory.platform.platform_add_job = job_system_add_job;
+    game_memory.platform.platform_add_fiber_job = job_system_add_fiber_job;
+    game_memory.platform.platform_wait_for_counter = job_system_wait_for_counter;
+    game_memory.platform.platform_get_job_thread_index = job_system_get_thread_index;
+    game_memory.job_thread_count = job_system->worker_count;
+    game_memory.platform.platform_open_file = linux_open_file;
+    game_memory.platform.platform_read_file = linux_read_file;
+    game_memory.platform.platform_close_file = linux_close_file;
+    game_memory.platform.platform_map_file = linux_map_file;
+    game_memory.platform.platform_unmap_file = linux_unmap_file;
+    game_memory.platform.platform_commit_memory = linux_commit_memory;
+    game_memory.platform.debug_platform_read_file = linux_read_entire_file;
+
+#if __DEVELOPER
+    game_memory.platform.debug_platform_write_file = linux_write_entire_file;
+    game_memory.platform.debug_platform_free_memory = linux_free_memory;
+    game_memory.platform.debug_platform_execute_system_command = linux_execute_system_command;
+    game_memory.platform.debug_platform_get_process_state = linux_get_process_state;
+#endif
+
+    //
+    // Render Thread
+    //
+    Platform_Frame_Pipeline frame_pipeline = {};
+    Linux_Null_Renderer renderer = {};
+    renderer.render_ms = config.render_ms;
+    frame_pipeline_init(&frame_pipeline, config.frames_in_flight, linux_render_batch, &renderer);
+    for (u32 idx = 0;
+         idx < frame_pipeline.frames_in_flight;
+         ++idx)
+    {
+        linux_init_render_batch(frame_pipeline.batches + idx, RENDER_BATCH_SIZE);
+    }
+    pthread_t render_thread;
+    pthread_create(&render_thread, 0, linux_render_thread_proc, &frame_pipeline);
+    pthread_detach(render_thread);
+
+    Game_State *game_state = (Game_State *)game_memory.permanent_memory;
+
+    Game_Screen_Buffer game_screen_buffer = {};
+    game_screen_buffer.width = config.width;
+    game_screen_buffer.height = config.height;
+    game_screen_buffer.bpp = 4;
+    game_screen_buffer.pitch = game_screen_buffer.bpp * game_screen_buffer.width;
+
+    //
+    // game.so lives next to the executable.
+    //
+    char exe_path_buf[4096];
+    ssize_t exe_path_length = readlink("/proc/self/exe", exe_path_buf, sizeof(exe_path_buf) - 1);
+    if (exe_path_length < 0)
+    {
+        exe_path_length = 0;
+    }
+    exe_path_buf[exe_path_length] = 0;
+    char *last_slash = strrchr(exe_path_buf, '/');
+    if (last_slash)
+    {
+        last_slash[1] = 0;
+    }
+    char game_so_abs_path[4096];
+    char game_so_load_abs_path[4096];
+    u32 game_load_count = 0;
+    if (snprintf(game_so_abs_path, sizeof(game_so_abs_path), "%sgame.so", exe_path_buf) >= (int)sizeof(game_so_abs_path) ||
+        snprintf(game_so_load_abs_path, sizeof(game_so_load_abs_path), "%sgame_load_%u.so",
+                 exe_path_buf, game_load_count++) >= (int)sizeof(game_so_load_abs_path))
+    {
+        fprintf(stderr, "path to game.so is too long\n");
+        return 1;
+    }
+
+    Linux_Game game = {};
+    linux_load_game(&game, game_so_abs_path, game_so_load_abs_path);
+    if (!game.is_valid)
+    {
+        fprintf(stderr, "couldn't load %s\n", game_so_abs_path);
+        return 1;
+    }
+    job_system_set_game_module(job_system, game.module_base, game.module_size);
+    game_memory.executable_reloaded = true;
+
+    Linux_Game_Watch game_watch = {};
+    linux_watch_game(&game_watch, game_so_abs_path);
+    Linux_Reload_Stats reload_stats = {};
+
+    Linux_Input_Script *script = (Linux_Input_Script *)calloc(1, sizeof(Linux_Input_Script));
+    if (config.script_file_name)
+    {
+        if (!linux_load_script(script, config.script_file_name))
+        {
+            fprintf(stderr, "couldn't open script %s\n", config.script_file_name);
+            return 1;
+        }
+    }
+    else
+    {
+        linux_default_script(script, config.frame_count);
+    }
+
+    f64 *frame_ms = (f64 *)calloc(config.frame_count, sizeof(f64));
+    f64 render_wait_ms = 0.0;
+
+    Game_Input input = {};
+    input.dt = config.dt;
+    Event_Queue event_queue = {};
+
+    // NOTE: debug storage is left out, the profiler keeps its history.
+    Platform_Snapshots *snapshots = 0;
+    Linux_Loop_Frame *loop_frames = 0;
+    Linux_Loop_Stats loop_stats = {};
+    if (config.loop_frame_count)
+    {
+        snapshots = (Platform_Snapshots *)calloc(1, sizeof(Platform_Snapshots));
+        // NOTE: hugetlb pages can only be protected whole.
+        u64 page_size = (page_backing == eLinux_Pages_Huge_TLB) ? MB(2) : (u64)sysconf(_SC_PAGESIZE);
+        snapshots_init(snapshots, game_memory.permanent_memory,
+                       game_memory.permanent_memory_size + game_memory.transient_memory_size,
+                       page_size);
+        loop_frames = (Linux_Loop_Frame *)calloc(config.loop_frame_count, sizeof(Linux_Loop_Frame));
+    }
+
+    //
+    // Loop
+    //
+    for (u32 frame_idx = 0;
+         frame_idx < config.frame_count;
+         ++frame_idx)
+    {
+        u64 last_counter = linux_get_wall_clock();
+
+        BEGIN_BLOCK(linux_executable_ready);
+        if (linux_game_changed(&game_watch))
+        {
+            BEGIN_BLOCK(linux_game_reload);
+            u64 reload_counter = linux_get_wall_clock();
+
+            // NOTE: frames in flight may point into the old module, and the
+            // work queues only ever carry game callbacks. Of the jobs, only
+            // the ones running game code have to finish; platform work like
+            // file reads carries on through the reload.
+            BEGIN_BLOCK(linux_game_reload_quiesce);
+            frame_pipeline_flush(&frame_pipeline);
+            work_queue_complete_all_work(&high_priority_queue);
+            work_queue_complete_all_work(&low_priority_queue);
+            job_system_complete_game_module_jobs(job_system);
+            END_BLOCK(linux_game_reload_quiesce);
+            u64 quiesced_counter = linux_get_wall_clock();
+
+#if __DEVELOPER
+            g_debug_table = &g_debug_table_;
+#endif
+
+            // NOTE: a broken build keeps the old module running.
+            Linux_Game new_game = {};
+            if (snprintf(game_so_load_abs_path, sizeof(game_so_load_abs_path), "%sgame_load_%u.so",
+                         exe_path_buf, game_load_count++) < (int)sizeof(game_so_load_abs_path))
+            {
+                linux_load_game(&new_game, game_so_abs_path, game_so_load_abs_path);
+            }
+            if (new_game.is_valid)
+            {
+                Assert(new_game.so != game.so);
+                linux_unload_game(&game);
+                game = new_game;
+                job_system_set_game_module(job_system, game.module_base, game.module_size);
+                game_memory.executable_reloaded = true;
+            }
+            else
+            {
+                linux_unload_game(&new_game);
+            }
+
+            f64 reload_ms = linux_get_elapsed_ms(reload_counter, linux_get_wall_clock());
+            ++reload_stats.reload_count;
+            reload_stats.quiesce_ms += linux_get_elapsed_ms(reload_counter, quiesced_counter);
+            reload_stats.total_ms   += reload_ms;
+            reload_stats.max_ms      = maximum(reload_stats.max_ms, reload_ms);
+            END_BLOCK(linux_game_reload);
+        }
+        END_BLOCK(linux_executable_ready);
+
+        BEGIN_BLOCK(linux_process_input);
+        linux_feed_script(script, frame_idx, &event_queue);
+        END_BLOCK(linux_process_input);
+
+        if (config.loop_frame_count && frame_idx >= config.loop_start_frame)
+        {
+            BEGIN_BLOCK(linux_loop_input);
+            u32 loop_frame_idx = (frame_idx - config.loop_start_frame) % config.loop_frame_count;
+            b32 recording = (frame_idx - config.loop_start_frame) < config.loop_frame_count;
+            if (loop_frame_idx == 0)
+            {
+                linux_wait_for_game_memory(&high_priority_queue, &low_priority_queue, job_system, &frame_pipeline);
+                u64 snapshot_counter = linux_get_wall_clock();
+                if (recording)
+                {
+                    snapshot_save(snapshots, 0);
+                    loop_stats.save_ms = linux_get_elapsed_ms(snapshot_counter, linux_get_wall_clock());
+                    loop_stats.saved_hash = snapshot_hash_memory(snapshots);
+                }
+                else
+                {
+                    loop_stats.restored_page_count += snapshot_restore(snapshots, 0);
+                    loop_stats.restore_ms += linux_get_elapsed_ms(snapshot_counter, linux_get_wall_clock());
+                    ++loop_stats.restore_count;
+                    if (snapshot_hash_memory(snapshots) != loop_stats.saved_hash)
+                    {
+                        ++loop_stats.mismatch_count;
+                    }
+                }
+            }
+
+            Linux_Loop_Frame *loop_frame = loop_frames + loop_frame_idx;
+            if (recording)
+            {
+                loop_frame->input = input;
+                loop_frame->event_queue = event_queue;
+            }
+            else
+            {
+                input = loop_frame->input;
+                event_queue = loop_frame->event_queue;
+            }
+            END_BLOCK(linux_loop_input);
+        }
+
+        BEGIN_BLOCK(linux_render_wait);
+        u64 wait_counter = linux_get_wall_clock();
+        u32 render_slot = frame_pipeline_begin_frame(&frame_pipeline);
+        game_memory.render_batch = frame_pipeline.batches + render_slot;
+        game_memory.render_slot = render_slot;
+        if (frame_idx)
+        {
+            render_wait_ms += linux_get_elapsed_ms(wait_counter, linux_get_wall_clock());
+        }
+        END_BLOCK(linux_render_wait);
+
+        BEGIN_BLOCK(linux_game_update);
+        game.game_update(&game_memory, game_state, &input, &event_queue, &game_screen_buffer);
+        END_BLOCK(linux_game_update);
+        game_memory.executable_reloaded = false;
+
+#if __DEVELOPER
+        BEGIN_BLOCK(linux_debug_collation);
+        if (game.debug_frame_end)
+        {
+            g_debug_table = game.debug_frame_end(&game_memory, &game_screen_buffer, &input);
+        }
+        g_debug_table_.event_array_idx_event_idx = 0;
+        END_BLOCK(linux_debug_collation);
+#endif
+
+        game_memory.render_batch->width = config.width;
+        game_memory.render_batch->height = config.height;
+        frame_pipeline_submit(&frame_pipeline);
+
+        u64 end_counter = linux_get_wall_clock();
+        frame_ms[frame_idx] = linux_get_elapsed_ms(last_counter, end_counter);
+        FRAME_MARKER(linux_get_seconds_elapsed(last_counter, end_counter));
+
+        if (frame_idx == 0)
+        {
+            // NOTE: the steady state only, like the frame times.
+            linux_enable_dtlb_counters(&dtlb_counters, true);
+            getrusage(RUSAGE_SELF, &init_usage);
+        }
+    }
+
+    work_queue_complete_all_work(&high_priority_queue);
+    work_queue_complete_all_work(&low_priority_queue);
+    job_system_complete_all_jobs(job_system);
+    frame_pipeline_flush(&frame_pipeline);
+    linux_enable_dtlb_counters(&dtlb_counters, false);
+
+    printf("file reads: %s\n", (io_backend == eLinux_File_IO_Io_Uring) ? "io_uring" : "pread threads");
+    const char *page_backing_names[] = { "4KB", "transparent huge pages", "hugetlb 2MB" };
+    printf("game memory pages: %s, %.1fMB in huge pages\n", page_backing_names[page_backing],
+           linux_get_huge_page_mb());
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("peak rss: %.1fMB, %ld minor faults, %ld after frame 0\n", (f64)usage.ru_maxrss / 1024.0,
+           usage.ru_minflt, usage.ru_minflt - init_usage.ru_minflt);
+    linux_report_game_memory(game_state, (Transient_State *)game_memory.transient_memory);
+    linux_report_dtlb_counters(&dtlb_counters);
+    linux_report_frame_times(frame_ms, config.frame_count);
+    if (reload_stats.reload_count)
+    {
+        printf("game.so reloads: %u, %.3fms on average (%.3fms waiting for frames and game jobs), %.3fms max\n",
+               reload_stats.reload_count, reload_stats.total_ms / (f64)reload_stats.reload_count,
+               reload_stats.quiesce_ms / (f64)reload_stats.reload_count, reload_stats.max_ms);
+    }
+    if (snapshots && snapshots->slots[0].valid)
+    {
+        const char *tracking_names[] = { "write watch", "soft-dirty", "write protection" };
+        printf("loop snapshot: %.1fMB of %.1fMB, saved in %.3fms, %s\n",
+               (f64)snapshot_get_size(snapshots, 0) / (f64)MB(1), (f64)snapshots->size / (f64)MB(1),
+               loop_stats.save_ms, tracking_names[snapshots->tracking]);
+        if (loop_stats.restore_count)
+        {
+            printf("loop restore: %.3fms, %u pages on average over %u restores, %u not matching the snapshot\n",
+                   loop_stats.restore_ms / (f64)loop_stats.restore_count,
+                   (u32)(loop_stats.restored_page_count / loop_stats.restore_count),
+                   loop_stats.restore_count, loop_stats.mismatch_count);
+        }
+    }
+    if (config.frame_count > 1)
+    {
+        printf("frames in flight: %u, waiting on the renderer %.3fms/frame, %llu pieces rendered\n",
+               frame_pipeline.frames_in_flight, render_wait_ms / (f64)(config.frame_count - 1),
+               (unsigned long long)renderer.piece_count);
+    }
+
+    return 0;
+}
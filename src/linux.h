@@ -0,0 +1,109 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+
+struct Linux_State
+{
+    void        *game_memory;
+    u64         game_mem_total_cap;
+};
+
+struct Linux_Game
+{
+    void                *so;
+
+    Game_Update         *game_update;
+    Debug_Frame_End     *debug_frame_end;
+
+    b32                 is_valid;
+
+    u64                 link_map_addr;
+    u8                  *module_base;
+    u64                 module_size;
+};
+
+struct Linux_Game_Watch
+{
+    int                 fd;
+    const char          *file_name;
+};
+
+struct Linux_Reload_Stats
+{
+    u32                 reload_count;
+    f64                 quiesce_ms;
+    f64                 total_ms;
+    f64                 max_ms;
+};
+
+struct Linux_Script_Event
+{
+    u32     frame_idx;
+    Event   event;
+};
+
+// NOTE: Input script for the headless run. One "<frame> <key> <down|up>" per line.
+struct Linux_Input_Script
+{
+    Linux_Script_Event  events[1024];
+    u32                 event_count;
+    u32                 next_event_idx;
+};
+
+enum Linux_Page_Backing
+{
+    eLinux_Pages_Default,
+    eLinux_Pages_Transparent_Huge,
+    eLinux_Pages_Huge_TLB,
+};
+
+struct Linux_Headless_Config
+{
+    u32         frame_count;
+    f32         dt;
+    u32         width;
+    u32         height;
+    const char  *script_file_name;
+    u32         frames_in_flight;
+    f32         render_ms;
+    b32         use_io_uring;
+    u32         loop_start_frame;
+    u32         loop_frame_count;
+    Linux_Page_Backing page_backing;
+};
+
+struct Linux_DTLB_Counters
+{
+    int         access_fd;
+    int         miss_fd;
+};
+
+struct Linux_Loop_Frame
+{
+    Game_Input  input;
+    Event_Queue event_queue;
+};
+
+struct Linux_Loop_Stats
+{
+    f64         save_ms;
+    u64         saved_hash;
+
+    f64         restore_ms;
+    u64         restored_page_count;
+    u32         restore_count;
+    u32         mismatch_count;
+};
+
+// NOTE: stands in for GL. Walks every batch it gets, and spins for
+// render_ms to play the part of the driver's submission cost.
+struct Linux_Null_Renderer
+{
+    f32         render_ms;
+    u64         group_count;
+    u64         piece_count;
+};
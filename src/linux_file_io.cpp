@@ -0,0 +1,420 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+
+/*
+ * Asynchronous file reads for the Linux platform, behind platform_read_file.
+ *
+ * Reads go to io_uring when the kernel lets us have one: any thread puts an
+ * entry on the submission ring, and a completion thread reaps them and takes
+ * them off their counters. Without io_uring (old kernel, seccomp), a few
+ * threads on a work queue pread instead. Either way short reads are carried
+ * on from where they stopped, so a read can be of any size.
+ *
+ * At most LINUX_FILE_READ_MAX reads are in flight. Past that, issuing one
+ * waits for a slot.
+ *
+ * platform_map_file is the other way in, for loaders that parse in place.
+ */
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#define LINUX_FILE_READ_MAX         256
+#define LINUX_FILE_PREAD_THREADS    4
+// NOTE: bigger reads are issued in pieces of this.
+#define LINUX_FILE_READ_CHUNK       GB(1)
+
+struct Linux_File_Read
+{
+    int                     fd;
+    u64                     offset;
+    u64                     size;
+    u8                      *dest;
+    iovec                   iov;
+
+    Platform_File_Handle    *file;
+    Platform_Job_Counter    *counter;
+
+    Linux_File_Read         *next_free;
+};
+
+enum Linux_File_IO_Backend
+{
+    eLinux_File_IO_Pread,
+    eLinux_File_IO_Io_Uring,
+};
+
+struct Linux_Io_Uring
+{
+    int             fd;
+
+    u32             *sq_tail;
+    u32             *sq_mask;
+    u32             *sq_array;
+    io_uring_sqe    *sqes;
+
+    u32             *cq_head;
+    u32             *cq_tail;
+    u32             *cq_mask;
+    io_uring_cqe    *cqes;
+};
+
+struct Linux_File_IO
+{
+    Linux_File_IO_Backend   backend;
+    Platform_Job_System     *job_system;
+
+    // NOTE: guards the free list and the submission ring.
+    pthread_mutex_t         lock;
+    Platform_Semaphore      free_semaphore;
+    Linux_File_Read         *first_free;
+    Linux_File_Read         reads[LINUX_FILE_READ_MAX];
+
+    Linux_Io_Uring          ring;
+    Platform_Work_Queue     pread_queue;
+};
+
+global_var Linux_File_IO *g_linux_file_io;
+
+// NOTE: platform is the fd, or -1 if the open failed.
+PLATFORM_OPEN_FILE(linux_open_file)
+{
+    Platform_File_Handle result = {};
+    result.platform = (u64)-1;
+
+    int fd = open(file_name, O_RDONLY);
+    if (fd != -1)
+    {
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == 0)
+        {
+            result.no_errors    = true;
+            result.size         = (u64)file_stat.st_size;
+            result.platform     = (u64)fd;
+        }
+        else
+        {
+            close(fd);
+        }
+    }
+
+    return result;
+}
+
+PLATFORM_CLOSE_FILE(linux_close_file)
+{
+    if (file->platform != (u64)-1)
+    {
+        close((int)file->platform);
+    }
+    *file = {};
+    file->platform = (u64)-1;
+}
+
+PLATFORM_MAP_FILE(linux_map_file)
+{
+    Entire_File result = {};
+
+    int fd = open(file_name, O_RDONLY);
+    if (fd != -1)
+    {
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+        {
+            Assert((u64)file_stat.st_size <= 0xffffffff);
+            void *memory = mmap(0, (size_t)file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (memory != MAP_FAILED)
+            {
+                // NOTE: it's about to be parsed front to back.
+                madvise(memory, (size_t)file_stat.st_size, MADV_WILLNEED);
+                result.contents     = memory;
+                result.content_size = (u32)file_stat.st_size;
+            }
+        }
+        // NOTE: the mapping holds on to the file by itself.
+        close(fd);
+    }
+
+    return result;
+}
+
+PLATFORM_UNMAP_FILE(linux_unmap_file)
+{
+    if (file->contents)
+    {
+        munmap(file->contents, file->content_size);
+    }
+    *file = {};
+}
+
+internal void
+linux_file_read_finish(Linux_File_IO *io, Linux_File_Read *read, b32 succeeded)
+{
+    Platform_Job_Counter *counter = read->counter;
+    if (!succeeded)
+    {
+        read->file->no_errors = false;
+    }
+
+    pthread_mutex_lock(&io->lock);
+    read->next_free = io->first_free;
+    io->first_free = read;
+    pthread_mutex_unlock(&io->lock);
+    platform_release_semaphore(&io->free_semaphore);
+
+    job_counter_done(io->job_system, counter);
+}
+
+//
+// io_uring
+//
+inline int
+linux_io_uring_enter(int fd, u32 to_submit, u32 min_complete, u32 flags)
+{
+    int result = (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, 0, 0);
+    return result;
+}
+
+// NOTE: the caller holds io->lock.
+internal void
+linux_io_uring_submit(Linux_File_IO *io, Linux_File_Read *read)
+{
+    Linux_Io_Uring *ring = &io->ring;
+
+    read->iov.iov_base  = read->dest;
+    read->iov.iov_len   = (size_t)minimum(read->size, LINUX_FILE_READ_CHUNK);
+
+    u32 tail = *ring->sq_tail;
+    u32 idx = tail & *ring->sq_mask;
+    io_uring_sqe *sqe = ring->sqes + idx;
+    *sqe = {};
+    sqe->opcode     = IORING_OP_READV;
+    sqe->fd         = read->fd;
+    sqe->off        = read->offset;
+    sqe->addr       = (u64)&read->iov;
+    sqe->len        = 1;
+    sqe->user_data  = (u64)read;
+    ring->sq_array[idx] = idx;
+    atomic_store_u32(ring->sq_tail, tail + 1, eMemory_Order_Release);
+
+    // NOTE: the kernel takes the entry during the call, so the ring never
+    // holds more than one.
+    while (linux_io_uring_enter(ring->fd, 1, 0, 0) < 0 && errno == EINTR)
+    {
+    }
+}
+
+internal void *
+linux_io_uring_completion_proc(void *parameter)
+{
+    Linux_File_IO *io = (Linux_File_IO *)parameter;
+    Linux_Io_Uring *ring = &io->ring;
+
+    for (;;)
+    {
+        linux_io_uring_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS);
+
+        u32 head = *ring->cq_head;
+        u32 tail = atomic_load_u32(ring->cq_tail, eMemory_Order_Acquire);
+        while (head != tail)
+        {
+            io_uring_cqe *cqe = ring->cqes + (head & *ring->cq_mask);
+            Linux_File_Read *read = (Linux_File_Read *)cqe->user_data;
+            s32 bytes_read = cqe->res;
+            ++head;
+            atomic_store_u32(ring->cq_head, head, eMemory_Order_Release);
+
+            if (bytes_read > 0 && (u64)bytes_read < read->size)
+            {
+                // short read, carry on from there.
+                read->offset    += bytes_read;
+                read->dest      += bytes_read;
+                read->size      -= bytes_read;
+                pthread_mutex_lock(&io->lock);
+                linux_io_uring_submit(io, read);
+                pthread_mutex_unlock(&io->lock);
+            }
+            else
+            {
+                // NOTE: 0 is end of file before we got what we asked for.
+                linux_file_read_finish(io, read, (bytes_read > 0));
+            }
+        }
+    }
+
+    return 0;
+}
+
+internal b32
+linux_io_uring_init(Linux_Io_Uring *ring, u32 entry_count)
+{
+    io_uring_params params = {};
+    int fd = (int)syscall(__NR_io_uring_setup, entry_count, &params);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    b32 single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP);
+    if (single_mmap)
+    {
+        sq_size = cq_size = maximum(sq_size, cq_size);
+    }
+
+    u8 *sq = (u8 *)mmap(0, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    u8 *cq = sq;
+    if (!single_mmap && sq != MAP_FAILED)
+    {
+        cq = (u8 *)mmap(0, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    }
+    void *sqes = mmap(0, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    ring->fd        = fd;
+    ring->sq_tail   = (u32 *)(sq + params.sq_off.tail);
+    ring->sq_mask   = (u32 *)(sq + params.sq_off.ring_mask);
+    ring->sq_array  = (u32 *)(sq + params.sq_off.array);
+    ring->sqes      = (io_uring_sqe *)sqes;
+    ring->cq_head   = (u32 *)(cq + params.cq_off.head);
+    ring->cq_tail   = (u32 *)(cq + params.cq_off.tail);
+    ring->cq_mask   = (u32 *)(cq + params.cq_off.ring_mask);
+    ring->cqes      = (io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    return true;
+}
+
+//
+// pread
+//
+PLATFORM_WORK_QUEUE_CALLBACK(linux_pread_work)
+{
+    Linux_File_Read *read = (Linux_File_Read *)data;
+
+    while (read->size)
+    {
+        ssize_t bytes_read = pread(read->fd, read->dest,
+                                   (size_t)minimum(read->size, LINUX_FILE_READ_CHUNK), (off_t)read->offset);
+        if (bytes_read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytes_read <= 0)
+        {
+            break;
+        }
+        read->offset    += bytes_read;
+        read->dest      += bytes_read;
+        read->size      -= bytes_read;
+    }
+
+    linux_file_read_finish(g_linux_file_io, read, (read->size == 0));
+}
+
+internal void *
+linux_pread_thread_proc(void *parameter)
+{
+    work_queue_thread_loop((Platform_Work_Queue *)parameter);
+    return 0;
+}
+
+//
+//
+//
+PLATFORM_READ_FILE(linux_read_file)
+{
+    Linux_File_IO *io = g_linux_file_io;
+    if (!file->no_errors)
+    {
+        return;
+    }
+    Assert(offset + size <= file->size);
+
+    job_counter_add(counter, 1);
+    if (!size)
+    {
+        job_counter_done(io->job_system, counter);
+        return;
+    }
+
+    platform_wait_semaphore(&io->free_semaphore);
+    pthread_mutex_lock(&io->lock);
+
+    Linux_File_Read *read = io->first_free;
+    io->first_free = read->next_free;
+
+    read->fd        = (int)file->platform;
+    read->offset    = offset;
+    read->size      = size;
+    read->dest      = (u8 *)dest;
+    read->file      = file;
+    read->counter   = counter;
+
+    if (io->backend == eLinux_File_IO_Io_Uring)
+    {
+        linux_io_uring_submit(io, read);
+        pthread_mutex_unlock(&io->lock);
+    }
+    else
+    {
+        pthread_mutex_unlock(&io->lock);
+        work_queue_add_entry(&io->pread_queue, linux_pread_work, read);
+    }
+}
+
+// NOTE: use_io_uring false goes straight to the pread threads.
+internal Linux_File_IO_Backend
+linux_init_file_io(Platform_Job_System *job_system, b32 use_io_uring)
+{
+    Linux_File_IO *io = (Linux_File_IO *)mmap(0, sizeof(Linux_File_IO), PROT_READ | PROT_WRITE,
+                                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    io->job_system = job_system;
+    pthread_mutex_init(&io->lock, 0);
+
+    platform_init_semaphore(&io->free_semaphore, LINUX_FILE_READ_MAX);
+    for (u32 idx = 0;
+         idx < LINUX_FILE_READ_MAX;
+         ++idx)
+    {
+        Linux_File_Read *read = io->reads + idx;
+        read->next_free = io->first_free;
+        io->first_free = read;
+        platform_release_semaphore(&io->free_semaphore);
+    }
+
+    pthread_t thread;
+    if (use_io_uring && linux_io_uring_init(&io->ring, LINUX_FILE_READ_MAX))
+    {
+        io->backend = eLinux_File_IO_Io_Uring;
+        pthread_create(&thread, 0, linux_io_uring_completion_proc, io);
+        pthread_detach(thread);
+    }
+    else
+    {
+        io->backend = eLinux_File_IO_Pread;
+        work_queue_init(&io->pread_queue, LINUX_FILE_PREAD_THREADS);
+        for (u32 thread_idx = 0;
+             thread_idx < LINUX_FILE_PREAD_THREADS;
+             ++thread_idx)
+        {
+            pthread_create(&thread, 0, linux_pread_thread_proc, &io->pread_queue);
+            pthread_detach(thread);
+        }
+    }
+
+    g_linux_file_io = io;
+    return io->backend;
+}
@@ -20,12 +20,14 @@ square(f32 val)
     return result;
 }
 
+#if __MSVC // NOTE: libstdc++ already drags abs(float) in through <stdlib.h>.
 inline f32
 abs(f32 val) 
 {
     f32 result = (val > 0) ? val : -val;
     return result;
 }
+#endif
 
 inline f32
 lerp(f32 a, f32 t, f32 b) 
@@ -6,47 +6,329 @@
    $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
    ======================================================================== */
 
+// NOTE: so a growing arena doesn't commit page by page.
+#define ARENA_COMMIT_GRANULARITY    KB(64)
+
+// NOTE: pushes are 16-byte aligned unless they ask for more, so anything can
+// be loaded and stored with aligned SSE. Arrays that get streamed through
+// every frame, or that threads write side by side, ask for a cache line.
+#define ARENA_DEFAULT_ALIGNMENT     16
+#define ARENA_CACHE_LINE            64
+#define ARENA_MAX_ALIGNMENT         4096
+
+// how far past used the next push with this alignment starts.
+inline size_t
+get_alignment_offset(Memory_Arena *arena, size_t alignment)
+{
+    Assert(alignment && (alignment & (alignment - 1)) == 0 && alignment <= ARENA_MAX_ALIGNMENT);
+    size_t at = (size_t)arena->base + arena->used;
+    size_t result = (alignment - (at & (alignment - 1))) & (alignment - 1);
+    return result;
+}
+
 inline b32
-arena_has_room_for(Memory_Arena *arena, size_t size)
+arena_block_has_room_for(Memory_Arena *arena, size_t size, size_t alignment)
 {
-    b32 result = ((arena->used + size) <= arena->size);
+    b32 result = ((arena->used + get_alignment_offset(arena, alignment) + size) <= arena->size);
+    return result;
+}
+
+// NOTE: a growable arena always has room.
+inline b32
+arena_has_room_for(Memory_Arena *arena, size_t size, size_t alignment = ARENA_DEFAULT_ALIGNMENT)
+{
+    b32 result = (arena->source || arena_block_has_room_for(arena, size, alignment));
+    return result;
+}
+
+// commits up to at least needed, in ARENA_COMMIT_GRANULARITY steps.
+internal void
+arena_commit(Memory_Arena *arena, size_t needed, b32 prefault)
+{
+    Assert(needed <= arena->size);
+    u64 end = ((u64)arena->base + needed + ARENA_COMMIT_GRANULARITY - 1) & ~((u64)ARENA_COMMIT_GRANULARITY - 1);
+    size_t committed = minimum((size_t)(end - (u64)arena->base), arena->size);
+    if (committed > arena->committed)
+    {
+        arena->commit((u8 *)arena->base + arena->committed, committed - arena->committed, prefault);
+        arena->committed = committed;
+    }
+}
+
+// committed, less what was handed to sub-arenas that may not have committed it.
+inline size_t
+get_arena_backed_committed(Memory_Arena *arena)
+{
+    size_t result = arena->committed;
+    if (arena->sub_arena_end)
+    {
+        result = minimum(result, arena->sub_arena_begin);
+    }
+    return result;
+}
+
+// NOTE: once used is back below it, the range handed to sub-arenas is the
+// arena's again, and pushes into it have to commit it.
+inline void
+arena_take_back_sub_arenas(Memory_Arena *arena)
+{
+    if (arena->sub_arena_end && arena->used < arena->sub_arena_end)
+    {
+        arena->committed        = get_arena_backed_committed(arena);
+        arena->sub_arena_begin  = 0;
+        arena->sub_arena_end    = 0;
+    }
+}
+
+//
+// Growable arenas
+//
+#define MEMORY_BLOCK_HEADER_SIZE    ARENA_CACHE_LINE
+
+// NOTE: blocks start on ARENA_COMMIT_GRANULARITY and are whole ones of it.
+internal void
+init_block_source(Memory_Block_Source *source, void *base, size_t size, Platform_Commit_Memory *commit)
+{
+    u64 first = ((u64)base + ARENA_COMMIT_GRANULARITY - 1) & ~((u64)ARENA_COMMIT_GRANULARITY - 1);
+    Assert(first - (u64)base < size);
+    source->base    = (u8 *)first;
+    source->size    = (size - (size_t)(first - (u64)base)) & ~((size_t)ARENA_COMMIT_GRANULARITY - 1);
+    source->used    = 0;
+    source->commit  = commit;
+}
+
+// only the header comes committed.
+internal Memory_Block *
+acquire_memory_block(Memory_Block_Source *source, size_t size)
+{
+    size = (size + ARENA_COMMIT_GRANULARITY - 1) & ~((size_t)ARENA_COMMIT_GRANULARITY - 1);
+    u64 offset = atomic_add_u64(&source->used, size);
+    // NOTE: out of reserved memory. Grow the reservation in the platform layer.
+    Assert(offset + size <= source->size);
+
+    Memory_Block *result = (Memory_Block *)(source->base + offset);
+    source->commit(result, MEMORY_BLOCK_HEADER_SIZE, false);
+    result->size        = size;
+    result->committed   = MEMORY_BLOCK_HEADER_SIZE;
+    result->next_free   = 0;
+
     return result;
 }
 
+// moves a growable arena on to a block with room for the push.
+internal void
+arena_grow(Memory_Arena *arena, size_t size, size_t alignment)
+{
+    Assert(arena->source);
+    size_t needed = MEMORY_BLOCK_HEADER_SIZE + alignment + size;
+
+    // NOTE: the smallest free block that fits. Free lists that are shared
+    // around, like the asset cache's, have blocks of all sizes on them.
+    Memory_Block **best = 0;
+    for (Memory_Block **link = &arena->first_free_block;
+         *link;
+         link = &(*link)->next_free)
+    {
+        if ((*link)->size >= needed &&
+            (!best || (*link)->size < (*best)->size))
+        {
+            best = link;
+        }
+    }
+
+    Memory_Block *block = 0;
+    if (best)
+    {
+        block = *best;
+        *best = block->next_free;
+    }
+    else
+    {
+        block = acquire_memory_block(arena->source, maximum(needed, arena->minimum_block_size));
+    }
+
+    // NOTE: the block left behind forgets its sub-arenas. Its pushes after a
+    // pop commit them again, which is fine.
+    block->prev_base        = arena->base;
+    block->prev_size        = arena->size;
+    block->prev_used        = arena->used;
+    block->prev_committed   = get_arena_backed_committed(arena);
+    block->prev             = arena->block;
+
+    arena->chained_size         += arena->size;
+    arena->chained_used         += arena->used;
+    arena->chained_committed    += arena->committed;
+    ++arena->block_count;
+
+    arena->block        = block;
+    arena->base         = (u8 *)block + MEMORY_BLOCK_HEADER_SIZE;
+    arena->size         = block->size - MEMORY_BLOCK_HEADER_SIZE;
+    arena->used         = 0;
+    arena->committed    = block->committed - MEMORY_BLOCK_HEADER_SIZE;
+    arena->commit       = arena->source->commit;
+    arena->sub_arena_begin  = 0;
+    arena->sub_arena_end    = 0;
+}
+
+// back to the block before, the current one is kept for later.
+internal void
+arena_pop_block(Memory_Arena *arena)
+{
+    Memory_Block *block = arena->block;
+    Assert(block);
+    block->committed    = MEMORY_BLOCK_HEADER_SIZE + get_arena_backed_committed(arena);
+    block->next_free    = arena->first_free_block;
+    arena->first_free_block = block;
+
+    arena->base         = block->prev_base;
+    arena->size         = block->prev_size;
+    arena->used         = block->prev_used;
+    arena->committed    = block->prev_committed;
+    arena->block        = block->prev;
+    arena->sub_arena_begin  = 0;
+    arena->sub_arena_end    = 0;
+
+    arena->chained_size         -= block->prev_size;
+    arena->chained_used         -= block->prev_used;
+    arena->chained_committed    -= block->prev_committed;
+    --arena->block_count;
+}
+
+// NOTE: site is where the push is, "file(line).counter", for the debug
+// allocation view. Only pushes to tagged arenas are recorded.
 internal void *
-push_size_(Memory_Arena *arena, size_t size)
+push_size_(char *site, Memory_Arena *arena, size_t size, size_t alignment = ARENA_DEFAULT_ALIGNMENT)
 {
-    Assert((arena->used + size) <= arena->size);
-    void *result = (u8 *)arena->base + arena->used;
-    arena->used += size;
+    if (arena->source && !arena_block_has_room_for(arena, size, alignment))
+    {
+        arena_grow(arena, size, alignment);
+    }
+
+    size_t offset = get_alignment_offset(arena, alignment);
+    size_t needed = arena->used + offset + size;
+    Assert(needed <= arena->size);
+    if (needed > arena->committed)
+    {
+        arena_commit(arena, needed, false);
+    }
+    void *result = (u8 *)arena->base + arena->used + offset;
+    arena->used = needed;
+    arena->high_water = maximum(arena->high_water, arena->chained_used + arena->used);
+
+    if (arena->tag)
+    {
+        DEBUG_RECORD_ALLOCATION(site, arena->tag, offset + size);
+    }
 
     return result;
 }
-#define push_size(arena, size)              push_size_(arena, size)
-#define push_struct(arena, type)            (type *)push_size_(arena, sizeof(type))
-#define push_array(arena, type, count)      (type *)push_size_(arena, count * sizeof(type))
-#define push_copy(arena, src, size)         copy(push_size(arena, size), src, size)
 
+#if __DEVELOPER
+#define ARENA_PUSH_SITE     unique_file_counter_string()
+#else
+#define ARENA_PUSH_SITE     0
+#endif
+
+// NOTE: the optional last argument is the alignment.
+#define push_size(arena, size, ...)             push_size_(ARENA_PUSH_SITE, arena, size, ##__VA_ARGS__)
+#define push_struct(arena, type, ...)           (type *)push_size_(ARENA_PUSH_SITE, arena, sizeof(type), ##__VA_ARGS__)
+#define push_array(arena, type, count, ...)     (type *)push_size_(ARENA_PUSH_SITE, arena, (count) * sizeof(type), ##__VA_ARGS__)
+#define push_copy(arena, src, size, ...)        copy(push_size(arena, size, ##__VA_ARGS__), src, size)
+
+// NOTE: for memory that's committed already.
 internal void
 init_arena(Memory_Arena *arena, size_t size, void *base)
 {
-    arena->size = size;
-    arena->base = base;
-    arena->used = 0;
+    *arena = {};
+    arena->size         = size;
+    arena->base         = base;
+    arena->committed    = size;
+}
+
+// for game memory, which is only reserved.
+internal void
+init_arena(Memory_Arena *arena, size_t size, void *base,
+           Platform_Commit_Memory *commit, Arena_Commit commit_policy)
+{
+    init_arena(arena, size, base);
+    arena->committed    = 0;
+    arena->commit       = commit;
+    if (commit_policy == eArena_Commit_Prefault)
+    {
+        arena_commit(arena, size, true);
+    }
 }
 
+// NOTE: starts out with nothing, the first push gets it a block. Prefaulted,
+// it gets its first block now, and keeps it for good.
+internal void
+init_growable_arena(Memory_Arena *arena, Memory_Block_Source *source, size_t minimum_block_size,
+                    Arena_Commit commit_policy = eArena_Commit_Lazy)
+{
+    *arena = {};
+    arena->source               = source;
+    arena->minimum_block_size   = minimum_block_size;
+    if (commit_policy == eArena_Commit_Prefault)
+    {
+        arena_grow(arena, 0, ARENA_DEFAULT_ALIGNMENT);
+        arena_commit(arena, arena->size, true);
+    }
+}
+
+// in the current block.
 inline size_t
-get_arena_size_remaining(Memory_Arena *arena)
+get_arena_size_remaining(Memory_Arena *arena, size_t alignment = ARENA_DEFAULT_ALIGNMENT)
 {
-    size_t result = arena->size - arena->used;
+    size_t result = 0;
+    size_t offset = get_alignment_offset(arena, alignment);
+    if (arena->used + offset < arena->size)
+    {
+        result = arena->size - (arena->used + offset);
+    }
     return result;
 }
 
+// NOTE: sub-arenas start on a cache line, they're usually some thread's, and
+// are fixed even if the mom grows. The sub-arena commits its own memory.
+// The mom only hands it over and notes the range, so that pushes to the mom
+// don't commit it again. Whatever of it the mom had committed already counts
+// for the sub-arena.
 internal void
-init_sub_arena(Memory_Arena *sub_arena, Memory_Arena *mom_arena, size_t size)
+init_sub_arena(Memory_Arena *sub_arena, Memory_Arena *mom_arena, size_t size,
+               Arena_Commit commit_policy = eArena_Commit_Lazy)
 {
+    if (mom_arena->source && !arena_block_has_room_for(mom_arena, size, ARENA_CACHE_LINE))
+    {
+        arena_grow(mom_arena, size, ARENA_CACHE_LINE);
+    }
+    mom_arena->used += get_alignment_offset(mom_arena, ARENA_CACHE_LINE);
     Assert(mom_arena->size >= mom_arena->used + size);
-    init_arena(sub_arena, size, (u8 *)mom_arena->base + mom_arena->used);
+    void *base = (u8 *)mom_arena->base + mom_arena->used;
+    if (mom_arena->committed >= mom_arena->used + size)
+    {
+        init_arena(sub_arena, size, base);
+    }
+    else
+    {
+        size_t committed = 0;
+        if (mom_arena->committed > mom_arena->used)
+        {
+            committed = mom_arena->committed - mom_arena->used;
+        }
+        init_arena(sub_arena, size, base, mom_arena->commit, eArena_Commit_Lazy);
+        sub_arena->committed = committed;
+        if (commit_policy == eArena_Commit_Prefault)
+        {
+            arena_commit(sub_arena, size, true);
+        }
+
+        if (!mom_arena->sub_arena_end)
+        {
+            mom_arena->sub_arena_begin = mom_arena->committed;
+        }
+        mom_arena->sub_arena_end = mom_arena->used + size;
+        mom_arena->committed = mom_arena->used + size;
+    }
     mom_arena->used += size;
 }
 
@@ -58,6 +340,7 @@ begin_temporary_memory(Memory_Arena *memoryArena)
     Temporary_Memory result = {};
     result.memoryArena = memoryArena;
     result.used = memoryArena->used;
+    result.block = memoryArena->block;
 
     return result;
 }
@@ -66,52 +349,244 @@ internal void
 end_temporary_memory(Temporary_Memory *temporaryMemory) 
 {
     Memory_Arena *arena = temporaryMemory->memoryArena;
+    while (arena->block != temporaryMemory->block)
+    {
+        arena_pop_block(arena);
+    }
     Assert(arena->used >= temporaryMemory->used);
     arena->used = temporaryMemory->used;
+    arena_take_back_sub_arenas(arena);
     Assert(arena->tempCount > 0);
     arena->tempCount--;
 }
 
-internal Work_Memory_Arena *
-begin_work_memory(Transient_State *transState)
+//
+// Pools
+//
+#define POOL_SLAB_SIZE          KB(4)
+#define POOL_SLAB_HEADER_SIZE   ARENA_CACHE_LINE
+
+internal void
+init_pool(Pool *pool, Memory_Arena *arena, size_t slot_size, size_t slot_alignment)
+{
+    *pool = {};
+    pool->arena             = arena;
+    pool->slot_size         = (slot_size + slot_alignment - 1) & ~(slot_alignment - 1);
+    pool->slots_per_slab    = (u32)((POOL_SLAB_SIZE - POOL_SLAB_HEADER_SIZE) / pool->slot_size);
+    Assert(pool->slots_per_slab > 0);
+}
+
+inline Pool_Slab *
+get_pool_slab(void *slot)
+{
+    Pool_Slab *result = (Pool_Slab *)((u64)slot & ~((u64)POOL_SLAB_SIZE - 1));
+    return result;
+}
+
+// a slot that was never handed out, off the first slab or a new one.
+internal void *
+pool_carve(Pool *pool)
 {
-    Work_Memory_Arena *result = 0;
-    for (s32 idx = 0;
-         idx < array_count(transState->work_arenas);
-         ++idx)
+    Pool_Slab *slab = pool->first_slab;
+    if (!slab || slab->carved_count == pool->slots_per_slab)
     {
-        Work_Memory_Arena *work_slot = transState->work_arenas + idx;
-        if (!work_slot->is_used) 
-        {
-            result = work_slot;
-            result->is_used = true;
-            result->flush = begin_temporary_memory(&result->arena);
-            break;
-        }
+        slab = (Pool_Slab *)push_size(pool->arena, POOL_SLAB_SIZE, POOL_SLAB_SIZE);
+        slab->next          = pool->first_slab;
+        slab->carved_count  = 0;
+        slab->live_count    = 0;
+        pool->first_slab    = slab;
+        ++pool->slab_count;
     }
+
+    void *result = (u8 *)slab + POOL_SLAB_HEADER_SIZE + slab->carved_count++ * pool->slot_size;
     return result;
 }
 
+// NOTE: the typed pool calls these around its free list.
+inline void
+pool_slot_taken(Pool *pool, void *slot)
+{
+    ++get_pool_slab(slot)->live_count;
+    ++pool->live_count;
+    ++pool->alloc_count;
+    pool->high_water = maximum(pool->high_water, pool->live_count);
+}
+
+inline void
+pool_slot_given_back(Pool *pool, void *slot)
+{
+    Pool_Slab *slab = get_pool_slab(slot);
+    Assert(slab->live_count > 0);
+    --slab->live_count;
+    --pool->live_count;
+    ++pool->free_count;
+}
+
+//
+// Atomic arenas
+//
+// NOTE: pushes past this part of a chunk don't go through the cursor, they
+// would waste too much of the chunk they'd retire.
+#define ATOMIC_ARENA_CURSOR_PUSH_FRACTION   4
+// the thread index for a push that doesn't go through any cursor.
+#define ATOMIC_ARENA_NO_CURSOR              0xffffffff
+
+inline u8 *
+align_pointer(u8 *at, size_t alignment)
+{
+    Assert(alignment && (alignment & (alignment - 1)) == 0 && alignment <= ARENA_MAX_ALIGNMENT);
+    u8 *result = (u8 *)(((u64)at + alignment - 1) & ~((u64)alignment - 1));
+    return result;
+}
+
+// NOTE: cursor_count is usually the job thread count. The cursors go at the
+// front of the block, after its header, then the committed flags. The
+// block comes rounded up and needn't start on a granule, hence the extra
+// flags.
+internal void
+init_atomic_arena(Atomic_Arena *arena, Memory_Block_Source *source, size_t size, size_t chunk_size,
+                  u32 cursor_count)
+{
+    Assert(chunk_size && (chunk_size % ARENA_CACHE_LINE) == 0);
+    size_t cursors_size = cursor_count * sizeof(Atomic_Arena_Cursor);
+    u32 granule_count = (u32)(size / ARENA_COMMIT_GRANULARITY + 3);
+    size_t granules_size = (granule_count * sizeof(u32) + ARENA_CACHE_LINE - 1) & ~((size_t)ARENA_CACHE_LINE - 1);
+    size_t front_size = MEMORY_BLOCK_HEADER_SIZE + cursors_size + granules_size;
+    Memory_Block *block = acquire_memory_block(source, front_size + size);
+    source->commit(block, front_size, false);
+
+    zero_struct(*arena);
+    arena->cursors      = (Atomic_Arena_Cursor *)((u8 *)block + MEMORY_BLOCK_HEADER_SIZE);
+    arena->cursor_count = cursor_count;
+    zero_array(cursor_count, arena->cursors);
+
+    arena->committed_granules   = (u32 *)(arena->cursors + cursor_count);
+    arena->granule_count        = granule_count;
+    zero_size(granules_size, (void *)arena->committed_granules);
+
+    arena->base         = (u8 *)block + front_size;
+    arena->size         = block->size - front_size;
+    arena->chunk_size   = chunk_size;
+    arena->commit       = source->commit;
+}
+
+// NOTE: from any thread. A granule is committed by the first push into it,
+// or by each of the pushes that race into it, committing twice is fine.
+// Nobody waits on anybody else's commit.
 internal void
-end_work_memory(Work_Memory_Arena *workMemory_Arena)
+atomic_arena_commit(Atomic_Arena *arena, u64 offset, u64 size)
 {
-    end_temporary_memory(&workMemory_Arena->flush);
-    __WRITE_BARRIER__
-    workMemory_Arena->is_used = false;
+    u64 first_granule = (u64)arena->base / ARENA_COMMIT_GRANULARITY;
+    u64 begin = ((u64)arena->base + offset) / ARENA_COMMIT_GRANULARITY - first_granule;
+    u64 end = ((u64)arena->base + offset + size - 1) / ARENA_COMMIT_GRANULARITY - first_granule;
+    Assert(end < arena->granule_count);
+    for (u64 granule = begin;
+         granule <= end;
+         ++granule)
+    {
+        if (!atomic_load_u32(arena->committed_granules + granule, eMemory_Order_Acquire))
+        {
+            u8 *at = (u8 *)((first_granule + granule) * ARENA_COMMIT_GRANULARITY);
+            u8 *from = maximum(at, arena->base);
+            u8 *to = minimum(at + ARENA_COMMIT_GRANULARITY, arena->base + arena->size);
+            arena->commit(from, (u64)(to - from), false);
+            atomic_store_u32(arena->committed_granules + granule, 1, eMemory_Order_Release);
+        }
+    }
 }
 
+// NOTE: from any thread, lock-free. thread_idx is the job thread index of
+// the caller; anything past cursor_count pushes without a cursor. The
+// atomic adds are relaxed, the ranges they hand out aren't shared.
 internal void *
-copy(void *dst, void *src, size_t size)
+push_size_atomic_(Atomic_Arena *arena, u32 thread_idx, size_t size,
+                  size_t alignment = ARENA_DEFAULT_ALIGNMENT)
 {
-    if (size)
+    void *result = 0;
+    Atomic_Arena_Cursor *cursor = (thread_idx < arena->cursor_count) ? arena->cursors + thread_idx : 0;
+    b32 through_cursor = (cursor &&
+                          size + alignment <= arena->chunk_size / ATOMIC_ARENA_CURSOR_PUSH_FRACTION);
+    if (through_cursor)
     {
-        u8 *dst_at = (u8 *)dst;
-        u8 *src_at = (u8 *)src;
-        for (size_t i = 0; i < size; ++i)
+        u8 *at = align_pointer(cursor->at, alignment);
+        if (!cursor->end || at + size > cursor->end)
         {
-            *dst_at++ = *src_at++;
+            // retire the chunk, take a new one.
+            if (cursor->end)
+            {
+                atomic_add_u64(&arena->wasted, (u64)(cursor->end - cursor->at), eMemory_Order_Relaxed);
+            }
+            u64 offset = atomic_add_u64(&arena->used, arena->chunk_size, eMemory_Order_Relaxed);
+            // NOTE: out of space. Make the arena bigger.
+            Assert(offset + arena->chunk_size <= arena->size);
+            atomic_arena_commit(arena, offset, arena->chunk_size);
+            cursor->at  = arena->base + offset;
+            cursor->end = cursor->at + arena->chunk_size;
+            at = align_pointer(cursor->at, alignment);
         }
+        cursor->at = at + size;
+        result = at;
+    }
+    else
+    {
+        u64 padded = size + alignment - 1;
+        u64 offset = atomic_add_u64(&arena->used, padded, eMemory_Order_Relaxed);
+        Assert(offset + padded <= arena->size);
+        atomic_arena_commit(arena, offset, padded);
+        result = align_pointer(arena->base + offset, alignment);
+    }
+
+    return result;
+}
+
+#define push_size_atomic(arena, thread_idx, size, ...)         push_size_atomic_(arena, thread_idx, size, ##__VA_ARGS__)
+#define push_struct_atomic(arena, thread_idx, type, ...)       (type *)push_size_atomic_(arena, thread_idx, sizeof(type), ##__VA_ARGS__)
+#define push_array_atomic(arena, thread_idx, type, count, ...) (type *)push_size_atomic_(arena, thread_idx, (count) * sizeof(type), ##__VA_ARGS__)
+
+// NOTE: retires every cursor, so pushes after this take chunks past used.
+// Nobody may be pushing.
+internal void
+retire_atomic_arena_cursors(Atomic_Arena *arena)
+{
+    for (u32 cursor_idx = 0;
+         cursor_idx < arena->cursor_count;
+         ++cursor_idx)
+    {
+        Atomic_Arena_Cursor *cursor = arena->cursors + cursor_idx;
+        arena->wasted += (u64)(cursor->end - cursor->at);
+        cursor->at  = 0;
+        cursor->end = 0;
     }
+}
+
+// NOTE: both ends only while nobody pushes, e.g. before and after the
+// parallel_for that does.
+internal Atomic_Temporary_Memory
+begin_atomic_temporary_memory(Atomic_Arena *arena)
+{
+    retire_atomic_arena_cursors(arena);
+    ++arena->temp_count;
 
-    return dst;
+    Atomic_Temporary_Memory result = {};
+    result.arena    = arena;
+    result.used     = arena->used;
+    return result;
+}
+
+internal void
+end_atomic_temporary_memory(Atomic_Temporary_Memory *temp)
+{
+    Atomic_Arena *arena = temp->arena;
+    retire_atomic_arena_cursors(arena);
+    Assert(arena->used >= temp->used);
+    arena->used = temp->used;
+    Assert(arena->temp_count > 0);
+    --arena->temp_count;
+}
+
+inline void *
+copy(void *dst, void *src, size_t size)
+{
+    void *result = copy_memory(dst, src, size);
+    return result;
 }
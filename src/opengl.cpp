@@ -819,11 +819,12 @@ gl_render_batch(Render_Batch *batch, u32 win_w, u32 win_h)
     //
     // Reallocate buffers dependent to changed window width & height.
     //
-    if (batch->width != win_w ||
-        batch->height != win_h)
+    // NOTE: kept here rather than on the batch, there's one batch per frame in flight.
+    if (gl.screen_width != win_w ||
+        gl.screen_height != win_h)
     {
-        batch->width = win_w;
-        batch->height = win_h;
+        gl.screen_width = win_w;
+        gl.screen_height = win_h;
 
         gl_reallocate_screen_dependent_buffers(win_w, win_h);
     }
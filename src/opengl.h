@@ -234,6 +234,8 @@ struct GL
     Defer_Program           defer_program;
 
     G_Buffer                gbuffer;
+    u32                     screen_width;
+    u32                     screen_height;
 
     GLuint  vao;
     GLuint  vbo;
@@ -0,0 +1,207 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+
+/*
+ * parallel_for splits [first, one_past_last) into tasks of `grain` items and
+ * runs them as jobs, returning when all are done. The calling thread helps.
+ *
+ * Pass grain 0 to have it picked: about PARALLEL_FOR_TASKS_PER_THREAD tasks
+ * per job thread, which is enough to even out uneven items without paying
+ * for a job per item.
+ *
+ * Every task gets a scratch arena of the thread it runs on. Both of the
+ * thread's scratch arenas are rolled back once the task returns, so whatever
+ * a task leaves in them is gone by the next one. A context of 0 runs
+ * everything on the caller.
+ *
+ * get_thread_scratch hands out the other arena of the pair to code that is
+ * already pushing to one, say a result, and needs scratch on top. The arenas
+ * grow out of transient memory, so they don't run out either.
+ */
+
+#define PARALLEL_FOR_CALLBACK(name) void name(u32 first, u32 one_past_last, Memory_Arena *scratch, void *data)
+typedef PARALLEL_FOR_CALLBACK(Parallel_For_Callback);
+
+#define PARALLEL_FOR_TASKS_PER_THREAD   4
+#define PARALLEL_FOR_MAX_TASKS          256
+
+struct Parallel_For_Task
+{
+    Parallel_Context        *context;
+    Parallel_For_Callback   *callback;
+    void                    *data;
+
+    u32                     first;
+    u32                     one_past_last;
+};
+
+// the calling thread's scratch, if it's a job thread.
+internal Thread_Scratch *
+get_thread_scratches(Parallel_Context *context)
+{
+    Thread_Scratch *result = 0;
+    if (context)
+    {
+        u32 thread_idx = context->get_job_thread_index();
+        if (thread_idx < context->thread_count)
+        {
+            result = context->thread_scratch + thread_idx;
+        }
+    }
+    return result;
+}
+
+// NOTE: a scratch arena of the calling thread that isn't `conflict`. Pass
+// the arena the caller is already pushing to.
+internal Memory_Arena *
+get_thread_scratch(Parallel_Context *context, Memory_Arena *conflict = 0)
+{
+    Memory_Arena *result = 0;
+    Thread_Scratch *scratch = get_thread_scratches(context);
+    if (scratch)
+    {
+        for (u32 idx = 0;
+             idx < THREAD_SCRATCH_COUNT;
+             ++idx)
+        {
+            if (scratch->arenas + idx != conflict)
+            {
+                result = scratch->arenas + idx;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+internal void
+run_parallel_for_task(Parallel_For_Task *task)
+{
+    Thread_Scratch *scratch = get_thread_scratches(task->context);
+    if (scratch)
+    {
+        Temporary_Memory scratch_memory[THREAD_SCRATCH_COUNT];
+        for (u32 idx = 0;
+             idx < THREAD_SCRATCH_COUNT;
+             ++idx)
+        {
+            scratch_memory[idx] = begin_temporary_memory(scratch->arenas + idx);
+        }
+
+        task->callback(task->first, task->one_past_last, scratch->arenas, task->data);
+
+        for (u32 idx = THREAD_SCRATCH_COUNT;
+             idx > 0;
+             --idx)
+        {
+            end_temporary_memory(scratch_memory + idx - 1);
+        }
+    }
+    else
+    {
+        task->callback(task->first, task->one_past_last, 0, task->data);
+    }
+}
+
+PLATFORM_JOB_CALLBACK(parallel_for_job)
+{
+    Parallel_For_Task *task = (Parallel_For_Task *)data;
+    run_parallel_for_task(task);
+}
+
+internal u32
+get_parallel_for_grain(Parallel_Context *context, u32 count, u32 grain)
+{
+    u32 result = grain;
+    if (!result)
+    {
+        u32 thread_count = context ? context->thread_count : 1;
+        result = count / (thread_count * PARALLEL_FOR_TASKS_PER_THREAD);
+    }
+
+    // NOTE: the tasks live on the caller's stack.
+    u32 min_grain = (count + PARALLEL_FOR_MAX_TASKS - 1) / PARALLEL_FOR_MAX_TASKS;
+    result = maximum(result, min_grain);
+    result = maximum(result, 1);
+
+    return result;
+}
+
+internal void
+parallel_for(Parallel_Context *context, u32 first, u32 one_past_last, u32 grain,
+             Parallel_For_Callback *callback, void *data)
+{
+    TIMED_FUNCTION();
+
+    if (first >= one_past_last)
+    {
+        return;
+    }
+
+    u32 count = one_past_last - first;
+    grain = get_parallel_for_grain(context, count, grain);
+
+    if (!context || context->thread_count <= 1 || count <= grain)
+    {
+        Parallel_For_Task task = {context, callback, data, first, one_past_last};
+        run_parallel_for_task(&task);
+        return;
+    }
+
+    Parallel_For_Task tasks[PARALLEL_FOR_MAX_TASKS];
+    Platform_Job_Counter counter = {};
+
+    u32 task_count = 0;
+    for (u32 task_first = first;
+         task_first < one_past_last;
+         task_first += grain)
+    {
+        Assert(task_count < PARALLEL_FOR_MAX_TASKS);
+        Parallel_For_Task *task = tasks + task_count++;
+        task->context           = context;
+        task->callback          = callback;
+        task->data              = data;
+        task->first             = task_first;
+        task->one_past_last     = minimum(task_first + grain, one_past_last);
+
+        context->add_job(&counter, 0, parallel_for_job, task);
+    }
+
+    context->wait_for_counter(&counter);
+}
+
+// NOTE: scratch_size is each arena's first block. Past that they grow out
+// of the block source.
+internal void
+init_parallel_context(Parallel_Context *context, Platform_API *platform, u32 thread_count,
+                      Memory_Arena *arena, Memory_Block_Source *source, size_t scratch_size)
+{
+    context->add_job                = platform->platform_add_job;
+    context->wait_for_counter       = platform->platform_wait_for_counter;
+    context->get_job_thread_index   = platform->platform_get_job_thread_index;
+    context->thread_count           = maximum(thread_count, 1);
+    context->thread_scratch         = push_array(arena, Thread_Scratch, context->thread_count,
+                                                 alignof(Thread_Scratch));
+
+    for (u32 idx = 0;
+         idx < context->thread_count;
+         ++idx)
+    {
+        Thread_Scratch *scratch = context->thread_scratch + idx;
+        for (u32 arena_idx = 0;
+             arena_idx < THREAD_SCRATCH_COUNT;
+             ++arena_idx)
+        {
+            // NOTE: every frame goes through the first ones, no point faulting
+            // them in mid-frame. The others are for nested use, rarely touched.
+            init_growable_arena(scratch->arenas + arena_idx, source, scratch_size,
+                                arena_idx ? eArena_Commit_Lazy : eArena_Commit_Prefault);
+            scratch->arenas[arena_idx].tag = eArena_Tag_Thread_Scratch;
+        }
+    }
+}
@@ -33,49 +33,43 @@ struct Bitmap;
   #include <intrin.h>
 #elif   __LLVM
   #include <x86intrin.h>
+  #include <stdarg.h>
+  #include <stdio.h>
 #endif
 
-#if __MSVC
-  #define __WRITE_BARRIER__ _WriteBarrier();
-#elif   __LLVM
-
-#endif
-
-
-inline u32
-atomic_compare_exchange_u32(u32 volatile *value, u32 _new, u32 expected) 
-{
-    u32 result = _InterlockedCompareExchange((long *)value, _new, expected);
-    return result;
-}
-
-inline u32
-atomic_exchange_u32(u32 volatile *value, u32 _new) 
+#if __LLVM
+// NOTE: stand-ins for the MSVC secure CRT, truncating like _TRUNCATE does.
+inline int
+_snprintf_s(char *buffer, size_t size, size_t count, const char *format, ...)
 {
-    u32 result = _InterlockedExchange((long *)value, _new);
+    va_list args;
+    va_start(args, format);
+    int result = vsnprintf(buffer, size, format, args);
+    va_end(args);
+    if (result >= (int)size)
+    {
+        result = (int)size - 1;
+    }
     return result;
 }
 
-inline u64
-atomic_exchange_u64(u64 volatile *value, u64 _new) 
+template <size_t N> inline int
+_snprintf_s(char (&buffer)[N], size_t count, const char *format, ...)
 {
-    u64 result = _InterlockedExchange64((long long *)value, _new);
+    va_list args;
+    va_start(args, format);
+    int result = vsnprintf(buffer, N, format, args);
+    va_end(args);
+    if (result >= (int)N)
+    {
+        result = (int)N - 1;
+    }
     return result;
 }
+#endif
 
-inline u32
-atomic_add_u32(u32 volatile *value, u32 addend) 
-{
-    u32 result = _InterlockedExchangeAdd((long *)value, addend);
-    return result;
-}
 
-inline u64
-atomic_add_u64(u64 volatile *value, u64 addend) 
-{
-    u64 result = _InterlockedExchangeAdd64((long long *)value, addend);
-    return result;
-}
+#include "atomics.h"
 
 struct Entire_File 
 {
@@ -165,11 +159,95 @@ typedef PLATFORM_WORK_QUEUE_CALLBACK(Platform_Work_QueueCallback);
 typedef void Platform_Add_Entry(Platform_Work_Queue *queue, Platform_Work_QueueCallback *callback, void *data);
 typedef void Platform_Complete_All_Work(Platform_Work_Queue *queue);
 
+//
+// Job System
+//
+// Jobs added with a parent don't count as finished until all of their
+// children have finished. A counter goes up by one per job added with it and
+// down when that job (and all its children) finished. Waiting on a counter
+// runs other jobs in the meantime. Jobs only ever run on the job threads,
+// which are numbered 0 to job_thread_count - 1.
+//
+// A fiber job runs on its own stack instead; waiting inside it parks the job
+// until the counter hits zero, and it may carry on on another job thread.
+//
+struct Platform_Job;
+struct Platform_Job_Counter
+{
+    u32 volatile value;
+};
+#define PLATFORM_JOB_CALLBACK(name) void name(Platform_Job *job, void *data)
+typedef PLATFORM_JOB_CALLBACK(Platform_Job_Callback);
+
+typedef void Platform_Add_Job(Platform_Job_Counter *counter, Platform_Job *parent, Platform_Job_Callback *callback, void *data);
+typedef void Platform_Wait_For_Counter(Platform_Job_Counter *counter);
+typedef u32 Platform_Get_Job_Thread_Index();
+
+//
+// File I/O
+//
+// Reads are asynchronous. Each adds one to the counter it is given and takes
+// it off once the bytes are in dest, so platform_wait_for_counter waits for
+// a batch of them, and polling counter->value works too. A read that fails
+// clears the file's no_errors. Don't close a file with reads in flight.
+//
+struct Platform_File_Handle
+{
+    b32 volatile    no_errors;
+    u64             size;
+    u64             platform;
+};
+
+#define PLATFORM_OPEN_FILE(name) Platform_File_Handle name(const char *file_name)
+typedef PLATFORM_OPEN_FILE(Platform_Open_File);
+
+#define PLATFORM_READ_FILE(name) void name(Platform_File_Handle *file, u64 offset, u64 size, void *dest, Platform_Job_Counter *counter)
+typedef PLATFORM_READ_FILE(Platform_Read_File);
+
+#define PLATFORM_CLOSE_FILE(name) void name(Platform_File_Handle *file)
+typedef PLATFORM_CLOSE_FILE(Platform_Close_File);
+
+// NOTE: the mapping is private and copy-on-write. Whatever a loader writes
+// to (a glyph's GL handle, a bitmap converted in place) becomes a copy of
+// its own page, the rest stays the page cache's. No contents if it failed.
+#define PLATFORM_MAP_FILE(name) Entire_File name(const char *file_name)
+typedef PLATFORM_MAP_FILE(Platform_Map_File);
+
+#define PLATFORM_UNMAP_FILE(name) void name(Entire_File *file)
+typedef PLATFORM_UNMAP_FILE(Platform_Unmap_File);
+
+//
+// Game Memory
+//
+// Game memory is only reserved up front. A range has to be committed before
+// it's touched, rounded out to whole pages; committing it again is fine.
+// With prefault, the pages are faulted in right away instead of on their
+// first touch, which may well be mid-frame.
+//
+// NOTE: the platform commits Game_State, Transient_State and the debug
+// storage itself, the game commits the rest through its arenas.
+//
+#define PLATFORM_COMMIT_MEMORY(name) void name(void *base, u64 size, b32 prefault)
+typedef PLATFORM_COMMIT_MEMORY(Platform_Commit_Memory);
+
 struct Platform_API 
 {
     Platform_Add_Entry          *platform_add_entry;
     Platform_Complete_All_Work  *platform_complete_all_work;
 
+    Platform_Add_Job            *platform_add_job;
+    Platform_Add_Job            *platform_add_fiber_job;
+    Platform_Wait_For_Counter   *platform_wait_for_counter;
+    Platform_Get_Job_Thread_Index *platform_get_job_thread_index;
+
+    Platform_Open_File          *platform_open_file;
+    Platform_Read_File          *platform_read_file;
+    Platform_Close_File         *platform_close_file;
+    Platform_Map_File           *platform_map_file;
+    Platform_Unmap_File         *platform_unmap_file;
+
+    Platform_Commit_Memory      *platform_commit_memory;
+
     Read_Entire_File            *debug_platform_read_file;
 #if __DEVELOPER
     DEBUG_PLATFORM_WRITE_FILE_  *debug_platform_write_file;
@@ -179,6 +257,13 @@ struct Platform_API
 #endif
 };
 
+// NOTE: the platform renders frame N while the game builds frame N+1 and on.
+#define RENDER_MAX_FRAMES_IN_FLIGHT         3
+#define RENDER_DEFAULT_FRAMES_IN_FLIGHT     2
+// NOTE: a group goes into the batch once per push buffer it filled. Those
+// double, so this is room for a few dozen groups that grew to GBs.
+#define RENDER_BATCH_SIZE                   KB(16)
+
 struct Render_Batch 
 {
     size_t  size;
@@ -188,6 +273,7 @@ struct Render_Batch
     f32     time;
     f32     dt;
 
+    // NOTE: size of the window it is for, set by the platform.
     u32     width;
     u32     height;
 
@@ -209,11 +295,16 @@ struct Game_Memory
 
     Platform_Work_Queue     *high_priority_queue;
     Platform_Work_Queue     *low_priority_queue;
+    u32                     job_thread_count;
 
     b32                     executable_reloaded;
     Platform_API            platform;
 
-    Render_Batch            render_batch;
+    // NOTE: this frame's batch, and which of the frames in flight it is.
+    // Anything the batch points to has to stay put until the same slot
+    // comes around again.
+    Render_Batch            *render_batch;
+    u32                     render_slot;
 };
 
 struct Game_Screen_Buffer
@@ -11,10 +11,37 @@
 #define push_render_entity(GROUP, STRUCT)  \
     (STRUCT *)__push_render_entity(GROUP, sizeof(STRUCT), e##STRUCT)
 
+internal void
+render_group_grow(Render_Group *group, size_t size)
+{
+    Render_Group_Block *block = push_struct(group->arena, Render_Group_Block);
+    block->base = group->base;
+    block->used = group->used;
+    block->next = 0;
+    if (group->last_full_block)
+    {
+        group->last_full_block->next = block;
+    }
+    else
+    {
+        group->first_full_block = block;
+    }
+    group->last_full_block = block;
+
+    // NOTE: doubles, so a group that lives across frames, whose full
+    // buffers are never taken back, stops growing soon.
+    group->capacity = maximum(2 * group->capacity, size);
+    group->base     = (u8 *)push_size(group->arena, group->capacity, ARENA_CACHE_LINE);
+    group->used     = 0;
+}
+
 internal Render_Entity_Header *
 __push_render_entity(Render_Group *renderGroup, u32 size, Render_Type type)
 {
-    Assert(size + renderGroup->used <= renderGroup->capacity);
+    if (size + renderGroup->used > renderGroup->capacity)
+    {
+        render_group_grow(renderGroup, size);
+    }
 
     Render_Entity_Header *header = (Render_Entity_Header *)(renderGroup->base + renderGroup->used);
     header->type = type;
@@ -37,18 +64,35 @@ end_render(Render_Group *render_group)
     if (render_group)
     {
         render_group->used = 0;
+        render_group->first_full_block = 0;
+        render_group->last_full_block = 0;
     }
 }
 
+// NOTE: the pose is copied in, right after the piece. The entity's own array
+// is rewritten by the next frame's animation while this one is rendered.
 internal void
 push_mesh(Render_Group *group, Mesh *mesh, Material *material,
-          m4x4 world_transform, m4x4 *animation_transforms = 0)
+          m4x4 world_transform, m4x4 *animation_transforms = 0, u32 animation_transform_count = 0)
 {
-    Render_Mesh *piece          = push_render_entity(group, Render_Mesh);
+    u32 size = sizeof(Render_Mesh);
+    if (animation_transforms)
+    {
+        // the renderer uploads MAX_BONE_PER_MESH of them whatever the count.
+        size += MAX_BONE_PER_MESH * sizeof(m4x4);
+    }
+
+    Render_Mesh *piece          = (Render_Mesh *)__push_render_entity(group, size, eRender_Mesh);
     piece->mesh                 = mesh;
     piece->material             = material;
     piece->world_transform      = world_transform;
-    piece->animation_transforms = animation_transforms;
+    piece->animation_transforms = 0;
+    if (animation_transforms)
+    {
+        piece->animation_transforms = (m4x4 *)(piece + 1);
+        copy(piece->animation_transforms, animation_transforms,
+             minimum(animation_transform_count, MAX_BONE_PER_MESH) * sizeof(m4x4));
+    }
 }
 
 internal void
@@ -294,9 +338,11 @@ alloc_render_group(Memory_Arena *arena, size_t size, Camera *camera)
     Render_Group *result = push_struct(arena, Render_Group);
     *result = {};
     result->capacity            = size;
-    result->base                = (u8 *)push_size(arena, result->capacity);
+    result->base                = (u8 *)push_size(arena, result->capacity, ARENA_CACHE_LINE);
     result->used                = 0;
     result->camera = camera;
+    result->camera_snapshot     = push_struct(arena, Camera);
+    result->arena               = arena;
 
     set_camera_projection(camera);
 
@@ -304,10 +350,34 @@ alloc_render_group(Memory_Arena *arena, size_t size, Camera *camera)
 }
 
 internal void
-render_group_to_output_batch(Render_Group *group, Render_Batch *batch)
+render_group_block_to_output_batch(Render_Group *group, u8 *base, size_t used, Render_Batch *batch)
 {
     Assert(batch->used + sizeof(Render_Group) <= batch->size);
 
-    *(Render_Group *)((u8 *)batch->base + batch->used) = *group;
+    Render_Group *out = (Render_Group *)((u8 *)batch->base + batch->used);
+    *out = *group;
+    out->base = base;
+    out->used = used;
+    if (group->camera)
+    {
+        out->camera = group->camera_snapshot;
+    }
     batch->used += sizeof(Render_Group);
 }
+
+internal void
+render_group_to_output_batch(Render_Group *group, Render_Batch *batch)
+{
+    if (group->camera)
+    {
+        *group->camera_snapshot = *group->camera;
+    }
+
+    for (Render_Group_Block *block = group->first_full_block;
+         block;
+         block = block->next)
+    {
+        render_group_block_to_output_batch(group, block->base, block->used, batch);
+    }
+    render_group_block_to_output_batch(group, group->base, group->used, batch);
+}
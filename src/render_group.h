@@ -112,6 +112,18 @@ enum Render_Group_Type
 };
 #endif
 
+// NOTE: what a frame's groups start with. They double as they fill, so a
+// quiet frame only commits this much.
+#define RENDER_GROUP_INITIAL_SIZE   KB(64)
+
+// NOTE: a full push buffer of a group, which goes out ahead of the rest.
+struct Render_Group_Block
+{
+    u8                  *base;
+    size_t              used;
+    Render_Group_Block  *next;
+};
+
 struct Render_Group 
 {
     //Render_Group_Type   type;
@@ -120,6 +132,17 @@ struct Render_Group
     size_t              used;
     u8                  *base;
     Camera              *camera;
+
+    // NOTE: where the camera is copied to when the group goes out, so that
+    // the render thread doesn't see the next frame move it.
+    Camera              *camera_snapshot;
+
+    // NOTE: once the push buffer is full, the group carries on in a new one
+    // from arena. The renderer gets each full one as a group of its own,
+    // same camera, in order.
+    Memory_Arena        *arena;
+    Render_Group_Block  *first_full_block;
+    Render_Group_Block  *last_full_block;
 };
 
 
@@ -6,16 +6,21 @@
    $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
    ======================================================================== */
 
+// NOTE: the coordinates multiplied into one word and put through murmur3's
+// finalizer, so that neighbouring chunks land all over the table.
 inline u32
-chunk_hash(Chunk_Hashmap *chunkHashmap, Chunk_Position pos)
+chunk_hash(Chunk_Position pos)
 {
-    TIMED_FUNCTION();
-    // TODO: Better hash function.
-    u32 bucket = ((pos.x * 16 + pos.y * 9 + pos.z * 4) &
-                  (array_count(chunkHashmap->chunks) - 1));
-    Assert(bucket < sizeof(chunkHashmap->chunks));
-
-    return bucket;
+    u64 h = (((u64)(u32)pos.x * 0x9e3779b97f4a7c15ull) ^
+             ((u64)(u32)pos.y * 0xc2b2ae3d27d4eb4full) ^
+             ((u64)(u32)pos.z * 0x165667b19e3779f9ull));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    u32 result = (u32)h;
+    return result;
 }
 
 inline b32
@@ -28,122 +33,555 @@ is_same_chunk(Chunk_Position A, Chunk_Position B)
     return result;
 }
 
+internal Chunk *
+alloc_chunk(Chunk_Pool *chunk_pool)
+{
+    Chunk *result;
+    FREELIST_ALLOC(result, chunk_pool->first_free, (Chunk *)pool_carve(&chunk_pool->pool));
+    pool_slot_taken(&chunk_pool->pool, result);
+    zero_struct(*result);
+    return result;
+}
+
+internal void
+free_chunk(Chunk_Pool *chunk_pool, Chunk *chunk)
+{
+    pool_slot_given_back(&chunk_pool->pool, chunk);
+    FREELIST_DEALLOC(chunk, chunk_pool->first_free);
+}
+
+//
+// Entity store
+//
+#define ENTITY_STORE_INITIAL_CAPACITY   1024
+#define ENTITY_NONE                     0xffffffff
+
 inline b32
-is_same_chunk(Chunk *chunk, Chunk_Position pos)
+is_mover(Entity_Type type)
 {
-    TIMED_FUNCTION();
-    b32 result = (chunk->x == pos.x &&
-                  chunk->y == pos.y &&
-                  chunk->z == pos.z);
+    b32 result = (type == Entity_Type::XBOT ||
+                  type == Entity_Type::LIGHT);
+    return result;
+}
+
+// a column of capacity, with the first count of the old one copied in.
+// NOTE: plus a cache line, so that columns with the same element don't sit a
+// power of two apart. Those would alias in the cache when a kernel streams
+// through a dozen of them at once.
+internal void *
+grow_column(Memory_Arena *arena, void *old_column, size_t size, u32 count, u32 capacity)
+{
+    void *result = push_size(arena, size * capacity + ARENA_CACHE_LINE, ARENA_CACHE_LINE);
+    if (count)
+    {
+        copy_memory(result, old_column, size * count);
+    }
+    return result;
+}
+
+#define GROW_ENTITY_COLUMN(STORE, COLUMN, COUNT, CAPACITY) \
+    *(void **)&(STORE)->COLUMN = grow_column((STORE)->arena, (STORE)->COLUMN, sizeof((STORE)->COLUMN[0]), COUNT, CAPACITY)
+#define GROW_ENTITY_SPLIT_COLUMN(STORE, COLUMN, COUNT, CAPACITY) \
+    GROW_ENTITY_COLUMN(STORE, COLUMN.x, COUNT, CAPACITY); \
+    GROW_ENTITY_COLUMN(STORE, COLUMN.y, COUNT, CAPACITY); \
+    GROW_ENTITY_COLUMN(STORE, COLUMN.z, COUNT, CAPACITY)
+
+inline v3
+get_split(Split_v3 column, u32 idx)
+{
+    v3 result = {column.x[idx], column.y[idx], column.z[idx]};
+    return result;
+}
+
+inline v3i
+get_split(Split_v3i column, u32 idx)
+{
+    v3i result = {column.x[idx], column.y[idx], column.z[idx]};
+    return result;
+}
+
+inline void
+set_split(Split_v3 column, u32 idx, v3 value)
+{
+    column.x[idx] = value.x;
+    column.y[idx] = value.y;
+    column.z[idx] = value.z;
+}
+
+inline void
+set_split(Split_v3i column, u32 idx, v3i value)
+{
+    column.x[idx] = value.x;
+    column.y[idx] = value.y;
+    column.z[idx] = value.z;
+}
+
+inline Chunk_Position
+get_chunk_pos(Entity_Store *store, u32 idx)
+{
+    Chunk_Position result = {};
+    result.xyz      = get_split(store->chunk_coord, idx);
+    result.offset   = get_split(store->chunk_offset, idx);
+    return result;
+}
+
+inline void
+set_chunk_pos(Entity_Store *store, u32 idx, Chunk_Position chunk_pos)
+{
+    set_split(store->chunk_coord, idx, chunk_pos.xyz);
+    set_split(store->chunk_offset, idx, chunk_pos.offset);
+}
+
+internal void
+grow_entity_store(Entity_Store *store, u32 capacity)
+{
+    Assert(capacity >= store->count);
+    u32 count = store->count;
+    GROW_ENTITY_COLUMN(store, type,                     count, capacity);
+    GROW_ENTITY_COLUMN(store, flags,                    count, capacity);
+    GROW_ENTITY_COLUMN(store, slot,                     count, capacity);
+    GROW_ENTITY_COLUMN(store, chunk,                    count, capacity);
+    GROW_ENTITY_SPLIT_COLUMN(store, chunk_coord,            count, capacity);
+    GROW_ENTITY_SPLIT_COLUMN(store, chunk_offset,           count, capacity);
+    GROW_ENTITY_SPLIT_COLUMN(store, world_translation,      count, capacity);
+    GROW_ENTITY_COLUMN(store, world_rotation,           count, capacity);
+    GROW_ENTITY_COLUMN(store, world_scaling,            count, capacity);
+    GROW_ENTITY_SPLIT_COLUMN(store, prev_world_translation, count, capacity);
+    GROW_ENTITY_COLUMN(store, prev_world_rotation,      count, capacity);
+    GROW_ENTITY_SPLIT_COLUMN(store, velocity,               count, capacity);
+    GROW_ENTITY_SPLIT_COLUMN(store, accel,                  count, capacity);
+    GROW_ENTITY_COLUMN(store, u,                        count, capacity);
+    GROW_ENTITY_COLUMN(store, animation_channel,        count, capacity);
+    GROW_ENTITY_COLUMN(store, animation_transform,      count, capacity);
+
+    // NOTE: never more slots than there have been entities at once.
+    GROW_ENTITY_COLUMN(store, slot_dense_idx,           store->slot_count, capacity);
+    GROW_ENTITY_COLUMN(store, slot_generation,          store->slot_count, capacity);
+
+    store->capacity = capacity;
+}
+
+internal void
+init_entity_store(Entity_Store *store, Memory_Arena *arena, u32 capacity)
+{
+    zero_struct(*store);
+    store->arena            = arena;
+    store->first_free_slot  = ENTITY_NONE;
+    grow_entity_store(store, capacity);
+}
+
+// NOTE: the entity at from is at to after, whatever was at to is gone.
+internal void
+move_entity(Entity_Store *store, u32 from, u32 to)
+{
+    store->type[to]                     = store->type[from];
+    store->flags[to]                    = store->flags[from];
+    store->slot[to]                     = store->slot[from];
+    store->chunk[to]                    = store->chunk[from];
+    set_split(store->chunk_coord, to, get_split(store->chunk_coord, from));
+    set_split(store->chunk_offset, to, get_split(store->chunk_offset, from));
+    set_split(store->world_translation, to, get_split(store->world_translation, from));
+    store->world_rotation[to]           = store->world_rotation[from];
+    store->world_scaling[to]            = store->world_scaling[from];
+    set_split(store->prev_world_translation, to, get_split(store->prev_world_translation, from));
+    store->prev_world_rotation[to]      = store->prev_world_rotation[from];
+    set_split(store->velocity, to, get_split(store->velocity, from));
+    set_split(store->accel, to, get_split(store->accel, from));
+    store->u[to]                        = store->u[from];
+    store->animation_channel[to]        = store->animation_channel[from];
+    store->animation_transform[to]      = store->animation_transform[from];
+
+    store->slot_dense_idx[store->slot[to]] = to;
+}
+
+// NOTE: the new entity's dense index, everything but its type zeroed. It
+// isn't in any chunk, push_entity does that.
+internal u32
+add_entity(Entity_Store *store, Entity_Type type)
+{
+    if (store->count == store->capacity)
+    {
+        grow_entity_store(store, 2 * store->capacity);
+    }
+
+    // movers stay in front, the first of the rest goes to the back.
+    u32 result = store->count++;
+    if (is_mover(type))
+    {
+        if (result != store->mover_count)
+        {
+            move_entity(store, store->mover_count, result);
+        }
+        result = store->mover_count++;
+    }
+
+    u32 slot = store->first_free_slot;
+    if (slot != ENTITY_NONE)
+    {
+        store->first_free_slot = store->slot_dense_idx[slot];
+    }
+    else
+    {
+        // NOTE: generations start at 1, so that a zeroed handle is none.
+        slot = store->slot_count++;
+        store->slot_generation[slot] = 1;
+    }
+    store->slot_dense_idx[slot] = result;
+
+    store->type[result]                     = type;
+    store->flags[result]                    = 0;
+    store->slot[result]                     = slot;
+    store->chunk[result]                    = 0;
+    set_chunk_pos(store, result, {});
+    set_split(store->world_translation, result, {});
+    store->world_rotation[result]           = {};
+    store->world_scaling[result]            = {};
+    set_split(store->prev_world_translation, result, {});
+    store->prev_world_rotation[result]      = {};
+    set_split(store->velocity, result, {});
+    set_split(store->accel, result, {});
+    store->u[result]                        = 0.0f;
+    store->animation_channel[result]        = {};
+    store->animation_transform[result]      = 0;
+
+    ++store->push_count;
     return result;
 }
 
+// NOTE: the last mover fills the hole, and the last entity the mover's.
+internal void
+remove_entity(Entity_Store *store, u32 idx)
+{
+    Assert(idx < store->count);
+    u32 slot = store->slot[idx];
+    ++store->slot_generation[slot];
+    store->slot_dense_idx[slot] = store->first_free_slot;
+    store->first_free_slot = slot;
+
+    if (idx < store->mover_count)
+    {
+        u32 last_mover = --store->mover_count;
+        if (idx != last_mover)
+        {
+            move_entity(store, last_mover, idx);
+        }
+        idx = last_mover;
+    }
+
+    u32 last = --store->count;
+    if (idx != last)
+    {
+        move_entity(store, last, idx);
+    }
+
+    ++store->despawn_count;
+}
+
+inline Entity_Handle
+get_entity_handle(Entity_Store *store, u32 idx)
+{
+    u32 slot = store->slot[idx];
+    Entity_Handle result = {slot, store->slot_generation[slot]};
+    return result;
+}
+
+// NOTE: the dense index, ENTITY_NONE if the entity is gone.
+inline u32
+get_entity(Entity_Store *store, Entity_Handle handle)
+{
+    u32 result = ENTITY_NONE;
+    if (handle.slot < store->slot_count &&
+        store->slot_generation[handle.slot] == handle.generation)
+    {
+        result = store->slot_dense_idx[handle.slot];
+    }
+    return result;
+}
+
+//
+// Chunk table
+//
+#define CHUNK_TABLE_INITIAL_CAPACITY    1024
+
+internal void
+init_chunk_table(Chunk_Table *table, Memory_Arena *arena, u32 capacity)
+{
+    Assert(capacity && (capacity & (capacity - 1)) == 0);
+    table->arena    = arena;
+    table->capacity = capacity;
+    table->count    = 0;
+    table->slots    = push_array(arena, Chunk_Table_Slot, capacity, ARENA_CACHE_LINE);
+    zero_array(capacity, table->slots);
+}
+
+// how far the slot at idx is from where its hash would have it.
+inline u32
+get_probe_distance(Chunk_Table *table, Chunk_Table_Slot *slot, u32 idx)
+{
+    u32 result = (idx - slot->hash) & (table->capacity - 1);
+    return result;
+}
+
+// NOTE: Robin Hood, takes the slot of anything that's closer to home, and
+// moves that one on instead.
+internal void
+place_chunk_slot(Chunk_Table *table, Chunk_Table_Slot incoming)
+{
+    u32 mask = table->capacity - 1;
+    u32 distance = 0;
+    for (u32 idx = incoming.hash & mask;
+         ;
+         idx = (idx + 1) & mask, ++distance)
+    {
+        Chunk_Table_Slot *slot = table->slots + idx;
+        if (!slot->chunk)
+        {
+            *slot = incoming;
+            break;
+        }
+
+        u32 slot_distance = get_probe_distance(table, slot, idx);
+        if (slot_distance < distance)
+        {
+            Chunk_Table_Slot displaced = *slot;
+            *slot = incoming;
+            incoming = displaced;
+            distance = slot_distance;
+        }
+    }
+    ++table->count;
+}
+
+// NOTE: the chunk mustn't be in there already.
+internal void
+insert_chunk(Chunk_Table *table, Chunk *chunk, u32 hash)
+{
+    if (4 * (table->count + 1) > 3 * table->capacity)
+    {
+        Chunk_Table_Slot *old_slots = table->slots;
+        u32 old_capacity = table->capacity;
+        init_chunk_table(table, table->arena, 2 * old_capacity);
+        for (u32 idx = 0;
+             idx < old_capacity;
+             ++idx)
+        {
+            if (old_slots[idx].chunk)
+            {
+                place_chunk_slot(table, old_slots[idx]);
+            }
+        }
+    }
+
+    Chunk_Table_Slot incoming = {chunk->x, chunk->y, chunk->z, hash, chunk};
+    place_chunk_slot(table, incoming);
+}
+
+// NOTE: shifts the slots after it back by one, up to an empty one or one
+// that's home, so no tombstones.
+internal void
+remove_chunk_slot(Chunk_Table *table, u32 idx)
+{
+    u32 mask = table->capacity - 1;
+    for (;;)
+    {
+        u32 next_idx = (idx + 1) & mask;
+        Chunk_Table_Slot *next = table->slots + next_idx;
+        if (!next->chunk || get_probe_distance(table, next, next_idx) == 0)
+        {
+            table->slots[idx] = {};
+            break;
+        }
+        table->slots[idx] = *next;
+        idx = next_idx;
+    }
+    --table->count;
+}
+
+// NOTE: 0 if there's no chunk there. Never makes one.
 internal Chunk *
-get_chunk(Memory_Arena *arena, Chunk_Hashmap *hashmap, Chunk_Position pos) 
+find_chunk(World *world, Chunk_Position pos)
 {
-    TIMED_FUNCTION();
     Chunk *result = 0;
 
-    u32 bucket = chunk_hash(hashmap, pos);
-    Chunk_List *list = hashmap->chunks + bucket;
-    for (Chunk *chunk = list->head;
-         chunk != 0;
-         chunk = chunk->next) 
+    Chunk_Table *table = &world->chunk_table;
+    u32 hash = chunk_hash(pos);
+    u32 mask = table->capacity - 1;
+    u32 distance = 0;
+    for (u32 idx = hash & mask;
+         ;
+         idx = (idx + 1) & mask, ++distance)
     {
-        if (is_same_chunk(chunk, pos)) 
+        Chunk_Table_Slot *slot = table->slots + idx;
+        if (!slot->chunk ||
+            get_probe_distance(table, slot, idx) < distance)
         {
-            result = chunk;
+            break;
+        }
+        if (slot->hash == hash &&
+            slot->x == pos.x && slot->y == pos.y && slot->z == pos.z)
+        {
+            result = slot->chunk;
             break;
         }
     }
 
+    return result;
+}
+
+// NOTE: entities on cache lines of their own, jobs animating neighbours
+// write both. Chunks are only touched serially.
+internal void
+init_world(World *world, Memory_Arena *arena, v3 chunk_dim)
+{
+    world->chunk_dim = chunk_dim;
+    init_entity_store(&world->entities, arena, ENTITY_STORE_INITIAL_CAPACITY);
+    init_pool(&world->chunk_pool.pool, arena, sizeof(Chunk), ARENA_DEFAULT_ALIGNMENT);
+    init_chunk_table(&world->chunk_table, arena, CHUNK_TABLE_INITIAL_CAPACITY);
+}
+
+// the chunk at pos, made if there isn't one.
+internal Chunk *
+get_chunk(World *world, Chunk_Position pos) 
+{
+    Chunk *result = find_chunk(world, pos);
     if (!result) 
     {
-        result          = push_struct(arena, Chunk);
-        result->next    = list->head;
-        result->x       = pos.x;
-        result->y       = pos.y;
-        result->z       = pos.z;
-        list->head      = result;
-        list->count++;
+        result      = alloc_chunk(&world->chunk_pool);
+        result->x   = pos.x;
+        result->y   = pos.y;
+        result->z   = pos.z;
+        insert_chunk(&world->chunk_table, result, chunk_hash(pos));
     }
 
     return result;
 }
 
+inline b32
+is_in_region(Chunk *chunk, Chunk_Position min_pos, Chunk_Position max_pos)
+{
+    b32 result = (chunk->x >= min_pos.x && chunk->x <= max_pos.x &&
+                  chunk->y >= min_pos.y && chunk->y <= max_pos.y &&
+                  chunk->z >= min_pos.z && chunk->z <= max_pos.z);
+    return result;
+}
+
+// NOTE: the sim region's chunks are kept even when empty, movers go in and
+// out of them all the time. Call it once nothing holds on to chunks from
+// outside the region.
+internal void
+release_empty_chunks(World *world, Chunk_Position min_pos, Chunk_Position max_pos)
+{
+    TIMED_FUNCTION();
+    if (!world->emptied_chunk_count &&
+        is_same_chunk(min_pos, world->released_min_pos) &&
+        is_same_chunk(max_pos, world->released_max_pos))
+    {
+        return;
+    }
+    world->emptied_chunk_count  = 0;
+    world->released_min_pos     = min_pos;
+    world->released_max_pos     = max_pos;
+
+    // NOTE: from an empty slot, so that nothing the removals shift back
+    // comes from a slot that's been looked at already.
+    Chunk_Table *table = &world->chunk_table;
+    u32 mask = table->capacity - 1;
+    u32 start = 0;
+    while (table->slots[start].chunk)
+    {
+        ++start;
+    }
+    for (u32 step = 0;
+         step < table->capacity;
+         )
+    {
+        u32 idx = (start + step) & mask;
+        Chunk *chunk = table->slots[idx].chunk;
+        if (chunk && !chunk->entity_count && !is_in_region(chunk, min_pos, max_pos))
+        {
+            // NOTE: the slot holds the next one now, look at it again.
+            remove_chunk_slot(table, idx);
+            free_chunk(&world->chunk_pool, chunk);
+        }
+        else
+        {
+            ++step;
+        }
+    }
+}
+
 inline void
-set_flag(Entity *entity, Entity_Flag flag) 
+set_flag(Entity_Store *store, u32 idx, Entity_Flag flag) 
 {
     TIMED_FUNCTION();
-    entity->flags |= flag;
+    store->flags[idx] |= flag;
 }
 
 inline b32
-is_set(Entity *entity, Entity_Flag flag) 
+is_set(Entity_Store *store, u32 idx, Entity_Flag flag) 
 {
     TIMED_FUNCTION();
-    b32 result = (entity->flags & flag);
+    b32 result = (store->flags[idx] & flag);
     return result;
 }
 
-internal Entity *
-push_entity(Memory_Arena *arena, Chunk_Hashmap *hashmap,
-            Entity_Type type, Chunk_Position chunk_pos, v3 chunk_dim) 
+internal Entity_Handle
+push_entity(World *world, Entity_Type type, Chunk_Position chunk_pos) 
 {
     TIMED_FUNCTION();
-    Entity *entity              = push_struct(arena, Entity);
-    entity->type                = type;
-    entity->chunk_pos           = chunk_pos;
-    entity->world_translation   = _v3_(chunk_pos.x * chunk_dim.x + chunk_pos.offset.x,
-                                       chunk_pos.y * chunk_dim.y + chunk_pos.offset.y,
-                                       chunk_pos.z * chunk_dim.z + chunk_pos.offset.z);
-    entity->world_rotation      = _qt_(1, 0, 0, 0);
-    entity->world_scaling       = _v3_(1, 1, 1);
+    Entity_Store *store = &world->entities;
+    v3 chunk_dim        = world->chunk_dim;
+    u32 idx             = add_entity(store, type);
+
+    v3 world_translation    = _v3_(chunk_pos.x * chunk_dim.x + chunk_pos.offset.x,
+                                   chunk_pos.y * chunk_dim.y + chunk_pos.offset.y,
+                                   chunk_pos.z * chunk_dim.z + chunk_pos.offset.z);
+    v3 world_scaling        = _v3_(1, 1, 1);
 
     switch (type) 
     {
         case Entity_Type::XBOT: 
         {
-            entity->u                   = 200.0f;
+            store->u[idx]           = 200.0f;
         } break;
 
         case Entity_Type::TILE: 
         {
-            entity->world_translation.y -= 0.25f;
-            entity->world_scaling       = _v3_(0.48f, 0.25f, 0.48f);
+            world_translation.y     -= 0.25f;
+            world_scaling           = _v3_(0.48f, 0.25f, 0.48f);
         } break;
 
         case Entity_Type::LIGHT:
         {
-            entity->world_scaling       = _v3_(0.25f, 0.25f, 0.25f);
+            world_scaling           = _v3_(0.25f, 0.25f, 0.25f);
         } break;
 
         case Entity_Type::RED_WALL:
         {
-            entity->world_scaling       = _v3_(0.2f, 8.0f, 5.0f);
+            world_scaling           = _v3_(0.2f, 8.0f, 5.0f);
         } break;
 
         case Entity_Type::GREEN_WALL:
         {
-            entity->world_scaling       = _v3_(1, 8.0f, 5.0f);
+            world_scaling           = _v3_(1, 8.0f, 5.0f);
         } break;
 
         INVALID_DEFAULT_CASE;
     }
 
-    Chunk *chunk = get_chunk(arena, hashmap, chunk_pos);
-    Entity_List *entities = &chunk->entities;
-    if (!entities->head) 
-    {
-        entities->head = entity;
-    } 
-    else 
-    {
-        entity->next = entities->head;
-        entities->head = entity;
-    }
+    set_chunk_pos(store, idx, chunk_pos);
+    set_split(store->world_translation, idx, world_translation);
+    store->world_rotation[idx]          = _qt_(1, 0, 0, 0);
+    store->world_scaling[idx]           = world_scaling;
+    set_split(store->prev_world_translation, idx, world_translation);
+    store->prev_world_rotation[idx]     = store->world_rotation[idx];
+
+    Chunk *chunk = get_chunk(world, chunk_pos);
+    ++chunk->entity_count;
+    store->chunk[idx] = chunk;
 
-    return entity;
+    Entity_Handle result = get_entity_handle(store, idx);
+    return result;
 }
 
 internal void
@@ -199,43 +637,36 @@ recalc_pos(Chunk_Position *pos, v3 chunk_dim)
 }
 
 internal void
-map_entity_to_chunk(Memory_Arena *arena, Chunk_Hashmap *hashmap, Entity *entity,
-                 Chunk_Position oldPos, Chunk_Position newPos) 
+remove_from_chunk(World *world, Chunk *chunk)
 {
-    TIMED_FUNCTION();
-    Chunk *oldChunk = get_chunk(arena, hashmap, oldPos);
-    Chunk *newChunk = get_chunk(arena, hashmap, newPos);
-    Entity_List *oldEntities = &oldChunk->entities;
-    Entity_List *newEntities = &newChunk->entities;
-
-    for (Entity *E = oldEntities->head;
-         E != 0;
-         E = E->next) 
-    { 
-        if (E == entity) 
-        {
-            oldEntities->head = E->next;
-            break;
-        }
-        else if (E->next == entity) 
-        { 
-            E->next = entity->next;
-            break; 
-        }
-    }
-
-    if (!newEntities->head) 
-    {
-        newEntities->head = entity;
-        entity->next = 0;
-    } 
-    else 
+    Assert(chunk->entity_count);
+    if (!--chunk->entity_count)
     {
-        entity->next = newEntities->head;
-        newEntities->head = entity;
+        ++world->emptied_chunk_count;
     }
 }
 
+internal void
+map_entity_to_chunk(World *world, u32 idx, Chunk_Position new_pos) 
+{
+    TIMED_FUNCTION();
+    Entity_Store *store = &world->entities;
+    Chunk *new_chunk = get_chunk(world, new_pos);
+    remove_from_chunk(world, store->chunk[idx]);
+    ++new_chunk->entity_count;
+    store->chunk[idx] = new_chunk;
+}
+
+// NOTE: moves other entities around, dense indices from before are stale.
+// Its chunk is left for release_empty_chunks.
+internal void
+despawn_entity(World *world, u32 idx)
+{
+    TIMED_FUNCTION();
+    remove_from_chunk(world, world->entities.chunk[idx]);
+    remove_entity(&world->entities, idx);
+}
+
 internal v3
 subtract(Chunk_Position A, Chunk_Position B, v3 chunk_dim) 
 {
@@ -250,94 +681,498 @@ subtract(Chunk_Position A, Chunk_Position B, v3 chunk_dim)
     return diff;
 }
 
+//
+// Integration
+//
+// NOTE: integrate_movers is one sim step over a range of movers, as wide as
+// the kernel goes; the SIMD kernels do the same float operations in the
+// same order as the scalar one, lane by lane, so they come out bit for bit
+// the same. Lanes whose chunk is out of the region are blended back to what
+// they were.
+//
+// Only integrates. A mover's chunk_pos moves on, but it stays counted in
+// its chunk until update_entities rebuckets it, so that movers can be
+// integrated in parallel. accel is left alone, it holds for every step of
+// a frame and the game clears it once the frame's steps are done.
+//
+enum Integrate_Kernel
+{
+    eIntegrate_Kernel_Widest,   // whatever the CPU has.
+    eIntegrate_Kernel_Scalar,
+    eIntegrate_Kernel_SSE,
+    eIntegrate_Kernel_AVX2,
+
+    eIntegrate_Kernel_Count
+};
+
+struct Integrate_Params
+{
+    f32                 dt;
+    f32                 gravity;    // down y.
+    f32                 drag;
+    f32                 max_speed;
+    v3                  chunk_dim;
+
+    // NOTE: only movers whose chunk is in the region move.
+    Chunk_Position      min_pos;
+    Chunk_Position      max_pos;
+
+    Integrate_Kernel    kernel;
+};
+
+inline Integrate_Kernel
+get_widest_integrate_kernel()
+{
+    Integrate_Kernel result = cpu_has_avx2() ? eIntegrate_Kernel_AVX2 : eIntegrate_Kernel_SSE;
+    return result;
+}
+
+// NOTE: recalc_pos for one axis.
+inline void
+renormalize_axis(f32 *offset, s32 *coord, f32 dim)
+{
+    f32 bound = dim * 0.5f;
+    while (*offset < -bound || *offset >= bound)
+    {
+        if (*offset < -bound)
+        {
+            *offset += dim;
+            --*coord;
+        }
+        else
+        {
+            *offset -= dim;
+            ++*coord;
+        }
+    }
+}
+
 internal void
-update_entity_position(Game_State *game_state, Entity *self, f32 dt)
+integrate_mover(Entity_Store *store, u32 idx, Integrate_Params *params)
 {
-    TIMED_FUNCTION();
+    s32 x = store->chunk_coord.x[idx];
+    s32 y = store->chunk_coord.y[idx];
+    s32 z = store->chunk_coord.z[idx];
+    Chunk_Position min_pos = params->min_pos;
+    Chunk_Position max_pos = params->max_pos;
+    if (x < min_pos.x || x > max_pos.x ||
+        y < min_pos.y || y > max_pos.y ||
+        z < min_pos.z || z > max_pos.z)
+    {
+        return;
+    }
 
-    Chunk_Position old_chunk_pos = self->chunk_pos;
-    Chunk_Position new_chunk_pos = self->chunk_pos;
+    f32 dt      = params->dt;
+    f32 drag    = params->drag;
+    v3 velocity = get_split(store->velocity, idx);
+    v3 accel    = get_split(store->accel, idx);
+    accel.y     -= params->gravity;
 
-    f32 damping_factor = 4.0f;
-    self->accel             -= damping_factor * self->velocity;
-    self->velocity          += dt * self->accel;
-    self->world_translation += dt * self->velocity;
-    self->accel             = v3{};
+    velocity.x  += dt * (accel.x - drag * velocity.x);
+    velocity.y  += dt * (accel.y - drag * velocity.y);
+    velocity.z  += dt * (accel.z - drag * velocity.z);
 
-    new_chunk_pos.offset    += dt * self->velocity;
-    recalc_pos(&new_chunk_pos, game_state->world->chunk_dim);
-   
-    self->chunk_pos = new_chunk_pos;
-    if (!is_same_chunk(old_chunk_pos, new_chunk_pos)) 
+    f32 speed_sq = velocity.x * velocity.x + velocity.y * velocity.y + velocity.z * velocity.z;
+    if (speed_sq > params->max_speed * params->max_speed)
     {
-        map_entity_to_chunk(&game_state->world_arena,
-                            &game_state->world->chunkHashmap,
-                            self, old_chunk_pos, new_chunk_pos);
+        f32 scale = params->max_speed / sqrt(speed_sq);
+        velocity.x *= scale;
+        velocity.y *= scale;
+        velocity.z *= scale;
     }
+
+    v3 step = v3{dt * velocity.x, dt * velocity.y, dt * velocity.z};
+    v3 world_translation = get_split(store->world_translation, idx);
+    set_split(store->prev_world_translation, idx, world_translation);
+    store->prev_world_rotation[idx] = store->world_rotation[idx];
+    set_split(store->world_translation, idx, v3{world_translation.x + step.x,
+                                                world_translation.y + step.y,
+                                                world_translation.z + step.z});
+    set_split(store->velocity, idx, velocity);
+
+    f32 *offset = 0;
+    offset = store->chunk_offset.x + idx;
+    *offset += step.x;
+    renormalize_axis(offset, store->chunk_coord.x + idx, params->chunk_dim.x);
+    offset = store->chunk_offset.y + idx;
+    *offset += step.y;
+    renormalize_axis(offset, store->chunk_coord.y + idx, params->chunk_dim.y);
+    offset = store->chunk_offset.z + idx;
+    *offset += step.z;
+    renormalize_axis(offset, store->chunk_coord.z + idx, params->chunk_dim.z);
 }
 
-// @TODO: this MUST be revamped.
 internal void
-update_entities(Game_State *game_state, f32 dt,
-                Chunk_Position sim_min, Chunk_Position sim_max) 
+integrate_movers_scalar(Entity_Store *store, u32 first, u32 one_past_last, Integrate_Params *params)
 {
-    TIMED_FUNCTION();
-    for (s32 Z = sim_min.z;
-         Z <= sim_max.z;
-         ++Z) 
+    for (u32 idx = first;
+         idx < one_past_last;
+         ++idx)
+    {
+        integrate_mover(store, idx, params);
+    }
+}
+
+// NOTE: renormalize_axis on 4 lanes, until none of the ones in the region
+// is out of bounds.
+inline void
+renormalize_axis_4x(__m128 *offset_4x, __m128i *coord_4x, f32 dim, __m128 in_region)
+{
+    f32 bound = dim * 0.5f;
+    __m128 dim_4x = _mm_set1_ps(dim);
+    __m128 lo_4x = _mm_set1_ps(-bound);
+    __m128 hi_4x = _mm_set1_ps(bound);
+    for (;;)
+    {
+        __m128 below = _mm_and_ps(_mm_cmplt_ps(*offset_4x, lo_4x), in_region);
+        __m128 above = _mm_and_ps(_mm_cmpge_ps(*offset_4x, hi_4x), in_region);
+        if (!_mm_movemask_ps(_mm_or_ps(below, above)))
+        {
+            break;
+        }
+        *offset_4x  = _mm_blendv_ps(*offset_4x, _mm_add_ps(*offset_4x, dim_4x), below);
+        *offset_4x  = _mm_blendv_ps(*offset_4x, _mm_sub_ps(*offset_4x, dim_4x), above);
+        // NOTE: a mask is -1 in the lanes it's set in.
+        *coord_4x   = _mm_add_epi32(*coord_4x, _mm_castps_si128(below));
+        *coord_4x   = _mm_sub_epi32(*coord_4x, _mm_castps_si128(above));
+    }
+}
+
+internal void
+integrate_movers_sse(Entity_Store *store, u32 first, u32 one_past_last, Integrate_Params *params)
+{
+    __m128 dt_4x            = _mm_set1_ps(params->dt);
+    __m128 gravity_4x       = _mm_set1_ps(params->gravity);
+    __m128 drag_4x          = _mm_set1_ps(params->drag);
+    __m128 max_speed_4x     = _mm_set1_ps(params->max_speed);
+    __m128 max_speed_sq_4x  = _mm_set1_ps(params->max_speed * params->max_speed);
+    __m128i min_x_4x        = _mm_set1_epi32(params->min_pos.x);
+    __m128i min_y_4x        = _mm_set1_epi32(params->min_pos.y);
+    __m128i min_z_4x        = _mm_set1_epi32(params->min_pos.z);
+    __m128i max_x_4x        = _mm_set1_epi32(params->max_pos.x);
+    __m128i max_y_4x        = _mm_set1_epi32(params->max_pos.y);
+    __m128i max_z_4x        = _mm_set1_epi32(params->max_pos.z);
+
+    u32 idx = first;
+    for (;
+         idx + 4 <= one_past_last;
+         idx += 4)
+    {
+        __m128i chunk_x = _mm_loadu_si128((__m128i *)(store->chunk_coord.x + idx));
+        __m128i chunk_y = _mm_loadu_si128((__m128i *)(store->chunk_coord.y + idx));
+        __m128i chunk_z = _mm_loadu_si128((__m128i *)(store->chunk_coord.z + idx));
+        __m128i outside = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(min_x_4x, chunk_x), _mm_cmpgt_epi32(chunk_x, max_x_4x)),
+                          _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(min_y_4x, chunk_y), _mm_cmpgt_epi32(chunk_y, max_y_4x)),
+                                       _mm_or_si128(_mm_cmpgt_epi32(min_z_4x, chunk_z), _mm_cmpgt_epi32(chunk_z, max_z_4x))));
+        __m128 in_region = _mm_castsi128_ps(_mm_xor_si128(outside, _mm_set1_epi32(-1)));
+        u32 in_mask = _mm_movemask_ps(in_region);
+        if (!in_mask)
+        {
+            continue;
+        }
+
+        __m128 velocity_x   = _mm_loadu_ps(store->velocity.x + idx);
+        __m128 velocity_y   = _mm_loadu_ps(store->velocity.y + idx);
+        __m128 velocity_z   = _mm_loadu_ps(store->velocity.z + idx);
+        __m128 accel_x      = _mm_loadu_ps(store->accel.x + idx);
+        __m128 accel_y      = _mm_sub_ps(_mm_loadu_ps(store->accel.y + idx), gravity_4x);
+        __m128 accel_z      = _mm_loadu_ps(store->accel.z + idx);
+
+        __m128 new_velocity_x = _mm_add_ps(velocity_x, _mm_mul_ps(dt_4x, _mm_sub_ps(accel_x, _mm_mul_ps(drag_4x, velocity_x))));
+        __m128 new_velocity_y = _mm_add_ps(velocity_y, _mm_mul_ps(dt_4x, _mm_sub_ps(accel_y, _mm_mul_ps(drag_4x, velocity_y))));
+        __m128 new_velocity_z = _mm_add_ps(velocity_z, _mm_mul_ps(dt_4x, _mm_sub_ps(accel_z, _mm_mul_ps(drag_4x, velocity_z))));
+
+        __m128 speed_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(new_velocity_x, new_velocity_x),
+                                                _mm_mul_ps(new_velocity_y, new_velocity_y)),
+                                     _mm_mul_ps(new_velocity_z, new_velocity_z));
+        __m128 too_fast = _mm_cmpgt_ps(speed_sq, max_speed_sq_4x);
+        if (_mm_movemask_ps(too_fast))
+        {
+            __m128 scale = _mm_div_ps(max_speed_4x, _mm_sqrt_ps(speed_sq));
+            new_velocity_x = _mm_blendv_ps(new_velocity_x, _mm_mul_ps(new_velocity_x, scale), too_fast);
+            new_velocity_y = _mm_blendv_ps(new_velocity_y, _mm_mul_ps(new_velocity_y, scale), too_fast);
+            new_velocity_z = _mm_blendv_ps(new_velocity_z, _mm_mul_ps(new_velocity_z, scale), too_fast);
+        }
+
+        __m128 step_x = _mm_mul_ps(dt_4x, new_velocity_x);
+        __m128 step_y = _mm_mul_ps(dt_4x, new_velocity_y);
+        __m128 step_z = _mm_mul_ps(dt_4x, new_velocity_z);
+
+        __m128 translation_x = _mm_loadu_ps(store->world_translation.x + idx);
+        __m128 translation_y = _mm_loadu_ps(store->world_translation.y + idx);
+        __m128 translation_z = _mm_loadu_ps(store->world_translation.z + idx);
+        __m128 offset_x = _mm_loadu_ps(store->chunk_offset.x + idx);
+        __m128 offset_y = _mm_loadu_ps(store->chunk_offset.y + idx);
+        __m128 offset_z = _mm_loadu_ps(store->chunk_offset.z + idx);
+        __m128 new_offset_x = _mm_add_ps(offset_x, step_x);
+        __m128 new_offset_y = _mm_add_ps(offset_y, step_y);
+        __m128 new_offset_z = _mm_add_ps(offset_z, step_z);
+        __m128i new_chunk_x = chunk_x;
+        __m128i new_chunk_y = chunk_y;
+        __m128i new_chunk_z = chunk_z;
+        renormalize_axis_4x(&new_offset_x, &new_chunk_x, params->chunk_dim.x, in_region);
+        renormalize_axis_4x(&new_offset_y, &new_chunk_y, params->chunk_dim.y, in_region);
+        renormalize_axis_4x(&new_offset_z, &new_chunk_z, params->chunk_dim.z, in_region);
+
+        // NOTE: lanes out of the region keep what they had.
+        __m128 prev_translation_x = _mm_loadu_ps(store->prev_world_translation.x + idx);
+        __m128 prev_translation_y = _mm_loadu_ps(store->prev_world_translation.y + idx);
+        __m128 prev_translation_z = _mm_loadu_ps(store->prev_world_translation.z + idx);
+        _mm_storeu_ps(store->prev_world_translation.x + idx, _mm_blendv_ps(prev_translation_x, translation_x, in_region));
+        _mm_storeu_ps(store->prev_world_translation.y + idx, _mm_blendv_ps(prev_translation_y, translation_y, in_region));
+        _mm_storeu_ps(store->prev_world_translation.z + idx, _mm_blendv_ps(prev_translation_z, translation_z, in_region));
+        _mm_storeu_ps(store->world_translation.x + idx, _mm_blendv_ps(translation_x, _mm_add_ps(translation_x, step_x), in_region));
+        _mm_storeu_ps(store->world_translation.y + idx, _mm_blendv_ps(translation_y, _mm_add_ps(translation_y, step_y), in_region));
+        _mm_storeu_ps(store->world_translation.z + idx, _mm_blendv_ps(translation_z, _mm_add_ps(translation_z, step_z), in_region));
+        _mm_storeu_ps(store->velocity.x + idx, _mm_blendv_ps(velocity_x, new_velocity_x, in_region));
+        _mm_storeu_ps(store->velocity.y + idx, _mm_blendv_ps(velocity_y, new_velocity_y, in_region));
+        _mm_storeu_ps(store->velocity.z + idx, _mm_blendv_ps(velocity_z, new_velocity_z, in_region));
+        _mm_storeu_ps(store->chunk_offset.x + idx, _mm_blendv_ps(offset_x, new_offset_x, in_region));
+        _mm_storeu_ps(store->chunk_offset.y + idx, _mm_blendv_ps(offset_y, new_offset_y, in_region));
+        _mm_storeu_ps(store->chunk_offset.z + idx, _mm_blendv_ps(offset_z, new_offset_z, in_region));
+        // NOTE: renormalize_axis_4x only moved the lanes in the region.
+        _mm_storeu_si128((__m128i *)(store->chunk_coord.x + idx), new_chunk_x);
+        _mm_storeu_si128((__m128i *)(store->chunk_coord.y + idx), new_chunk_y);
+        _mm_storeu_si128((__m128i *)(store->chunk_coord.z + idx), new_chunk_z);
+
+        for (u32 lane = 0;
+             lane < 4;
+             ++lane)
+        {
+            if (in_mask & (1 << lane))
+            {
+                store->prev_world_rotation[idx + lane] = store->world_rotation[idx + lane];
+            }
+        }
+    }
+
+    integrate_movers_scalar(store, idx, one_past_last, params);
+}
+
+TARGET_AVX2 inline void
+renormalize_axis_8x(__m256 *offset_8x, __m256i *coord_8x, f32 dim, __m256 in_region)
+{
+    f32 bound = dim * 0.5f;
+    __m256 dim_8x = _mm256_set1_ps(dim);
+    __m256 lo_8x = _mm256_set1_ps(-bound);
+    __m256 hi_8x = _mm256_set1_ps(bound);
+    for (;;)
+    {
+        __m256 below = _mm256_and_ps(_mm256_cmp_ps(*offset_8x, lo_8x, _CMP_LT_OQ), in_region);
+        __m256 above = _mm256_and_ps(_mm256_cmp_ps(*offset_8x, hi_8x, _CMP_GE_OQ), in_region);
+        if (!_mm256_movemask_ps(_mm256_or_ps(below, above)))
+        {
+            break;
+        }
+        *offset_8x  = _mm256_blendv_ps(*offset_8x, _mm256_add_ps(*offset_8x, dim_8x), below);
+        *offset_8x  = _mm256_blendv_ps(*offset_8x, _mm256_sub_ps(*offset_8x, dim_8x), above);
+        *coord_8x   = _mm256_add_epi32(*coord_8x, _mm256_castps_si256(below));
+        *coord_8x   = _mm256_sub_epi32(*coord_8x, _mm256_castps_si256(above));
+    }
+}
+
+// NOTE: integrate_movers_sse, 8 wide.
+TARGET_AVX2 internal void
+integrate_movers_avx2(Entity_Store *store, u32 first, u32 one_past_last, Integrate_Params *params)
+{
+    __m256 dt_8x            = _mm256_set1_ps(params->dt);
+    __m256 gravity_8x       = _mm256_set1_ps(params->gravity);
+    __m256 drag_8x          = _mm256_set1_ps(params->drag);
+    __m256 max_speed_8x     = _mm256_set1_ps(params->max_speed);
+    __m256 max_speed_sq_8x  = _mm256_set1_ps(params->max_speed * params->max_speed);
+    __m256i min_x_8x        = _mm256_set1_epi32(params->min_pos.x);
+    __m256i min_y_8x        = _mm256_set1_epi32(params->min_pos.y);
+    __m256i min_z_8x        = _mm256_set1_epi32(params->min_pos.z);
+    __m256i max_x_8x        = _mm256_set1_epi32(params->max_pos.x);
+    __m256i max_y_8x        = _mm256_set1_epi32(params->max_pos.y);
+    __m256i max_z_8x        = _mm256_set1_epi32(params->max_pos.z);
+
+    u32 idx = first;
+    for (;
+         idx + 8 <= one_past_last;
+         idx += 8)
     {
-        for (s32 Y = sim_min.y;
-             Y <= sim_max.y;
-             ++Y) 
+        __m256i chunk_x = _mm256_loadu_si256((__m256i *)(store->chunk_coord.x + idx));
+        __m256i chunk_y = _mm256_loadu_si256((__m256i *)(store->chunk_coord.y + idx));
+        __m256i chunk_z = _mm256_loadu_si256((__m256i *)(store->chunk_coord.z + idx));
+        __m256i outside = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(min_x_8x, chunk_x), _mm256_cmpgt_epi32(chunk_x, max_x_8x)),
+                          _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(min_y_8x, chunk_y), _mm256_cmpgt_epi32(chunk_y, max_y_8x)),
+                                          _mm256_or_si256(_mm256_cmpgt_epi32(min_z_8x, chunk_z), _mm256_cmpgt_epi32(chunk_z, max_z_8x))));
+        __m256 in_region = _mm256_castsi256_ps(_mm256_xor_si256(outside, _mm256_set1_epi32(-1)));
+        u32 in_mask = _mm256_movemask_ps(in_region);
+        if (!in_mask)
         {
-            for (s32 X = sim_min.x;
-                 X <= sim_max.x;
-                 ++X) 
+            continue;
+        }
+
+        __m256 velocity_x   = _mm256_loadu_ps(store->velocity.x + idx);
+        __m256 velocity_y   = _mm256_loadu_ps(store->velocity.y + idx);
+        __m256 velocity_z   = _mm256_loadu_ps(store->velocity.z + idx);
+        __m256 accel_x      = _mm256_loadu_ps(store->accel.x + idx);
+        __m256 accel_y      = _mm256_sub_ps(_mm256_loadu_ps(store->accel.y + idx), gravity_8x);
+        __m256 accel_z      = _mm256_loadu_ps(store->accel.z + idx);
+
+        __m256 new_velocity_x = _mm256_add_ps(velocity_x, _mm256_mul_ps(dt_8x, _mm256_sub_ps(accel_x, _mm256_mul_ps(drag_8x, velocity_x))));
+        __m256 new_velocity_y = _mm256_add_ps(velocity_y, _mm256_mul_ps(dt_8x, _mm256_sub_ps(accel_y, _mm256_mul_ps(drag_8x, velocity_y))));
+        __m256 new_velocity_z = _mm256_add_ps(velocity_z, _mm256_mul_ps(dt_8x, _mm256_sub_ps(accel_z, _mm256_mul_ps(drag_8x, velocity_z))));
+
+        __m256 speed_sq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(new_velocity_x, new_velocity_x),
+                                                      _mm256_mul_ps(new_velocity_y, new_velocity_y)),
+                                        _mm256_mul_ps(new_velocity_z, new_velocity_z));
+        __m256 too_fast = _mm256_cmp_ps(speed_sq, max_speed_sq_8x, _CMP_GT_OQ);
+        if (_mm256_movemask_ps(too_fast))
+        {
+            __m256 scale = _mm256_div_ps(max_speed_8x, _mm256_sqrt_ps(speed_sq));
+            new_velocity_x = _mm256_blendv_ps(new_velocity_x, _mm256_mul_ps(new_velocity_x, scale), too_fast);
+            new_velocity_y = _mm256_blendv_ps(new_velocity_y, _mm256_mul_ps(new_velocity_y, scale), too_fast);
+            new_velocity_z = _mm256_blendv_ps(new_velocity_z, _mm256_mul_ps(new_velocity_z, scale), too_fast);
+        }
+
+        __m256 step_x = _mm256_mul_ps(dt_8x, new_velocity_x);
+        __m256 step_y = _mm256_mul_ps(dt_8x, new_velocity_y);
+        __m256 step_z = _mm256_mul_ps(dt_8x, new_velocity_z);
+
+        __m256 translation_x = _mm256_loadu_ps(store->world_translation.x + idx);
+        __m256 translation_y = _mm256_loadu_ps(store->world_translation.y + idx);
+        __m256 translation_z = _mm256_loadu_ps(store->world_translation.z + idx);
+        __m256 offset_x = _mm256_loadu_ps(store->chunk_offset.x + idx);
+        __m256 offset_y = _mm256_loadu_ps(store->chunk_offset.y + idx);
+        __m256 offset_z = _mm256_loadu_ps(store->chunk_offset.z + idx);
+        __m256 new_offset_x = _mm256_add_ps(offset_x, step_x);
+        __m256 new_offset_y = _mm256_add_ps(offset_y, step_y);
+        __m256 new_offset_z = _mm256_add_ps(offset_z, step_z);
+        __m256i new_chunk_x = chunk_x;
+        __m256i new_chunk_y = chunk_y;
+        __m256i new_chunk_z = chunk_z;
+        renormalize_axis_8x(&new_offset_x, &new_chunk_x, params->chunk_dim.x, in_region);
+        renormalize_axis_8x(&new_offset_y, &new_chunk_y, params->chunk_dim.y, in_region);
+        renormalize_axis_8x(&new_offset_z, &new_chunk_z, params->chunk_dim.z, in_region);
+
+        __m256 prev_translation_x = _mm256_loadu_ps(store->prev_world_translation.x + idx);
+        __m256 prev_translation_y = _mm256_loadu_ps(store->prev_world_translation.y + idx);
+        __m256 prev_translation_z = _mm256_loadu_ps(store->prev_world_translation.z + idx);
+        _mm256_storeu_ps(store->prev_world_translation.x + idx, _mm256_blendv_ps(prev_translation_x, translation_x, in_region));
+        _mm256_storeu_ps(store->prev_world_translation.y + idx, _mm256_blendv_ps(prev_translation_y, translation_y, in_region));
+        _mm256_storeu_ps(store->prev_world_translation.z + idx, _mm256_blendv_ps(prev_translation_z, translation_z, in_region));
+        _mm256_storeu_ps(store->world_translation.x + idx, _mm256_blendv_ps(translation_x, _mm256_add_ps(translation_x, step_x), in_region));
+        _mm256_storeu_ps(store->world_translation.y + idx, _mm256_blendv_ps(translation_y, _mm256_add_ps(translation_y, step_y), in_region));
+        _mm256_storeu_ps(store->world_translation.z + idx, _mm256_blendv_ps(translation_z, _mm256_add_ps(translation_z, step_z), in_region));
+        _mm256_storeu_ps(store->velocity.x + idx, _mm256_blendv_ps(velocity_x, new_velocity_x, in_region));
+        _mm256_storeu_ps(store->velocity.y + idx, _mm256_blendv_ps(velocity_y, new_velocity_y, in_region));
+        _mm256_storeu_ps(store->velocity.z + idx, _mm256_blendv_ps(velocity_z, new_velocity_z, in_region));
+        _mm256_storeu_ps(store->chunk_offset.x + idx, _mm256_blendv_ps(offset_x, new_offset_x, in_region));
+        _mm256_storeu_ps(store->chunk_offset.y + idx, _mm256_blendv_ps(offset_y, new_offset_y, in_region));
+        _mm256_storeu_ps(store->chunk_offset.z + idx, _mm256_blendv_ps(offset_z, new_offset_z, in_region));
+        _mm256_storeu_si256((__m256i *)(store->chunk_coord.x + idx), new_chunk_x);
+        _mm256_storeu_si256((__m256i *)(store->chunk_coord.y + idx), new_chunk_y);
+        _mm256_storeu_si256((__m256i *)(store->chunk_coord.z + idx), new_chunk_z);
+
+        for (u32 lane = 0;
+             lane < 8;
+             ++lane)
+        {
+            if (in_mask & (1 << lane))
             {
-                Chunk *chunk = get_chunk(&game_state->world_arena,
-                                         &game_state->world->chunkHashmap,
-                                         Chunk_Position{X, Y, Z});
-                for (Entity *entity = chunk->entities.head;
-                     entity != 0;
-                     entity = entity->next) 
-                {
-                    switch (entity->type) 
-                    {
-                        case Entity_Type::XBOT: 
-                        {
-                            update_entity_position(game_state, entity, dt);
-                        } break;
-
-                        case Entity_Type::TILE: 
-                        {
-#if 0 // some fun.
-                            f32 theta = acos(entity->world_rotation.w);
-                            theta += dt;
-                            if (theta > pi32)
-                            {
-                                theta -= pi32;
-                            }
-                            entity->world_rotation = _qt_(cos(theta), 0, sin(theta), 0);
-#endif
-                        } break;
-
-                        case Entity_Type::LIGHT:
-                        {
-                            update_entity_position(game_state, entity, dt);
-                        } break;
-
-                        case Entity_Type::RED_WALL:
-                        {
-                        } break;
-
-                        case Entity_Type::GREEN_WALL:
-                        {
-                        } break;
-
-                        INVALID_DEFAULT_CASE
-                    }
-                }
+                store->prev_world_rotation[idx + lane] = store->world_rotation[idx + lane];
             }
         }
     }
+
+    integrate_movers_sse(store, idx, one_past_last, params);
+}
+
+internal void
+integrate_movers(Entity_Store *store, u32 first, u32 one_past_last, Integrate_Params *params)
+{
+    Integrate_Kernel kernel = params->kernel;
+    if (kernel == eIntegrate_Kernel_Widest ||
+        (kernel == eIntegrate_Kernel_AVX2 && !cpu_has_avx2()))
+    {
+        kernel = get_widest_integrate_kernel();
+    }
+
+    switch (kernel)
+    {
+        case eIntegrate_Kernel_Scalar:
+        {
+            integrate_movers_scalar(store, first, one_past_last, params);
+        } break;
+
+        case eIntegrate_Kernel_SSE:
+        {
+            integrate_movers_sse(store, first, one_past_last, params);
+        } break;
+
+        case eIntegrate_Kernel_AVX2:
+        {
+            integrate_movers_avx2(store, first, one_past_last, params);
+        } break;
+
+        INVALID_DEFAULT_CASE;
+    }
+}
+
+struct Update_Entities_Data
+{
+    Entity_Store        *store;
+    Integrate_Params    *params;
+};
+
+PARALLEL_FOR_CALLBACK(update_movers)
+{
+    Update_Entities_Data *update = (Update_Entities_Data *)data;
+    integrate_movers(update->store, first, one_past_last, update->params);
+}
+
+// the movers whose chunk is in the region, one sim step.
+internal void
+update_entities(Game_State *game_state, Parallel_Context *parallel, Integrate_Params *params)
+{
+    TIMED_FUNCTION();
+
+    World *world = game_state->world;
+    Entity_Store *store = &world->entities;
+
+    Update_Entities_Data update = {};
+    update.store    = store;
+    update.params   = params;
+
+    parallel_for(parallel, 0, store->mover_count, 0, update_movers, &update);
+
+    // move the ones that left their chunk, serially.
+    for (u32 idx = 0;
+         idx < store->mover_count;
+         ++idx)
+    {
+        Chunk *chunk = store->chunk[idx];
+        if (chunk->x != store->chunk_coord.x[idx] ||
+            chunk->y != store->chunk_coord.y[idx] ||
+            chunk->z != store->chunk_coord.z[idx])
+        {
+            map_entity_to_chunk(world, idx, get_chunk_pos(store, idx));
+        }
+    }
+}
+
+// NOTE: where to draw the entity, alpha of the way from its previous sim step
+// to the current one.
+inline v3
+get_render_translation(Entity_Store *store, u32 idx, f32 alpha)
+{
+    v3 result = lerp(get_split(store->prev_world_translation, idx), alpha,
+                     get_split(store->world_translation, idx));
+    return result;
+}
+
+internal m4x4
+get_render_transform(Entity_Store *store, u32 idx, f32 alpha)
+{
+    qt rotation = store->world_rotation[idx];
+    if (alpha < 1.0f)
+    {
+        rotation = slerp(store->prev_world_rotation[idx], alpha, store->world_rotation[idx]);
+    }
+    m4x4 result = trs_to_transform(get_render_translation(store, idx, alpha),
+                                   rotation, store->world_scaling[idx]);
+    return result;
 }
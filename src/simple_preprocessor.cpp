@@ -57,7 +57,7 @@ enum Token_Type
 struct Token
 {
     Token_Type type;
-    size_t text_length;
+    int text_length;
     char *text;
 };
 
@@ -184,7 +184,7 @@ get_token(Tokenizer *tokenizer)
                 ++tokenizer->at;
             }
 
-            token.text_length = tokenizer->at - token.text;
+            token.text_length = (int)(tokenizer->at - token.text);
             if (tokenizer->at[0] == '"')
             {
                 ++tokenizer->at;
@@ -204,7 +204,7 @@ get_token(Tokenizer *tokenizer)
                     ++tokenizer->at;
                 }
 
-                token.text_length = tokenizer->at - token.text;
+                token.text_length = (int)(tokenizer->at - token.text);
             }
 #if 0
             else if (is_number(c))
@@ -280,7 +280,7 @@ parse_member(Tokenizer *tokenizer, Token struct_type_token, Token member_type_to
             
             case eToken_Identifier:
             {
-                printf("    {eMeta_Type_%.*s, \"%.*s\", (u32)&(((%.*s *)0)->%.*s)},\n",
+                printf("    {eMeta_Type_%.*s, \"%.*s\", (u32)(uintptr_t)&(((%.*s *)0)->%.*s)},\n",
                        member_type_token.text_length, member_type_token.text,
                        token.text_length, token.text,
                        struct_type_token.text_length, struct_type_token.text,
@@ -364,7 +364,7 @@ main(int arg_count, char **args)
     };
 
     for (int file_idx = 0;
-         file_idx < (sizeof(file_names) / sizeof(file_names[0]));
+         file_idx < (int)(sizeof(file_names) / sizeof(file_names[0]));
          ++file_idx)
     {
         char *entire_file = read_entire_file_and_null_terminate(file_names[file_idx]);
@@ -0,0 +1,508 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+
+/*
+ * Snapshots of game memory for looped input playback, shared by the platform
+ * layers.
+ *
+ * Only pages that were ever written are saved, and a page of zeroes is saved
+ * as just its index. Restoring only rewrites the pages written since the
+ * slot was saved, so going back to the start of a loop costs as much as the
+ * loop touched, not the size of game memory.
+ *
+ * Which pages got written comes from the OS:
+ *   Win32  - GetWriteWatch, the memory must be allocated with MEM_WRITE_WATCH.
+ *   Linux  - soft-dirty bits in /proc/self/pagemap where the kernel has them,
+ *            otherwise the range is write-protected and the SIGSEGV handler
+ *            marks a page and lets it be written on its first write.
+ *
+ * Everything that writes to game memory must be done while saving or
+ * restoring. With write protection, that includes the kernel: a read() into
+ * a page not written since the last save or restore fails with EFAULT.
+ */
+
+#define SNAPSHOT_SLOT_COUNT     4
+#define SNAPSHOT_ZERO_PAGE      0xffffffff
+
+struct Snapshot_Slot
+{
+    b32         valid;
+
+    // NOTE: ascending, with where each page's bytes are in pages, or
+    // SNAPSHOT_ZERO_PAGE.
+    u32         page_count;
+    u32         *page_indices;
+    u32         *data_indices;
+    u8          *pages;
+    u32         data_page_count;
+    u32         page_capacity;
+
+    // pages written since this slot was saved.
+    u8          *changed;
+};
+
+enum Snapshot_Tracking
+{
+    eSnapshot_Tracking_Write_Watch,
+    eSnapshot_Tracking_Soft_Dirty,
+    eSnapshot_Tracking_Write_Protect,
+};
+
+struct Platform_Snapshots
+{
+    u8                  *memory;
+    u64                 size;
+    u64                 page_size;
+    u32                 total_page_count;
+
+    Snapshot_Tracking   tracking;
+    b32                 armed;
+
+    // NOTE: one byte per page, so the fault handler needs no atomics.
+    u8                  *dirty;
+    u8                  *touched;
+
+#if _WIN32
+    void                **watch_addresses;
+#else
+    int                 pagemap_fd;
+    u64                 *pagemap;
+    u8 volatile         *faulted;
+#endif
+
+    Snapshot_Slot       slots[SNAPSHOT_SLOT_COUNT];
+};
+
+#if _WIN32
+inline void *
+snapshot_alloc(u64 size)
+{
+    void *result = VirtualAlloc(0, (size_t)size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    return result;
+}
+
+inline void
+snapshot_free(void *memory, u64 size)
+{
+    VirtualFree(memory, 0, MEM_RELEASE);
+}
+
+internal void
+snapshot_init_tracking(Platform_Snapshots *snapshots)
+{
+    snapshots->tracking = eSnapshot_Tracking_Write_Watch;
+    snapshots->watch_addresses = (void **)snapshot_alloc(snapshots->total_page_count * sizeof(void *));
+}
+
+// NOTE: the watch has been on since the memory was allocated, so the first
+// call gets everything ever written.
+internal void
+snapshot_collect_dirty(Platform_Snapshots *snapshots)
+{
+    ULONG_PTR address_count = snapshots->total_page_count;
+    ULONG granularity;
+    GetWriteWatch(0, snapshots->memory, (SIZE_T)snapshots->size,
+                  snapshots->watch_addresses, &address_count, &granularity);
+    for (ULONG_PTR idx = 0;
+         idx < address_count;
+         ++idx)
+    {
+        u64 offset = (u64)((u8 *)snapshots->watch_addresses[idx] - snapshots->memory);
+        snapshots->dirty[offset / snapshots->page_size] = 1;
+    }
+}
+
+internal void
+snapshot_arm(Platform_Snapshots *snapshots)
+{
+    ResetWriteWatch(snapshots->memory, (SIZE_T)snapshots->size);
+    snapshots->armed = true;
+}
+#else
+global_var Platform_Snapshots *g_write_protected_snapshots;
+global_var struct sigaction g_previous_sigsegv_action;
+
+inline void *
+snapshot_alloc(u64 size)
+{
+    void *result = mmap(0, (size_t)size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return result;
+}
+
+inline void
+snapshot_free(void *memory, u64 size)
+{
+    munmap(memory, (size_t)size);
+}
+
+internal void
+snapshot_sigsegv_handler(int signal_number, siginfo_t *info, void *context)
+{
+    Platform_Snapshots *snapshots = g_write_protected_snapshots;
+    u8 *address = (u8 *)info->si_addr;
+    // NOTE: unarmed, a fault in there is a real one, e.g. memory that was
+    // never committed.
+    if (snapshots && snapshots->armed &&
+        address >= snapshots->memory && address < snapshots->memory + snapshots->size)
+    {
+        u64 page_idx = (u64)(address - snapshots->memory) / snapshots->page_size;
+        snapshots->faulted[page_idx] = 1;
+        mprotect(snapshots->memory + page_idx * snapshots->page_size, (size_t)snapshots->page_size,
+                 PROT_READ | PROT_WRITE);
+    }
+    else
+    {
+        // NOTE: not ours. Put the old handler back and fault again.
+        sigaction(SIGSEGV, &g_previous_sigsegv_action, 0);
+    }
+}
+
+inline void
+snapshot_clear_soft_dirty()
+{
+    int fd = open("/proc/self/clear_refs", O_WRONLY);
+    if (fd != -1)
+    {
+        write(fd, "4", 1);
+        close(fd);
+    }
+}
+
+inline u64
+snapshot_read_pagemap_entry(Platform_Snapshots *snapshots, u8 *address)
+{
+    u64 entry = 0;
+    pread(snapshots->pagemap_fd, &entry, sizeof(entry), (off_t)(((u64)address / snapshots->page_size) * sizeof(u64)));
+    return entry;
+}
+
+#define SNAPSHOT_PAGEMAP_SOFT_DIRTY (1ull << 55)
+#define SNAPSHOT_PAGEMAP_SWAPPED    (1ull << 62)
+#define SNAPSHOT_PAGEMAP_PRESENT    (1ull << 63)
+
+// NOTE: soft-dirty needs CONFIG_MEM_SOFT_DIRTY, which not every kernel has.
+// Writing a page and looking at its bit is the only way to tell.
+internal void
+snapshot_init_tracking(Platform_Snapshots *snapshots)
+{
+    snapshots->tracking = eSnapshot_Tracking_Write_Protect;
+    snapshots->pagemap_fd = open("/proc/self/pagemap", O_RDONLY);
+    if (snapshots->pagemap_fd != -1)
+    {
+        u8 *probe = (u8 *)snapshot_alloc(snapshots->page_size);
+        probe[0] = 1;
+        snapshot_clear_soft_dirty();
+        probe[0] = 2;
+        if (snapshot_read_pagemap_entry(snapshots, probe) & SNAPSHOT_PAGEMAP_SOFT_DIRTY)
+        {
+            snapshots->tracking = eSnapshot_Tracking_Soft_Dirty;
+            snapshots->pagemap = (u64 *)snapshot_alloc(snapshots->total_page_count * sizeof(u64));
+        }
+        snapshot_free(probe, snapshots->page_size);
+    }
+
+    if (snapshots->tracking == eSnapshot_Tracking_Write_Protect)
+    {
+        snapshots->faulted = (u8 *)snapshot_alloc(snapshots->total_page_count);
+        g_write_protected_snapshots = snapshots;
+
+        struct sigaction action = {};
+        action.sa_sigaction = snapshot_sigsegv_handler;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGSEGV, &action, &g_previous_sigsegv_action);
+    }
+}
+
+// NOTE: the first time round, everything resident counts as written. From
+// then on it's what the tracking caught. With write protection this also
+// lifts it, so the writes of a restore don't fault.
+internal void
+snapshot_collect_dirty(Platform_Snapshots *snapshots)
+{
+    if (!snapshots->armed)
+    {
+        mincore(snapshots->memory, (size_t)snapshots->size, snapshots->dirty);
+        for (u32 page_idx = 0;
+             page_idx < snapshots->total_page_count;
+             ++page_idx)
+        {
+            snapshots->dirty[page_idx] &= 1;
+        }
+    }
+    else if (snapshots->tracking == eSnapshot_Tracking_Soft_Dirty)
+    {
+        u64 first_entry = (u64)snapshots->memory / snapshots->page_size;
+        pread(snapshots->pagemap_fd, snapshots->pagemap, snapshots->total_page_count * sizeof(u64),
+              (off_t)(first_entry * sizeof(u64)));
+        for (u32 page_idx = 0;
+             page_idx < snapshots->total_page_count;
+             ++page_idx)
+        {
+            u64 entry = snapshots->pagemap[page_idx];
+            if ((entry & SNAPSHOT_PAGEMAP_SOFT_DIRTY) &&
+                (entry & (SNAPSHOT_PAGEMAP_PRESENT | SNAPSHOT_PAGEMAP_SWAPPED)))
+            {
+                snapshots->dirty[page_idx] = 1;
+            }
+        }
+    }
+    else
+    {
+        mprotect(snapshots->memory, (size_t)snapshots->size, PROT_READ | PROT_WRITE);
+        for (u32 page_idx = 0;
+             page_idx < snapshots->total_page_count;
+             ++page_idx)
+        {
+            snapshots->dirty[page_idx] |= snapshots->faulted[page_idx];
+        }
+    }
+}
+
+internal void
+snapshot_arm(Platform_Snapshots *snapshots)
+{
+    if (snapshots->tracking == eSnapshot_Tracking_Soft_Dirty)
+    {
+        snapshot_clear_soft_dirty();
+    }
+    else
+    {
+        memset((void *)snapshots->faulted, 0, snapshots->total_page_count);
+        mprotect(snapshots->memory, (size_t)snapshots->size, PROT_READ);
+    }
+    snapshots->armed = true;
+}
+#endif
+
+internal void
+snapshots_init(Platform_Snapshots *snapshots, void *memory, u64 size, u64 page_size)
+{
+    *snapshots = {};
+    snapshots->memory           = (u8 *)memory;
+    snapshots->size             = size;
+    snapshots->page_size        = page_size;
+    snapshots->total_page_count = (u32)((size + page_size - 1) / page_size);
+    snapshots->dirty            = (u8 *)snapshot_alloc(snapshots->total_page_count);
+    snapshots->touched          = (u8 *)snapshot_alloc(snapshots->total_page_count);
+
+    snapshot_init_tracking(snapshots);
+}
+
+// folds what got written since the last call into every slot.
+internal void
+snapshot_update_changed(Platform_Snapshots *snapshots)
+{
+    memset(snapshots->dirty, 0, snapshots->total_page_count);
+    snapshot_collect_dirty(snapshots);
+
+    for (u32 page_idx = 0;
+         page_idx < snapshots->total_page_count;
+         ++page_idx)
+    {
+        snapshots->touched[page_idx] |= snapshots->dirty[page_idx];
+    }
+
+    for (u32 slot_idx = 0;
+         slot_idx < SNAPSHOT_SLOT_COUNT;
+         ++slot_idx)
+    {
+        Snapshot_Slot *slot = snapshots->slots + slot_idx;
+        if (slot->valid)
+        {
+            for (u32 page_idx = 0;
+                 page_idx < snapshots->total_page_count;
+                 ++page_idx)
+            {
+                slot->changed[page_idx] |= snapshots->dirty[page_idx];
+            }
+        }
+    }
+}
+
+inline b32
+snapshot_page_is_zero(u8 *page, u64 page_size)
+{
+    u64 *at = (u64 *)page;
+    u64 *end = (u64 *)(page + page_size);
+    u64 bits = 0;
+    while (at < end)
+    {
+        bits |= *at++;
+    }
+    return (bits == 0);
+}
+
+// NOTE: nothing else may touch the memory while this runs.
+internal void
+snapshot_save(Platform_Snapshots *snapshots, u32 slot_idx)
+{
+    Assert(slot_idx < SNAPSHOT_SLOT_COUNT);
+    Snapshot_Slot *slot = snapshots->slots + slot_idx;
+
+    snapshot_update_changed(snapshots);
+
+    u32 touched_count = 0;
+    for (u32 page_idx = 0;
+         page_idx < snapshots->total_page_count;
+         ++page_idx)
+    {
+        touched_count += snapshots->touched[page_idx];
+    }
+
+    if (touched_count > slot->page_capacity)
+    {
+        if (slot->page_capacity)
+        {
+            snapshot_free(slot->page_indices, slot->page_capacity * sizeof(u32));
+            snapshot_free(slot->data_indices, slot->page_capacity * sizeof(u32));
+            snapshot_free(slot->pages, slot->page_capacity * snapshots->page_size);
+        }
+        // NOTE: room to grow, so saving again later doesn't reallocate.
+        slot->page_capacity = touched_count + touched_count / 4;
+        slot->page_indices  = (u32 *)snapshot_alloc(slot->page_capacity * sizeof(u32));
+        slot->data_indices  = (u32 *)snapshot_alloc(slot->page_capacity * sizeof(u32));
+        slot->pages         = (u8 *)snapshot_alloc(slot->page_capacity * snapshots->page_size);
+    }
+    if (!slot->changed)
+    {
+        slot->changed = (u8 *)snapshot_alloc(snapshots->total_page_count);
+    }
+
+    slot->page_count = 0;
+    slot->data_page_count = 0;
+    for (u32 page_idx = 0;
+         page_idx < snapshots->total_page_count;
+         ++page_idx)
+    {
+        if (snapshots->touched[page_idx])
+        {
+            u8 *page = snapshots->memory + page_idx * snapshots->page_size;
+            u32 data_idx = SNAPSHOT_ZERO_PAGE;
+            if (!snapshot_page_is_zero(page, snapshots->page_size))
+            {
+                data_idx = slot->data_page_count++;
+                memcpy(slot->pages + data_idx * snapshots->page_size, page, (size_t)snapshots->page_size);
+            }
+            slot->page_indices[slot->page_count] = page_idx;
+            slot->data_indices[slot->page_count] = data_idx;
+            ++slot->page_count;
+        }
+    }
+
+    memset(slot->changed, 0, snapshots->total_page_count);
+    slot->valid = true;
+
+    snapshot_arm(snapshots);
+}
+
+// returns the number of pages rewritten.
+// NOTE: nothing else may touch the memory while this runs.
+internal u32
+snapshot_restore(Platform_Snapshots *snapshots, u32 slot_idx)
+{
+    Assert(slot_idx < SNAPSHOT_SLOT_COUNT);
+    Snapshot_Slot *slot = snapshots->slots + slot_idx;
+    Assert(slot->valid);
+
+    snapshot_update_changed(snapshots);
+
+    u32 restored_count = 0;
+    u32 saved_idx = 0;
+    for (u32 page_idx = 0;
+         page_idx < snapshots->total_page_count;
+         ++page_idx)
+    {
+        if (slot->changed[page_idx])
+        {
+            // NOTE: both go up, so this never walks back.
+            while (saved_idx < slot->page_count &&
+                   slot->page_indices[saved_idx] < page_idx)
+            {
+                ++saved_idx;
+            }
+
+            u8 *page = snapshots->memory + page_idx * snapshots->page_size;
+            if (saved_idx < slot->page_count &&
+                slot->page_indices[saved_idx] == page_idx &&
+                slot->data_indices[saved_idx] != SNAPSHOT_ZERO_PAGE)
+            {
+                memcpy(page, slot->pages + slot->data_indices[saved_idx] * snapshots->page_size,
+                       (size_t)snapshots->page_size);
+            }
+            else
+            {
+                // NOTE: zero when saved, or never written back then.
+                memset(page, 0, (size_t)snapshots->page_size);
+            }
+            ++restored_count;
+        }
+    }
+
+    // the other slots now differ wherever this one was put back.
+    for (u32 other_idx = 0;
+         other_idx < SNAPSHOT_SLOT_COUNT;
+         ++other_idx)
+    {
+        Snapshot_Slot *other = snapshots->slots + other_idx;
+        if (other != slot && other->valid)
+        {
+            for (u32 page_idx = 0;
+                 page_idx < snapshots->total_page_count;
+                 ++page_idx)
+            {
+                other->changed[page_idx] |= slot->changed[page_idx];
+            }
+        }
+    }
+    memset(slot->changed, 0, snapshots->total_page_count);
+
+    snapshot_arm(snapshots);
+
+    return restored_count;
+}
+
+// what the slot takes in memory.
+inline u64
+snapshot_get_size(Platform_Snapshots *snapshots, u32 slot_idx)
+{
+    Snapshot_Slot *slot = snapshots->slots + slot_idx;
+    u64 result = (slot->data_page_count * snapshots->page_size +
+                  slot->page_count * 2 * sizeof(u32));
+    return result;
+}
+
+// NOTE: zeroes don't count, so pages that are written with zeroes later
+// don't change it. For checking a restore.
+internal u64
+snapshot_hash_memory(Platform_Snapshots *snapshots)
+{
+    u64 result = 0;
+    for (u32 page_idx = 0;
+         page_idx < snapshots->total_page_count;
+         ++page_idx)
+    {
+        if (snapshots->touched[page_idx])
+        {
+            u64 *at = (u64 *)(snapshots->memory + page_idx * snapshots->page_size);
+            u64 word_count = snapshots->page_size / sizeof(u64);
+            for (u64 word_idx = 0;
+                 word_idx < word_count;
+                 ++word_idx)
+            {
+                u64 word = at[word_idx];
+                if (word)
+                {
+                    u64 x = (word ^ (page_idx * word_count + word_idx)) * 0x9e3779b97f4a7c15ull;
+                    result += x ^ (x >> 29);
+                }
+            }
+        }
+    }
+    return result;
+}
@@ -16,6 +16,7 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "types.h"
 #include "game.h"
@@ -307,7 +308,7 @@ win32_load_gl_extensions()
 }
 
 
-internal void
+internal HGLRC
 win32_init_opengl(HDC dc) 
 {
     win32_load_gl_extensions();
@@ -376,6 +377,8 @@ win32_init_opengl(HDC dc)
         gl_init();
 
     }
+
+    return glrc;
 }
 
 internal void 
@@ -614,71 +617,6 @@ DEBUG_PLATFORM_WRITE_FILE(DebugPlatformWriteEntireFile)
     return result;
 }
 
-internal void
-win32_begin_recording_input(Win32_State *win32_state) 
-{
-    win32_state->is_recording = 1;
-    const char *filename = "inputNstate.rec";
-    win32_state->record_file = CreateFileA(filename, GENERIC_WRITE,
-                                           0, 0, CREATE_ALWAYS, 0, 0);
-    DWORD bytes_written;
-    DWORD bytes_to_write = (DWORD)win32_state->game_mem_total_cap;
-    Assert(bytes_to_write == win32_state->game_mem_total_cap);
-    WriteFile(win32_state->record_file, win32_state->game_memory, 
-              (DWORD)win32_state->game_mem_total_cap, &bytes_written, 0);
-}
-
-internal void
-win32_record_input(Win32_State *win32_state, Game_Input *input) 
-{
-    DWORD bytes_written;
-    WriteFile(win32_state->record_file, input, sizeof(*input),
-              &bytes_written, 0);
-}
-
-internal void
-win32_end_input_recording(Win32_State *win32_state) 
-{
-    CloseHandle(win32_state->record_file);
-    win32_state->is_recording = 0;
-}
-
-internal void
-win32_begin_input_playback(Win32_State *win32_state) 
-{
-    win32_state->is_playing = 1;
-
-    const char *filename = "inputNstate.rec";
-    win32_state->record_file = CreateFileA(filename, GENERIC_READ,
-                                           FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
-
-    DWORD bytes_read;
-    ReadFile(win32_state->record_file, win32_state->game_memory,
-             (DWORD)win32_state->game_mem_total_cap, &bytes_read, 0);
-}
-
-internal void
-win32_end_input_playback(Win32_State *win32_state) 
-{
-    CloseHandle(win32_state->record_file);
-    win32_state->is_playing = 0;
-}
-
-internal void
-win32_playback_input(Win32_State *win32_state, Game_Input *input) 
-{
-    DWORD bytes_read;
-    if (ReadFile(win32_state->record_file, input,
-                 sizeof(*input), &bytes_read, 0)) 
-    {
-        if (bytes_read == 0) 
-        {
-            win32_end_input_playback(win32_state);
-            win32_begin_input_playback(win32_state);
-        }
-    }
-}
-
 internal void
 win32_process_keyboard(Game_Key *game_key, b32 is_down) 
 {
@@ -822,112 +760,275 @@ win32_init_render_batch(Render_Batch *batch, size_t size)
 // Multi-Threading
 // 
 
-struct Platform_Work_QueueEntry 
+#include "work_queue.cpp"
+#include "job_system.cpp"
+#include "frame_pipeline.cpp"
+#include "win32_file_io.cpp"
+#include "snapshot.cpp"
+
+internal
+FRAME_PIPELINE_RENDER(win32_render_batch)
 {
-    Platform_Work_QueueCallback *Callback;
-    void *Data;
-};
+    Win32_Render_Thread *thread = (Win32_Render_Thread *)data;
 
-struct Platform_Work_Queue 
+    HDC dc = GetDC(thread->hwnd);
+    gl_render_batch(batch, batch->width, batch->height);
+    SwapBuffers(dc);
+    ReleaseDC(thread->hwnd, dc);
+}
+
+// NOTE: the GL context lives on this thread from here on.
+DWORD WINAPI
+win32_render_thread_proc(LPVOID param)
 {
-    u32 volatile CompletionGoal;
-    u32 volatile CompletionCount;
+    Win32_Render_Thread *thread = (Win32_Render_Thread *)param;
 
-    u32 volatile NextEntryToWrite;
-    u32 volatile NextEntryToRead;
-    HANDLE SemaphoreHandle;
+    HDC dc = GetDC(thread->hwnd);
+    wglMakeCurrent(dc, thread->glrc);
+    ReleaseDC(thread->hwnd, dc);
 
-    Platform_Work_QueueEntry Entries[256];
-};
+    frame_pipeline_render_loop(thread->pipeline);
+
+    return 0;
+}
+
+DWORD WINAPI
+ThreadProc(LPVOID lpParameter) 
+{
+    Platform_Work_Queue *Queue = (Platform_Work_Queue *)lpParameter;
+    work_queue_thread_loop(Queue);
+    return 0;
+}
 
 internal void
-Win32AddEntry(Platform_Work_Queue *Queue, Platform_Work_QueueCallback *Callback, void *Data) 
+win32_make_queue(Platform_Work_Queue *Queue, u32 ThreadCount) 
 {
-    // TODO: Switch to InterlockedCompareExchange eventually
-    // so that any thread can add?
-    u32 NewNextEntryToWrite = (Queue->NextEntryToWrite + 1) % array_count(Queue->Entries);
-    Assert(NewNextEntryToWrite != Queue->NextEntryToRead);
-    Platform_Work_QueueEntry *Entry = Queue->Entries + Queue->NextEntryToWrite;
-    Entry->Callback = Callback;    Entry->Data = Data;
-    ++Queue->CompletionGoal;
-    _WriteBarrier();
-    Queue->NextEntryToWrite = NewNextEntryToWrite;
-    ReleaseSemaphore(Queue->SemaphoreHandle, 1, 0);
+    work_queue_init(Queue, ThreadCount);
+
+    for(u32 ThreadIndex = 0;
+        ThreadIndex < ThreadCount;
+        ++ThreadIndex) 
+    {
+        DWORD ThreadID;
+        HANDLE ThreadHandle = CreateThread(0, 0, ThreadProc, Queue, 0, &ThreadID);
+        CloseHandle(ThreadHandle);
+    }
 }
 
-internal bool32
-Win32DoNextWorkQueueEntry(Platform_Work_Queue *Queue) 
+DWORD WINAPI
+win32_job_thread_proc(LPVOID param)
 {
-    b32 shouldSleep = false;
+    job_system_thread_loop((Job_Worker *)param);
+    return 0;
+}
 
-    u32 OriginalNextEntryToRead = Queue->NextEntryToRead;
-    u32 NewNextEntryToRead = (OriginalNextEntryToRead + 1) % array_count(Queue->Entries);
-    if (OriginalNextEntryToRead != Queue->NextEntryToWrite)
+internal Platform_Job_System *
+win32_make_job_system(u32 worker_count)
+{
+    Platform_Job_System *system = (Platform_Job_System *)VirtualAlloc(0, sizeof(Platform_Job_System),
+                                                                      MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    job_system_init(system, worker_count);
+
+    // worker 0 is this thread.
+    for (u32 worker_idx = 1;
+         worker_idx < system->worker_count;
+         ++worker_idx)
     {
-        u32 Index = InterlockedCompareExchange((LONG volatile *)&Queue->NextEntryToRead,
-                                               NewNextEntryToRead,
-                                               OriginalNextEntryToRead);
-        if(Index == OriginalNextEntryToRead)
-        {        
-            Platform_Work_QueueEntry Entry = Queue->Entries[Index];
-            Entry.Callback(Queue, Entry.Data);
-            InterlockedIncrement((LONG volatile *)&Queue->CompletionCount);
-        }
-    } else {
-        shouldSleep = true;
+        DWORD thread_id;
+        HANDLE thread_handle = CreateThread(0, 0, win32_job_thread_proc, system->workers + worker_idx, 0, &thread_id);
+        CloseHandle(thread_handle);
     }
 
-    return shouldSleep;
+    return system;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Looped Input Recording
+//
+// NOTE: the state at the start of a loop is a snapshot in memory, see
+// snapshot.cpp. Only the input goes to a file, one per slot.
+
+internal void
+win32_wait_for_game_memory(Win32_State *win32_state)
+{
+    work_queue_complete_all_work(win32_state->high_priority_queue);
+    work_queue_complete_all_work(win32_state->low_priority_queue);
+    job_system_complete_all_jobs(win32_state->job_system);
+    frame_pipeline_flush(win32_state->frame_pipeline);
+}
+
+internal HANDLE
+win32_open_input_file(u32 slot, b32 for_writing)
+{
+    char file_name[64];
+    _snprintf_s(file_name, sizeof(file_name), _TRUNCATE, "input%u.rec", slot);
+    HANDLE result = (for_writing ?
+                     CreateFileA(file_name, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0) :
+                     CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0));
+    return result;
 }
 
 internal void
-win32_complete_all_work(Platform_Work_Queue *Queue) 
+win32_begin_recording_input(Win32_State *win32_state, u32 slot) 
 {
-    while(Queue->CompletionGoal != Queue->CompletionCount) 
+    if (win32_state->large_pages)
     {
-        Win32DoNextWorkQueueEntry(Queue);
+        return;
     }
+    win32_wait_for_game_memory(win32_state);
 
-    Queue->CompletionGoal = 0;
-    Queue->CompletionCount = 0;
+    win32_state->is_recording = 1;
+    win32_state->loop_slot = slot;
+    snapshot_save(win32_state->snapshots, slot);
+    win32_state->record_file = win32_open_input_file(slot, true);
 }
 
-DWORD WINAPI
-ThreadProc(LPVOID lpParameter) 
+internal void
+win32_record_input(Win32_State *win32_state, Game_Input *input) 
 {
-    Platform_Work_Queue *Queue = (Platform_Work_Queue *)lpParameter;
+    DWORD bytes_written;
+    WriteFile(win32_state->record_file, input, sizeof(*input),
+              &bytes_written, 0);
+}
+
+internal void
+win32_end_input_recording(Win32_State *win32_state) 
+{
+    CloseHandle(win32_state->record_file);
+    win32_state->is_recording = 0;
+}
+
+internal void
+win32_begin_input_playback(Win32_State *win32_state, u32 slot) 
+{
+    win32_wait_for_game_memory(win32_state);
+
+    win32_state->is_playing = 1;
+    win32_state->loop_slot = slot;
+    snapshot_restore(win32_state->snapshots, slot);
+    win32_state->record_file = win32_open_input_file(slot, false);
+}
+
+internal void
+win32_end_input_playback(Win32_State *win32_state) 
+{
+    CloseHandle(win32_state->record_file);
+    win32_state->is_playing = 0;
+}
 
-    for(;;) 
+internal void
+win32_playback_input(Win32_State *win32_state, Game_Input *input) 
+{
+    DWORD bytes_read;
+    if (ReadFile(win32_state->record_file, input,
+                 sizeof(*input), &bytes_read, 0)) 
     {
-        if (Win32DoNextWorkQueueEntry(Queue)) 
+        if (bytes_read == 0) 
         {
-            WaitForSingleObjectEx(Queue->SemaphoreHandle, INFINITE, FALSE);
+            u32 slot = win32_state->loop_slot;
+            win32_end_input_playback(win32_state);
+            win32_begin_input_playback(win32_state, slot);
         }
     }
 }
 
-internal void
-win32_make_queue(Platform_Work_Queue *Queue, u32 ThreadCount) 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Large Pages
+//
+
+// returns 0 if the privilege isn't there or the pages aren't.
+internal void *
+win32_alloc_large_pages(void *base_address, u64 size)
+{
+    void *result = 0;
+
+    HANDLE token;
+    if (OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+    {
+        TOKEN_PRIVILEGES privileges = {};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        if (LookupPrivilegeValueA(0, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid))
+        {
+            // NOTE: succeeds even when nothing was granted, hence the
+            // GetLastError.
+            AdjustTokenPrivileges(token, FALSE, &privileges, 0, 0, 0);
+            if (GetLastError() == ERROR_SUCCESS)
+            {
+                SIZE_T large_page_size = GetLargePageMinimum();
+                if (large_page_size)
+                {
+                    u64 rounded_size = (size + large_page_size - 1) & ~((u64)large_page_size - 1);
+                    result = VirtualAlloc(base_address, (size_t)rounded_size,
+                                          MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+                }
+            }
+        }
+        CloseHandle(token);
+    }
+
+    return result;
+}
+
+// NOTE: large pages come committed, all of them.
+global_var b32 g_win32_game_memory_committed;
+
+PLATFORM_COMMIT_MEMORY(win32_commit_memory)
 {
-    Queue->CompletionGoal = 0;
-    Queue->CompletionCount = 0;
+    if (!g_win32_game_memory_committed)
+    {
+        VirtualAlloc(base, (SIZE_T)size, MEM_COMMIT, PAGE_READWRITE);
+    }
 
-    Queue->NextEntryToWrite = 0;
-    Queue->NextEntryToRead = 0;
+    if (prefault)
+    {
+        // NOTE: a read is enough to back a demand-zero page, and it doesn't
+        // show up in the write watch.
+        SYSTEM_INFO system_info;
+        GetSystemInfo(&system_info);
+        u64 page_mask = system_info.dwPageSize - 1;
+        u8 volatile *end = (u8 *)base + size;
+        for (u8 volatile *at = (u8 *)((u64)base & ~page_mask);
+             at < end;
+             at += system_info.dwPageSize)
+        {
+            (void)*at;
+        }
+    }
+}
 
-    u32 InitialCount = 0;
-    Queue->SemaphoreHandle = CreateSemaphoreEx(0,
-                                               InitialCount,
-                                               ThreadCount,
-                                               0, 0, SEMAPHORE_ALL_ACCESS);
-    for(u32 ThreadIndex = 0;
-        ThreadIndex < ThreadCount;
-        ++ThreadIndex) 
+internal Platform_Core_Topology
+win32_get_core_topology()
+{
+    Platform_Core_Topology result = {};
+
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION infos[256];
+    DWORD size = sizeof(infos);
+    if (GetLogicalProcessorInformation(infos, &size))
     {
-        DWORD ThreadID;
-        HANDLE ThreadHandle = CreateThread(0, 0, ThreadProc, Queue, 0, &ThreadID);
-        CloseHandle(ThreadHandle);
+        for (DWORD idx = 0;
+             idx < size / sizeof(infos[0]);
+             ++idx)
+        {
+            if (infos[idx].Relationship == RelationProcessorCore)
+            {
+                ++result.physical_core_count;
+                result.logical_core_count += (u32)__popcnt64(infos[idx].ProcessorMask);
+            }
+        }
+    }
+
+    if (!result.logical_core_count)
+    {
+        SYSTEM_INFO system_info;
+        GetSystemInfo(&system_info);
+        result.logical_core_count = system_info.dwNumberOfProcessors;
+        result.physical_core_count = system_info.dwNumberOfProcessors;
     }
+
+    return result;
 }
 
 DEBUG_PLATFORM_EXECUTE_SYSTEM_COMMAND(win32_execute_system_command)
@@ -1093,12 +1194,21 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd)
     //
     // Multi-Threading
     //
+    Platform_Core_Topology topology = win32_get_core_topology();
+
+    // leave a physical core to this thread.
+    u32 high_priority_thread_count = (topology.physical_core_count > 1) ? topology.physical_core_count - 1 : 1;
+
     Platform_Work_Queue high_priority_queue = {};
-    win32_make_queue(&high_priority_queue, 6);
+    win32_make_queue(&high_priority_queue, high_priority_thread_count);
 
     Platform_Work_Queue low_priority_queue = {};
     win32_make_queue(&low_priority_queue, 2);
 
+    // one job thread per logical core, this one included.
+    Platform_Job_System *job_system = win32_make_job_system(topology.logical_core_count);
+    win32_init_file_io(job_system);
+
     LARGE_INTEGER g_counter_hz_large_integer;
     QueryPerformanceFrequency(&g_counter_hz_large_integer);
     g_counter_hz = (f64)g_counter_hz_large_integer.QuadPart;
@@ -1131,7 +1241,9 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd)
     Win32_Window_Dimension dim = win32_get_window_dimension(hwnd);
     win32_resize_dib_section(&g_screen_buffer, dim.width, dim.height);
 
-    win32_init_opengl(GetDC(hwnd));
+    HGLRC glrc = win32_init_opengl(GetDC(hwnd));
+    // handed over to the render thread.
+    wglMakeCurrent(0, 0);
 
     win32_load_xinput();
 
@@ -1209,17 +1321,48 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd)
     u64 total_capacity = (game_memory.permanent_memory_size +
                           game_memory.transient_memory_size + 
                           game_memory.debug_storage_size);
-    win32_state.game_memory = VirtualAlloc(base_address, (size_t)total_capacity,
-                                           MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    // NOTE: -large-pages backs game memory with 2MB pages, if the user may
+    // lock memory (SeLockMemoryPrivilege). Large pages can't be write-watched,
+    // so input loops are off with them. Otherwise, the write watch is what
+    // keeps input loop snapshots small.
+    if (strstr(cmd, "-large-pages"))
+    {
+        win32_state.game_memory = win32_alloc_large_pages(base_address, total_capacity);
+        win32_state.large_pages = (win32_state.game_memory != 0);
+        g_win32_game_memory_committed = win32_state.large_pages;
+    }
+    // NOTE: only reserved, the arenas commit as they grow.
+    if (!win32_state.game_memory)
+    {
+        win32_state.game_memory = VirtualAlloc(base_address, (size_t)total_capacity,
+                                               MEM_RESERVE | MEM_WRITE_WATCH, PAGE_READWRITE);
+    }
     win32_state.game_mem_total_cap = total_capacity;
     game_memory.permanent_memory = win32_state.game_memory;
     game_memory.transient_memory = ((u8 *)(game_memory.permanent_memory) + game_memory.permanent_memory_size);
     game_memory.debug_storage = ((u8 *)(game_memory.transient_memory) + game_memory.transient_memory_size);
+    win32_commit_memory(game_memory.permanent_memory, sizeof(Game_State), false);
+    win32_commit_memory(game_memory.transient_memory, sizeof(Transient_State), false);
+    win32_commit_memory(game_memory.debug_storage, game_memory.debug_storage_size, false);
+
+    // NOTE: Windows reserves fiber stacks itself, so no memory to hand over.
+    job_system_init_fibers(job_system, 0, KB(256), 64);
 
     game_memory.high_priority_queue = &high_priority_queue;
     game_memory.low_priority_queue = &low_priority_queue;
-    game_memory.platform.platform_add_entry = Win32AddEntry;
-    game_memory.platform.platform_complete_all_work = win32_complete_all_work;
+    game_memory.platform.platform_add_entry = work_queue_add_entry;
+    game_memory.platform.platform_complete_all_work = work_queue_complete_all_work;
+    game_memory.platform.platform_add_job = job_system_add_job;
+    game_memory.platform.platform_add_fiber_job = job_system_add_fiber_job;
+    game_memory.platform.platform_wait_for_counter = job_system_wait_for_counter;
+    game_memory.platform.platform_get_job_thread_index = job_system_get_thread_index;
+    game_memory.platform.platform_open_file = win32_open_file;
+    game_memory.platform.platform_read_file = win32_read_file;
+    game_memory.platform.platform_close_file = win32_close_file;
+    game_memory.platform.platform_map_file = win32_map_file;
+    game_memory.platform.platform_unmap_file = win32_unmap_file;
+    game_memory.platform.platform_commit_memory = win32_commit_memory;
+    game_memory.job_thread_count = job_system->worker_count;
     game_memory.platform.debug_platform_read_file = win32_read_entire_file;
 
 #if __DEVELOPER
@@ -1229,7 +1372,39 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd)
     game_memory.platform.debug_platform_get_process_state = win32_get_process_state;
 #endif
 
-    win32_init_render_batch(&game_memory.render_batch, KB(4));
+    //
+    // Render Thread
+    //
+    Platform_Frame_Pipeline frame_pipeline = {};
+    Win32_Render_Thread render_thread = {};
+    render_thread.pipeline  = &frame_pipeline;
+    render_thread.hwnd      = hwnd;
+    render_thread.glrc      = glrc;
+    frame_pipeline_init(&frame_pipeline, RENDER_DEFAULT_FRAMES_IN_FLIGHT, win32_render_batch, &render_thread);
+    for (u32 idx = 0;
+         idx < frame_pipeline.frames_in_flight;
+         ++idx)
+    {
+        win32_init_render_batch(frame_pipeline.batches + idx, RENDER_BATCH_SIZE);
+    }
+    HANDLE render_thread_handle = CreateThread(0, 0, win32_render_thread_proc, &render_thread, 0, 0);
+    CloseHandle(render_thread_handle);
+
+    //
+    // Input Loop Snapshots
+    //
+    // NOTE: debug storage is left out, the profiler keeps its history.
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    Platform_Snapshots snapshots = {};
+    snapshots_init(&snapshots, game_memory.permanent_memory,
+                   game_memory.permanent_memory_size + game_memory.transient_memory_size,
+                   system_info.dwPageSize);
+    win32_state.snapshots           = &snapshots;
+    win32_state.high_priority_queue = &high_priority_queue;
+    win32_state.low_priority_queue  = &low_priority_queue;
+    win32_state.job_system          = job_system;
+    win32_state.frame_pipeline      = &frame_pipeline;
 
     Game_State *game_state = (Game_State *)game_memory.permanent_memory;
 
@@ -1310,8 +1485,13 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd)
             game_dll_time = win32_get_file_time(game_dll_abs_path);
             if (CompareFileTime(&game_dll_time_last, &game_dll_time) != 0) 
             {
-                win32_complete_all_work(&high_priority_queue);
-                win32_complete_all_work(&low_priority_queue);
+                // frames in flight may point into the old module, and the
+                // work queues only ever carry game callbacks. Platform jobs
+                // carry on through the reload.
+                frame_pipeline_flush(&frame_pipeline);
+                work_queue_complete_all_work(&high_priority_queue);
+                work_queue_complete_all_work(&low_priority_queue);
+                job_system_complete_game_module_jobs(job_system);
 
 #if __DEVELOPER
                 g_debug_table = &g_debug_table_;
@@ -1335,6 +1515,11 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd)
                     {
                         game.game_update = 0;
                     }
+
+                    // NOTE: the image's extent is in its own PE header.
+                    IMAGE_DOS_HEADER *dos_header = (IMAGE_DOS_HEADER *)game.dll;
+                    IMAGE_NT_HEADERS *nt_headers = (IMAGE_NT_HEADERS *)((u8 *)game.dll + dos_header->e_lfanew);
+                    job_system_set_game_module(job_system, game.dll, nt_headers->OptionalHeader.SizeOfImage);
                 } 
                 else 
                 {
@@ -1392,12 +1577,12 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd)
                                 {
                                     if (!win32_state.is_recording) 
                                     {
-                                        win32_begin_recording_input(&win32_state);
+                                        win32_begin_recording_input(&win32_state, 0);
                                     } 
                                     else 
                                     {
                                         win32_end_input_recording(&win32_state);
-                                        win32_begin_input_playback(&win32_state);
+                                        win32_begin_input_playback(&win32_state, 0);
                                     }
                                 }
                             } break;
@@ -1478,6 +1663,12 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd)
             input.dt_per_frame = (desired_mspf / 1000.0f);
 #endif
 
+            BEGIN_BLOCK(win32_render_wait);
+            u32 render_slot = frame_pipeline_begin_frame(&frame_pipeline);
+            game_memory.render_batch = frame_pipeline.batches + render_slot;
+            game_memory.render_slot = render_slot;
+            END_BLOCK(win32_render_wait);
+
             BEGIN_BLOCK(win32_game_update);
             if (game.game_update) 
             {
@@ -1499,12 +1690,11 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd)
             END_BLOCK(win32_debug_collation);
 #endif
 
+            // NOTE: rendered on the render thread, while we go on to the next frame.
             BEGIN_BLOCK(win32_render);
-            HDC dc = GetDC(hwnd);
-            gl_render_batch(&game_memory.render_batch, wd.width, wd.height);
-            SwapBuffers(dc);
-            // win32_update_screen(dc, wd.width, wd.height);
-            ReleaseDC(hwnd, dc);
+            game_memory.render_batch->width = wd.width;
+            game_memory.render_batch->height = wd.height;
+            frame_pipeline_submit(&frame_pipeline);
             END_BLOCK(win32_render);
 
             f32 actual_mspf = win32_get_elapsed_ms(last_counter, win32_get_wall_clock());
@@ -1542,6 +1732,8 @@ WinMain(HINSTANCE hinst, HINSTANCE deprecated, LPSTR cmd, int show_cmd)
             FRAME_MARKER(win32_get_seconds_elapsed(last_counter, end_counter));
             last_counter = end_counter;
         }
+
+        frame_pipeline_flush(&frame_pipeline);
     }
 
     return 0;
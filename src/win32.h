@@ -21,13 +21,34 @@ struct Win32_Window_Dimension
     int height;
 };
 
+struct Platform_Frame_Pipeline;
+struct Platform_Job_System;
+struct Platform_Snapshots;
+
 struct Win32_State 
 {
     HANDLE      record_file;
     b32         is_recording;
     b32         is_playing;
+    u32         loop_slot;
+    b32         large_pages;
     void        *game_memory;
     u64         game_mem_total_cap;
+
+    // NOTE: for waiting out everything that writes to game memory before
+    // a snapshot is taken or put back.
+    Platform_Snapshots      *snapshots;
+    Platform_Work_Queue     *high_priority_queue;
+    Platform_Work_Queue     *low_priority_queue;
+    Platform_Job_System     *job_system;
+    Platform_Frame_Pipeline *frame_pipeline;
+};
+
+struct Win32_Render_Thread
+{
+    Platform_Frame_Pipeline *pipeline;
+    HWND                    hwnd;
+    HGLRC                   glrc;
 };
 
 struct Win32_Game
@@ -0,0 +1,252 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+
+/*
+ * Asynchronous file reads for the Win32 platform, behind platform_read_file.
+ *
+ * Files are opened overlapped and tied to one completion port. A read is an
+ * overlapped ReadFile from any thread; a completion thread takes the packets
+ * off the port and the reads off their counters. Short reads are carried on
+ * from where they stopped, same as on Linux.
+ *
+ * At most WIN32_FILE_READ_MAX reads are in flight. Past that, issuing one
+ * waits for a slot.
+ *
+ * platform_map_file is the other way in, for loaders that parse in place.
+ */
+
+#define WIN32_FILE_READ_MAX     256
+// NOTE: ReadFile takes a DWORD, bigger reads are issued in pieces of this.
+#define WIN32_FILE_READ_CHUNK   GB(1)
+
+struct Win32_File_Read
+{
+    OVERLAPPED              overlapped; // NOTE: first, the port hands this back.
+    HANDLE                  handle;
+    u64                     offset;
+    u64                     size;
+    u8                      *dest;
+
+    Platform_File_Handle    *file;
+    Platform_Job_Counter    *counter;
+
+    Win32_File_Read         *next_free;
+};
+
+struct Win32_File_IO
+{
+    HANDLE                  port;
+    Platform_Job_System     *job_system;
+
+    CRITICAL_SECTION        lock;
+    Platform_Semaphore      free_semaphore;
+    Win32_File_Read         *first_free;
+    Win32_File_Read         reads[WIN32_FILE_READ_MAX];
+};
+
+global_var Win32_File_IO *g_win32_file_io;
+
+// NOTE: platform is the HANDLE, INVALID_HANDLE_VALUE if the open failed.
+PLATFORM_OPEN_FILE(win32_open_file)
+{
+    Platform_File_Handle result = {};
+    result.platform = (u64)INVALID_HANDLE_VALUE;
+
+    HANDLE handle = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                                FILE_FLAG_OVERLAPPED, 0);
+    if (handle != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER file_size;
+        if (GetFileSizeEx(handle, &file_size) &&
+            CreateIoCompletionPort(handle, g_win32_file_io->port, 0, 0))
+        {
+            result.no_errors    = true;
+            result.size         = (u64)file_size.QuadPart;
+            result.platform     = (u64)handle;
+        }
+        else
+        {
+            CloseHandle(handle);
+        }
+    }
+
+    return result;
+}
+
+PLATFORM_CLOSE_FILE(win32_close_file)
+{
+    if ((HANDLE)file->platform != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle((HANDLE)file->platform);
+    }
+    *file = {};
+    file->platform = (u64)INVALID_HANDLE_VALUE;
+}
+
+PLATFORM_MAP_FILE(win32_map_file)
+{
+    Entire_File result = {};
+
+    HANDLE handle = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+    if (handle != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER file_size;
+        if (GetFileSizeEx(handle, &file_size) && file_size.QuadPart > 0)
+        {
+            Assert(file_size.QuadPart <= 0xffffffff);
+            HANDLE mapping = CreateFileMappingA(handle, 0, PAGE_WRITECOPY, 0, 0, 0);
+            if (mapping)
+            {
+                void *memory = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+                if (memory)
+                {
+                    result.contents     = memory;
+                    result.content_size = (u32)file_size.QuadPart;
+                }
+                // NOTE: the view holds on to the mapping and the file by itself.
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(handle);
+    }
+
+    return result;
+}
+
+PLATFORM_UNMAP_FILE(win32_unmap_file)
+{
+    if (file->contents)
+    {
+        UnmapViewOfFile(file->contents);
+    }
+    *file = {};
+}
+
+internal void
+win32_file_read_finish(Win32_File_IO *io, Win32_File_Read *read, b32 succeeded)
+{
+    Platform_Job_Counter *counter = read->counter;
+    if (!succeeded)
+    {
+        read->file->no_errors = false;
+    }
+
+    EnterCriticalSection(&io->lock);
+    read->next_free = io->first_free;
+    io->first_free = read;
+    LeaveCriticalSection(&io->lock);
+    platform_release_semaphore(&io->free_semaphore);
+
+    job_counter_done(io->job_system, counter);
+}
+
+internal void
+win32_file_read_submit(Win32_File_IO *io, Win32_File_Read *read)
+{
+    read->overlapped = {};
+    read->overlapped.Offset     = (DWORD)(read->offset & 0xffffffff);
+    read->overlapped.OffsetHigh = (DWORD)(read->offset >> 32);
+
+    DWORD size32 = (DWORD)minimum(read->size, WIN32_FILE_READ_CHUNK);
+    if (!ReadFile(read->handle, read->dest, size32, 0, &read->overlapped) &&
+        GetLastError() != ERROR_IO_PENDING)
+    {
+        // NOTE: no packet is coming for this one.
+        win32_file_read_finish(io, read, false);
+    }
+}
+
+DWORD WINAPI
+win32_file_io_completion_proc(LPVOID param)
+{
+    Win32_File_IO *io = (Win32_File_IO *)param;
+
+    for (;;)
+    {
+        DWORD bytes_read = 0;
+        ULONG_PTR key;
+        OVERLAPPED *overlapped = 0;
+        BOOL ok = GetQueuedCompletionStatus(io->port, &bytes_read, &key, &overlapped, INFINITE);
+        if (!overlapped)
+        {
+            continue;
+        }
+
+        Win32_File_Read *read = (Win32_File_Read *)overlapped;
+        if (ok && bytes_read > 0 && bytes_read < read->size)
+        {
+            // short read, carry on from there.
+            read->offset    += bytes_read;
+            read->dest      += bytes_read;
+            read->size      -= bytes_read;
+            win32_file_read_submit(io, read);
+        }
+        else
+        {
+            win32_file_read_finish(io, read, (ok && bytes_read > 0));
+        }
+    }
+}
+
+PLATFORM_READ_FILE(win32_read_file)
+{
+    Win32_File_IO *io = g_win32_file_io;
+    if (!file->no_errors)
+    {
+        return;
+    }
+    Assert(offset + size <= file->size);
+
+    job_counter_add(counter, 1);
+    if (!size)
+    {
+        job_counter_done(io->job_system, counter);
+        return;
+    }
+
+    platform_wait_semaphore(&io->free_semaphore);
+    EnterCriticalSection(&io->lock);
+    Win32_File_Read *read = io->first_free;
+    io->first_free = read->next_free;
+    LeaveCriticalSection(&io->lock);
+
+    read->handle    = (HANDLE)file->platform;
+    read->offset    = offset;
+    read->size      = size;
+    read->dest      = (u8 *)dest;
+    read->file      = file;
+    read->counter   = counter;
+
+    win32_file_read_submit(io, read);
+}
+
+internal void
+win32_init_file_io(Platform_Job_System *job_system)
+{
+    Win32_File_IO *io = (Win32_File_IO *)VirtualAlloc(0, sizeof(Win32_File_IO),
+                                                      MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    io->job_system = job_system;
+    io->port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, 0, 0, 1);
+    InitializeCriticalSection(&io->lock);
+
+    platform_init_semaphore(&io->free_semaphore, WIN32_FILE_READ_MAX);
+    for (u32 idx = 0;
+         idx < WIN32_FILE_READ_MAX;
+         ++idx)
+    {
+        Win32_File_Read *read = io->reads + idx;
+        read->next_free = io->first_free;
+        io->first_free = read;
+        platform_release_semaphore(&io->free_semaphore);
+    }
+
+    HANDLE thread_handle = CreateThread(0, 0, win32_file_io_completion_proc, io, 0, 0);
+    CloseHandle(thread_handle);
+
+    g_win32_file_io = io;
+}
@@ -0,0 +1,256 @@
+/* ========================================================================
+   $File: $
+   $Date: $
+   $Revision: $
+   $Creator: Sung Woo Lee $
+   $Notice: (C) Copyright %s by Sung Woo Lee. All Rights Reserved. $
+   ======================================================================== */
+
+/*
+ * Bounded multi-producer/multi-consumer work queue shared by the platform
+ * layers. Any thread, workers included, may add entries.
+ *
+ * Every entry slot carries a sequence number (D. Vyukov's bounded queue).
+ * A slot is free for the producer claiming position P when its sequence is P,
+ * and holds a published entry for the consumer at position P when its
+ * sequence is P+1. Positions are claimed with a relaxed CAS, entries are
+ * published with a release store of the sequence and picked up with an
+ * acquire load. The sequence is what orders the payload, not the position.
+ *
+ * A full queue doesn't Assert. The producer runs queued work itself until a
+ * slot frees up, so a worker that spawns sub-jobs can never deadlock on it.
+ */
+
+#if _WIN32
+typedef HANDLE Platform_Semaphore;
+
+inline void
+platform_init_semaphore(Platform_Semaphore *semaphore, u32 max_count)
+{
+    *semaphore = CreateSemaphoreEx(0, 0, max_count, 0, 0, SEMAPHORE_ALL_ACCESS);
+}
+
+inline void
+platform_release_semaphore(Platform_Semaphore *semaphore)
+{
+    ReleaseSemaphore(*semaphore, 1, 0);
+}
+
+inline void
+platform_wait_semaphore(Platform_Semaphore *semaphore)
+{
+    WaitForSingleObjectEx(*semaphore, INFINITE, FALSE);
+}
+#else
+// NOTE: glibc semaphores are futex-backed; an uncontended post doesn't syscall.
+typedef sem_t Platform_Semaphore;
+
+inline void
+platform_init_semaphore(Platform_Semaphore *semaphore, u32 max_count)
+{
+    sem_init(semaphore, 0, 0);
+}
+
+inline void
+platform_release_semaphore(Platform_Semaphore *semaphore)
+{
+    sem_post(semaphore);
+}
+
+inline void
+platform_wait_semaphore(Platform_Semaphore *semaphore)
+{
+    while (sem_wait(semaphore) != 0)
+    {
+        // EINTR
+    }
+}
+#endif
+
+#define WORK_QUEUE_ENTRY_COUNT 256
+
+struct Platform_Work_Queue_Entry
+{
+    u32 volatile                sequence;
+    Platform_Work_QueueCallback *callback;
+    void                        *data;
+};
+
+struct Platform_Work_Queue
+{
+    // NOTE: producers, consumers and completion counters each get their own
+    // cache line so that they don't false-share.
+    alignas(64) u32 volatile    next_entry_to_write;
+    alignas(64) u32 volatile    next_entry_to_read;
+    alignas(64) u32 volatile    completion_goal;
+    alignas(64) u32 volatile    completion_count;
+
+    alignas(64) Platform_Semaphore semaphore;
+
+    Platform_Work_Queue_Entry   entries[WORK_QUEUE_ENTRY_COUNT];
+};
+
+internal b32
+work_queue_try_add(Platform_Work_Queue *queue, Platform_Work_QueueCallback *callback, void *data)
+{
+    u32 mask = WORK_QUEUE_ENTRY_COUNT - 1;
+    Platform_Work_Queue_Entry *entry = 0;
+
+    u32 pos = atomic_load_u32(&queue->next_entry_to_write, eMemory_Order_Relaxed);
+    for (;;)
+    {
+        entry = queue->entries + (pos & mask);
+        u32 sequence = atomic_load_u32(&entry->sequence, eMemory_Order_Acquire);
+        s32 diff = (s32)(sequence - pos);
+        if (diff == 0)
+        {
+            u32 original = atomic_compare_exchange_u32(&queue->next_entry_to_write, pos + 1, pos,
+                                                       eMemory_Order_Relaxed);
+            if (original == pos)
+            {
+                break;
+            }
+            pos = original;
+        }
+        else if (diff < 0)
+        {
+            // full.
+            return false;
+        }
+        else
+        {
+            pos = atomic_load_u32(&queue->next_entry_to_write, eMemory_Order_Relaxed);
+        }
+    }
+
+    entry->callback = callback;
+    entry->data     = data;
+    atomic_store_u32(&entry->sequence, pos + 1, eMemory_Order_Release);
+
+    return true;
+}
+
+internal b32
+work_queue_try_take(Platform_Work_Queue *queue, Platform_Work_Queue_Entry *result)
+{
+    u32 mask = WORK_QUEUE_ENTRY_COUNT - 1;
+    Platform_Work_Queue_Entry *entry = 0;
+
+    u32 pos = atomic_load_u32(&queue->next_entry_to_read, eMemory_Order_Relaxed);
+    for (;;)
+    {
+        entry = queue->entries + (pos & mask);
+        u32 sequence = atomic_load_u32(&entry->sequence, eMemory_Order_Acquire);
+        s32 diff = (s32)(sequence - (pos + 1));
+        if (diff == 0)
+        {
+            u32 original = atomic_compare_exchange_u32(&queue->next_entry_to_read, pos + 1, pos,
+                                                       eMemory_Order_Relaxed);
+            if (original == pos)
+            {
+                break;
+            }
+            pos = original;
+        }
+        else if (diff < 0)
+        {
+            // empty.
+            return false;
+        }
+        else
+        {
+            pos = atomic_load_u32(&queue->next_entry_to_read, eMemory_Order_Relaxed);
+        }
+    }
+
+    result->callback = entry->callback;
+    result->data     = entry->data;
+    // hand the slot back to the producer one lap ahead.
+    atomic_store_u32(&entry->sequence, pos + WORK_QUEUE_ENTRY_COUNT, eMemory_Order_Release);
+
+    return true;
+}
+
+// returns true if there was nothing to do.
+internal b32
+work_queue_do_next_entry(Platform_Work_Queue *queue)
+{
+    b32 should_sleep = true;
+
+    Platform_Work_Queue_Entry entry;
+    if (work_queue_try_take(queue, &entry))
+    {
+        entry.callback(queue, entry.data);
+        // NOTE: release, so that whoever sees the count sees the work's writes.
+        atomic_add_u32(&queue->completion_count, 1, eMemory_Order_Release);
+        should_sleep = false;
+    }
+
+    return should_sleep;
+}
+
+internal void
+work_queue_add_entry(Platform_Work_Queue *queue, Platform_Work_QueueCallback *callback, void *data)
+{
+    // NOTE: the goal goes up before the entry is visible, so that
+    // complete_all_work can never see count == goal with this entry pending.
+    // Relaxed is enough: the release on the entry's sequence publishes it.
+    atomic_add_u32(&queue->completion_goal, 1, eMemory_Order_Relaxed);
+
+    while (!work_queue_try_add(queue, callback, data))
+    {
+        // back-pressure.
+        if (work_queue_do_next_entry(queue))
+        {
+            _mm_pause();
+        }
+    }
+
+    platform_release_semaphore(&queue->semaphore);
+}
+
+// NOTE: counters are never reset, they just wrap around. Entries added while
+// this is running, including sub-jobs, are waited on too.
+internal void
+work_queue_complete_all_work(Platform_Work_Queue *queue)
+{
+    while (atomic_load_u32(&queue->completion_count, eMemory_Order_Acquire) !=
+           atomic_load_u32(&queue->completion_goal, eMemory_Order_Acquire))
+    {
+        if (work_queue_do_next_entry(queue))
+        {
+            _mm_pause();
+        }
+    }
+}
+
+internal void
+work_queue_init(Platform_Work_Queue *queue, u32 thread_count)
+{
+    queue->next_entry_to_write  = 0;
+    queue->next_entry_to_read   = 0;
+    queue->completion_goal      = 0;
+    queue->completion_count     = 0;
+
+    for (u32 idx = 0;
+         idx < WORK_QUEUE_ENTRY_COUNT;
+         ++idx)
+    {
+        queue->entries[idx].sequence = idx;
+    }
+
+    platform_init_semaphore(&queue->semaphore, thread_count);
+}
+
+// the worker loop, called by each platform's thread proc.
+internal void
+work_queue_thread_loop(Platform_Work_Queue *queue)
+{
+    for (;;)
+    {
+        if (work_queue_do_next_entry(queue))
+        {
+            platform_wait_semaphore(&queue->semaphore);
+        }
+    }
+}